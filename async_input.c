@@ -0,0 +1,824 @@
+#define _DEFAULT_SOURCE  // pread, syscall
+#include "async_input.h"
+#include "line_scan.h"
+#include "utf8_scan.h"
+#include "mem_budget.h"
+#include "compressed_io.h"
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef MULTILANG_HAVE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+// Asynchronous chunked input
+//
+// Every buffer carries the sequence number of the read it was submitted for;
+// completions may arrive in any order, but ml_async_poll() only ever hands
+// out the buffer whose sequence number is next_deliver. The two backends only
+// differ in how a read is started and how its completion is collected; the
+// bookkeeping in complete_read() is shared.
+
+enum { BUF_FREE, BUF_IN_FLIGHT, BUF_READY, BUF_HELD };
+
+typedef struct {
+    char *data;
+    size_t len;        // bytes read so far
+    size_t want;       // bytes requested
+    uint64_t offset;
+    uint64_t seq;
+    int state;
+} async_buffer;
+
+#ifdef MULTILANG_HAVE_IO_URING
+#define CANCEL_TAG UINT64_MAX  // user_data of IORING_OP_ASYNC_CANCEL requests
+
+typedef struct {
+    int fd;
+    unsigned *sq_tail;
+    unsigned *sq_mask;
+    unsigned *sq_array;
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned *cq_mask;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+    void *sq_map;
+    size_t sq_map_len;
+    void *cq_map;      // == sq_map with IORING_FEAT_SINGLE_MMAP
+    size_t cq_map_len;
+    size_t sqes_len;
+    unsigned unsubmitted;  // SQEs queued but not yet passed to io_uring_enter()
+} uring;
+#endif
+
+struct ml_async_reader {
+    int fd;
+    int seekable;
+    uint64_t file_size;     // seekable only: reads stop here
+    uint64_t next_offset;   // offset of the next read (streams: of the next completion)
+    uint64_t next_submit;   // sequence number of the next read
+    uint64_t next_deliver;  // sequence number poll() hands out next
+    size_t chunk_size;
+    unsigned depth;
+    unsigned in_flight;
+    async_buffer *buffers;
+    int eof;                // no further reads will be started
+    int error;              // errno of a failed read
+
+    int use_uring;
+#ifdef MULTILANG_HAVE_IO_URING
+    uring ring;
+#endif
+
+    // Thread backend: the helper serves IN_FLIGHT buffers in sequence order
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t work;    // a read was submitted, or stop
+    pthread_cond_t done;    // a read completed
+    uint64_t served;        // sequence number the helper reads next
+    int sync_ready;         // lock and conditions initialised
+    int thread_started;
+    int stop;               // set by destroy: no retries, helper exits
+};
+
+static async_buffer *buffer_with_seq(ml_async_reader *reader, uint64_t seq, int state) {
+    for (unsigned i = 0; i < reader->depth; i++) {
+        async_buffer *b = &reader->buffers[i];
+        if (b->state == state && b->seq == seq) {
+            return b;
+        }
+    }
+    return NULL;
+}
+
+// ============================================================================
+// IO_URING BACKEND (raw syscalls; liburing is not required)
+// ============================================================================
+
+#ifdef MULTILANG_HAVE_IO_URING
+static int uring_setup(uring *ring, unsigned entries) {
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    int fd = (int)syscall(__NR_io_uring_setup, entries, &p);
+    if (fd < 0) {
+        return -1;  // ENOSYS, or disabled by policy (EPERM)
+    }
+    if (!(p.features & IORING_FEAT_RW_CUR_POS)) {
+        close(fd);  // pre-5.6 kernel: no IORING_OP_READ with offset -1
+        return -1;
+    }
+
+    ring->fd = fd;
+    ring->sq_map_len = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    ring->cq_map_len = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    int single = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single && ring->cq_map_len > ring->sq_map_len) {
+        ring->sq_map_len = ring->cq_map_len;
+    }
+
+    ring->sq_map = mmap(NULL, ring->sq_map_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        fd, IORING_OFF_SQ_RING);
+    if (ring->sq_map == MAP_FAILED) {
+        close(fd);
+        return -1;
+    }
+    if (single) {
+        ring->cq_map = ring->sq_map;
+    } else {
+        ring->cq_map = mmap(NULL, ring->cq_map_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                            fd, IORING_OFF_CQ_RING);
+        if (ring->cq_map == MAP_FAILED) {
+            munmap(ring->sq_map, ring->sq_map_len);
+            close(fd);
+            return -1;
+        }
+    }
+    ring->sqes_len = p.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = mmap(NULL, ring->sqes_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      fd, IORING_OFF_SQES);
+    if (ring->sqes == MAP_FAILED) {
+        if (!single) {
+            munmap(ring->cq_map, ring->cq_map_len);
+        }
+        munmap(ring->sq_map, ring->sq_map_len);
+        close(fd);
+        return -1;
+    }
+
+    char *sq = ring->sq_map;
+    char *cq = ring->cq_map;
+    ring->sq_tail = (unsigned *)(sq + p.sq_off.tail);
+    ring->sq_mask = (unsigned *)(sq + p.sq_off.ring_mask);
+    ring->sq_array = (unsigned *)(sq + p.sq_off.array);
+    ring->cq_head = (unsigned *)(cq + p.cq_off.head);
+    ring->cq_tail = (unsigned *)(cq + p.cq_off.tail);
+    ring->cq_mask = (unsigned *)(cq + p.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+    ring->unsubmitted = 0;
+    return 0;
+}
+
+static void uring_teardown(uring *ring) {
+    munmap(ring->sqes, ring->sqes_len);
+    if (ring->cq_map != ring->sq_map) {
+        munmap(ring->cq_map, ring->cq_map_len);
+    }
+    munmap(ring->sq_map, ring->sq_map_len);
+    close(ring->fd);
+}
+
+static struct io_uring_sqe *uring_next_sqe(uring *ring) {
+    // Single producer: only this thread writes sq_tail
+    unsigned tail = *ring->sq_tail;
+    unsigned index = tail & *ring->sq_mask;
+    struct io_uring_sqe *sqe = &ring->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    ring->sq_array[index] = index;
+    return sqe;
+}
+
+static void uring_commit_sqe(uring *ring) {
+    __atomic_store_n(ring->sq_tail, *ring->sq_tail + 1, __ATOMIC_RELEASE);
+    ring->unsubmitted++;
+}
+
+/**
+ * Passes queued SQEs to the kernel, optionally waiting for one completion
+ */
+static int uring_enter(uring *ring, int wait) {
+    for (;;) {
+        long n = syscall(__NR_io_uring_enter, ring->fd, ring->unsubmitted, wait ? 1 : 0,
+                         wait ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+        if (n >= 0) {
+            ring->unsubmitted -= (unsigned)n;
+            return 0;
+        }
+        if (errno != EINTR) {
+            return -1;
+        }
+    }
+}
+
+static void uring_queue_read(ml_async_reader *reader, unsigned index) {
+    async_buffer *b = &reader->buffers[index];
+    struct io_uring_sqe *sqe = uring_next_sqe(&reader->ring);
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = reader->fd;
+    sqe->addr = (uint64_t)(uintptr_t)(b->data + b->len);
+    sqe->len = (unsigned)(b->want - b->len);
+    sqe->off = reader->seekable ? b->offset + b->len : (uint64_t)-1;  // -1: current position
+    sqe->user_data = index;
+    uring_commit_sqe(&reader->ring);
+}
+#endif
+
+// ============================================================================
+// SHARED COMPLETION HANDLING
+// ============================================================================
+
+static void start_read(ml_async_reader *reader, unsigned index);
+
+/**
+ * Records the result of one read into buffer `index`
+ *
+ * @param result Bytes read, or -errno
+ * @param at_eof Non-zero if the input ended during this read
+ * @return 1 if the buffer is done, 0 if the read was restarted
+ */
+static int complete_read(ml_async_reader *reader, unsigned index, long result, int at_eof) {
+    async_buffer *b = &reader->buffers[index];
+    if (result < 0) {
+        if ((result == -EINTR || result == -EAGAIN) && !reader->stop) {
+            start_read(reader, index);  // still in flight
+            return 0;
+        }
+        reader->error = (int)-result;
+        reader->eof = 1;
+        b->state = BUF_READY;  // delivered as an error, see ml_async_poll()
+        reader->in_flight--;
+        return 1;
+    }
+
+    b->len += (size_t)result;
+    if (result == 0 || at_eof) {
+        reader->eof = 1;
+    } else if (reader->seekable && b->len < b->want) {
+        start_read(reader, index);  // short read: fetch the rest of the chunk
+        return 0;
+    }
+    if (!reader->seekable) {
+        // Stream reads run one at a time, so they complete in order
+        b->offset = reader->next_offset;
+        reader->next_offset += b->len;
+    }
+    b->state = BUF_READY;
+    reader->in_flight--;
+    return 1;
+}
+
+#ifdef MULTILANG_HAVE_IO_URING
+static void uring_reap(ml_async_reader *reader) {
+    uring *ring = &reader->ring;
+    unsigned head = *ring->cq_head;
+    unsigned tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+    while (head != tail) {
+        struct io_uring_cqe *cqe = &ring->cqes[head & *ring->cq_mask];
+        if (cqe->user_data != CANCEL_TAG) {
+            (void)complete_read(reader, (unsigned)cqe->user_data, cqe->res, 0);
+        }
+        head++;
+    }
+    __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+}
+#endif
+
+// ============================================================================
+// THREAD BACKEND (fallback)
+// ============================================================================
+
+static void *helper_main(void *arg) {
+    ml_async_reader *reader = arg;
+    pthread_mutex_lock(&reader->lock);
+    for (;;) {
+        async_buffer *b;
+        while (!reader->stop &&
+               (b = buffer_with_seq(reader, reader->served, BUF_IN_FLIGHT)) == NULL) {
+            pthread_cond_wait(&reader->work, &reader->lock);
+        }
+        if (reader->stop) {
+            break;
+        }
+        unsigned index = (unsigned)(b - reader->buffers);
+        char *dst = b->data + b->len;
+        size_t want = b->want - b->len;
+        uint64_t offset = b->offset + b->len;
+        pthread_mutex_unlock(&reader->lock);
+
+        // Blocking reads happen outside the lock; regular files are read to
+        // the full chunk, pipes deliver whatever one read() returns
+        long total = 0;
+        int at_eof = 0;
+        while ((size_t)total < want) {
+            ssize_t n = reader->seekable ? pread(reader->fd, dst + total, want - (size_t)total,
+                                                 (off_t)(offset + (uint64_t)total))
+                                         : read(reader->fd, dst + total, want - (size_t)total);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    // O_NONBLOCK descriptor: wait for data instead of
+                    // retrying read() in a tight loop
+                    struct pollfd p = {.fd = reader->fd, .events = POLLIN};
+                    poll(&p, 1, -1);
+                    continue;
+                }
+                if (total == 0) {
+                    total = -errno;
+                }
+                break;
+            }
+            if (n == 0) {
+                at_eof = 1;
+                break;
+            }
+            total += n;
+            if (!reader->seekable) {
+                break;
+            }
+        }
+
+        pthread_mutex_lock(&reader->lock);
+        // A restarted read keeps its sequence number: the next pass resumes
+        // the same buffer where this one stopped
+        if (complete_read(reader, index, total, at_eof)) {
+            reader->served++;
+        }
+        pthread_cond_broadcast(&reader->done);
+    }
+    pthread_mutex_unlock(&reader->lock);
+    return NULL;
+}
+
+static void backend_lock(ml_async_reader *reader) {
+    if (!reader->use_uring) {
+        pthread_mutex_lock(&reader->lock);
+    }
+}
+
+static void backend_unlock(ml_async_reader *reader) {
+    if (!reader->use_uring) {
+        pthread_mutex_unlock(&reader->lock);
+    }
+}
+
+static void start_read(ml_async_reader *reader, unsigned index) {
+#ifdef MULTILANG_HAVE_IO_URING
+    if (reader->use_uring) {
+        uring_queue_read(reader, index);
+        return;
+    }
+#endif
+    (void)index;
+    pthread_cond_signal(&reader->work);  // the helper picks it up by sequence number
+}
+
+#define ML_ASYNC_MIN_CHUNK 4096u
+
+// ============================================================================
+// PUBLIC API
+// ============================================================================
+
+ml_async_reader *ml_async_reader_create(int fd, size_t chunk_size, unsigned depth) {
+    if (fd < 0) {
+        return NULL;
+    }
+    ml_async_reader *reader = calloc(1, sizeof(*reader));
+    if (reader == NULL) {
+        return NULL;
+    }
+    reader->fd = fd;
+    reader->chunk_size = chunk_size != 0 ? chunk_size : ML_ASYNC_DEFAULT_CHUNK;
+    reader->depth = depth != 0 ? depth : ML_ASYNC_DEFAULT_DEPTH;
+    if (reader->depth < 2) {
+        reader->depth = 2;
+    }
+    while (chunk_size == 0 && reader->chunk_size > ML_ASYNC_MIN_CHUNK &&
+           reader->chunk_size * reader->depth > ml_mem_available() / 2) {
+        reader->chunk_size /= 2;  // leave half of a small --max-mem budget to the other stages
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+        off_t pos = lseek(fd, 0, SEEK_CUR);
+        reader->seekable = pos >= 0;
+        reader->next_offset = pos >= 0 ? (uint64_t)pos : 0;
+        reader->file_size = (uint64_t)st.st_size;
+    }
+
+    reader->buffers = calloc(reader->depth, sizeof(async_buffer));
+    if (reader->buffers == NULL) {
+        free(reader);
+        return NULL;
+    }
+    for (unsigned i = 0; i < reader->depth; i++) {
+        reader->buffers[i].data = malloc(reader->chunk_size);
+        if (reader->buffers[i].data == NULL) {
+            ml_async_reader_destroy(reader);
+            return NULL;
+        }
+        ml_mem_charge(reader->chunk_size);
+    }
+
+#ifdef MULTILANG_HAVE_IO_URING
+    // Room for one read per buffer plus one cancel per buffer at teardown.
+    // MULTILANG_ASYNC=thread forces the fallback (for comparisons).
+    const char *forced = getenv("MULTILANG_ASYNC");
+    if (forced == NULL || strcmp(forced, "thread") != 0) {
+        reader->use_uring = uring_setup(&reader->ring, reader->depth * 2) == 0;
+    }
+#endif
+    if (!reader->use_uring) {
+        pthread_mutex_init(&reader->lock, NULL);
+        pthread_cond_init(&reader->work, NULL);
+        pthread_cond_init(&reader->done, NULL);
+        reader->sync_ready = 1;
+        if (pthread_create(&reader->thread, NULL, helper_main, reader) != 0) {
+            ml_async_reader_destroy(reader);
+            return NULL;
+        }
+        reader->thread_started = 1;
+    }
+    return reader;
+}
+
+/**
+ * Starts reads into free buffers (caller holds the backend lock)
+ */
+static int submit_locked(ml_async_reader *reader) {
+    int started = 0;
+    for (unsigned i = 0; i < reader->depth && !reader->eof; i++) {
+        async_buffer *b = &reader->buffers[i];
+        if (b->state != BUF_FREE) {
+            continue;
+        }
+        if (reader->seekable) {
+            if (reader->next_offset >= reader->file_size) {
+                reader->eof = 1;
+                break;
+            }
+            uint64_t left = reader->file_size - reader->next_offset;
+            b->want = left < reader->chunk_size ? (size_t)left : reader->chunk_size;
+            b->offset = reader->next_offset;
+            reader->next_offset += b->want;
+        } else {
+            if (reader->in_flight > 0) {
+                break;  // stream reads must complete in order: one at a time
+            }
+            b->want = reader->chunk_size;
+            b->offset = 0;  // known once the read completes
+        }
+        b->len = 0;
+        b->seq = reader->next_submit++;
+        b->state = BUF_IN_FLIGHT;
+        reader->in_flight++;
+        start_read(reader, i);
+        started++;
+    }
+
+#ifdef MULTILANG_HAVE_IO_URING
+    if (reader->use_uring && reader->ring.unsubmitted > 0 && uring_enter(&reader->ring, 0) != 0) {
+        reader->error = errno;
+        return -1;
+    }
+#endif
+    return started;
+}
+
+int ml_async_submit(ml_async_reader *reader) {
+    if (reader == NULL) {
+        return -1;
+    }
+    backend_lock(reader);
+    int started = submit_locked(reader);
+    backend_unlock(reader);
+    return started;
+}
+
+int ml_async_poll(ml_async_reader *reader, ml_async_chunk *chunk, int wait) {
+    if (reader == NULL || chunk == NULL) {
+        return ML_ASYNC_ERROR;
+    }
+    backend_lock(reader);
+    int result;
+    for (;;) {
+#ifdef MULTILANG_HAVE_IO_URING
+        if (reader->use_uring) {
+            uring_reap(reader);
+        }
+#endif
+        async_buffer *b = buffer_with_seq(reader, reader->next_deliver, BUF_READY);
+        if (b != NULL) {
+            if (reader->error != 0 && b->len == 0) {
+                result = ML_ASYNC_ERROR;
+                break;
+            }
+            reader->next_deliver++;
+            if (b->len == 0) {
+                b->state = BUF_FREE;  // the empty read that signalled EOF
+                continue;
+            }
+            b->state = BUF_HELD;
+            chunk->data = b->data;
+            chunk->len = b->len;
+            chunk->offset = b->offset;
+            chunk->buffer = (unsigned)(b - reader->buffers);
+            result = ML_ASYNC_READY;
+            break;
+        }
+        if (reader->next_deliver == reader->next_submit) {
+            // Nothing outstanding: done, or the caller never submitted
+            if (reader->eof) {
+                result = reader->error != 0 ? ML_ASYNC_ERROR : ML_ASYNC_EOF;
+                break;
+            }
+            if (submit_locked(reader) < 0) {
+                result = ML_ASYNC_ERROR;
+                break;
+            }
+            if (reader->next_deliver == reader->next_submit) {
+                result = ML_ASYNC_PENDING;  // every buffer is held by the caller
+                break;
+            }
+            continue;
+        }
+        if (!wait) {
+            result = ML_ASYNC_PENDING;
+            break;
+        }
+
+#ifdef MULTILANG_HAVE_IO_URING
+        if (reader->use_uring) {
+            if (uring_enter(&reader->ring, 1) != 0) {
+                reader->error = errno;
+                result = ML_ASYNC_ERROR;
+                break;
+            }
+            continue;
+        }
+#endif
+        pthread_cond_wait(&reader->done, &reader->lock);
+    }
+    backend_unlock(reader);
+    return result;
+}
+
+void ml_async_release(ml_async_reader *reader, const ml_async_chunk *chunk) {
+    if (reader == NULL || chunk == NULL || chunk->buffer >= reader->depth) {
+        return;
+    }
+    backend_lock(reader);
+    if (reader->buffers[chunk->buffer].state == BUF_HELD) {
+        reader->buffers[chunk->buffer].state = BUF_FREE;
+    }
+    backend_unlock(reader);
+}
+
+int ml_async_error(const ml_async_reader *reader) {
+    return reader != NULL ? reader->error : 0;
+}
+
+const char *ml_async_backend_name(const ml_async_reader *reader) {
+    return reader != NULL && reader->use_uring ? "io_uring" : "thread";
+}
+
+void ml_async_reader_destroy(ml_async_reader *reader) {
+    if (reader == NULL) {
+        return;
+    }
+
+#ifdef MULTILANG_HAVE_IO_URING
+    if (reader->use_uring) {
+        // The kernel may still write into our buffers: cancel what is in
+        // flight and wait for every completion before freeing them
+        for (unsigned i = 0; i < reader->depth; i++) {
+            if (reader->buffers[i].state == BUF_IN_FLIGHT) {
+                struct io_uring_sqe *sqe = uring_next_sqe(&reader->ring);
+                sqe->opcode = IORING_OP_ASYNC_CANCEL;
+                sqe->addr = i;
+                sqe->user_data = CANCEL_TAG;
+                uring_commit_sqe(&reader->ring);
+            }
+        }
+        reader->eof = 1;
+        reader->stop = 1;
+        while (reader->in_flight > 0 && uring_enter(&reader->ring, 1) == 0) {
+            uring_reap(reader);
+        }
+        uring_teardown(&reader->ring);
+    }
+#endif
+    if (reader->thread_started) {
+        // A blocking read() (or poll()) on a pipe cannot be interrupted
+        // portably; the helper finishes its current read, then sees `stop`
+        pthread_mutex_lock(&reader->lock);
+        reader->stop = 1;
+        pthread_cond_signal(&reader->work);
+        pthread_mutex_unlock(&reader->lock);
+        pthread_join(reader->thread, NULL);
+    }
+    if (reader->sync_ready) {
+        pthread_cond_destroy(&reader->done);
+        pthread_cond_destroy(&reader->work);
+        pthread_mutex_destroy(&reader->lock);
+    }
+
+    for (unsigned i = 0; i < reader->depth; i++) {
+        if (reader->buffers[i].data != NULL) {
+            ml_mem_release(reader->chunk_size);
+            free(reader->buffers[i].data);
+        }
+    }
+    free(reader->buffers);
+    free(reader);
+}
+
+// ============================================================================
+// LINE SPLITTING OVER ASYNC CHUNKS
+// ============================================================================
+
+#define SPLIT_POSITIONS 4096
+
+typedef struct {
+    unsigned flags;
+    ml_name_callback callback;
+    void *ctx;
+    size_t total;
+    int stopped;
+    char *carry;        // line that started in an earlier chunk
+    size_t carry_len;
+    size_t carry_cap;
+    size_t carry_floor; // carry may always grow this far (one chunk), budget or not
+    int carry_cut;      // carry hit the --max-mem budget: drop the rest of the line
+} line_splitter;
+
+/**
+ * Reports one line; `valid` says whether it is well-formed UTF-8
+ */
+static void emit(line_splitter *s, const char *data, size_t len, int valid) {
+    if ((s->flags & ML_BATCH_VALID_UTF8) && !valid) {
+        return;
+    }
+    if (s->flags & ML_BATCH_NORMALIZE) {
+        // Both the carry and the chunk buffers belong to this side until released
+        len = ml_normalize((char *)data, len);
+    } else if (s->flags & ML_BATCH_TRIM) {
+        ml_trim(&data, &len);
+    }
+    if ((s->flags & ML_BATCH_SKIP_EMPTY) && len == 0) {
+        return;
+    }
+    s->total++;
+    if (s->callback(data, len, s->ctx) != 0) {
+        s->stopped = 1;
+    }
+}
+
+/**
+ * Appends to `carry`. A line that would grow it past the memory budget is
+ * cut at the last whole character that fits; the rest of it is dropped.
+ */
+static int carry_append(line_splitter *s, const char *data, size_t len) {
+    if (s->carry_cut) {
+        return 0;
+    }
+    if (s->carry_len + len > s->carry_cap) {
+        size_t cap = s->carry_cap != 0 ? s->carry_cap : 256;
+        while (cap < s->carry_len + len) {
+            cap *= 2;
+        }
+        if (cap <= s->carry_floor) {
+            ml_mem_charge(cap - s->carry_cap);
+        } else if (ml_mem_try_grow(s->carry_cap, cap) != 0) {
+            size_t keep = ml_utf8_truncate(data, len, s->carry_cap - s->carry_len);
+            if (keep > 0) {
+                memcpy(s->carry + s->carry_len, data, keep);
+                s->carry_len += keep;
+            }
+            s->carry_cut = 1;
+            return 0;
+        }
+        char *grown = realloc(s->carry, cap);
+        if (grown == NULL) {
+            ml_mem_release(cap - s->carry_cap);
+            return -1;
+        }
+        s->carry = grown;
+        s->carry_cap = cap;
+    }
+    memcpy(s->carry + s->carry_len, data, len);
+    s->carry_len += len;
+    return 0;
+}
+
+static int carry_valid(const line_splitter *s) {
+    return !(s->flags & ML_BATCH_VALID_UTF8) || ml_utf8_validate(s->carry, s->carry_len);
+}
+
+/**
+ * Splits one chunk; the unterminated tail is kept in `carry`
+ */
+static int split_chunk(line_splitter *s, const char *data, size_t len, size_t *positions) {
+    size_t pos = 0;
+    if (s->carry_len > 0) {
+        size_t newline = ml_find_newline(data, len);
+        if (carry_append(s, data, newline) != 0) {
+            return -1;
+        }
+        if (newline == len) {
+            return 0;  // the line continues in the next chunk
+        }
+        emit(s, s->carry, s->carry_len, carry_valid(s));
+        s->carry_len = 0;
+        s->carry_cut = 0;
+        pos = newline + 1;
+    }
+
+    while (!s->stopped && pos < len) {
+        const char *base = data + pos;
+        size_t found = ml_index_newlines(base, len - pos, positions, SPLIT_POSITIONS);
+
+        // One validation pass per batch of lines, as in name_batch.c
+        size_t batch_end = found > 0 ? positions[found - 1] : 0;
+        size_t valid_end = (s->flags & ML_BATCH_VALID_UTF8) ? ml_utf8_valid_prefix(base, batch_end)
+                                                            : batch_end;
+
+        size_t line_start = 0;
+        for (size_t i = 0; i < found && !s->stopped; i++) {
+            int valid = valid_end >= positions[i];
+            emit(s, base + line_start, positions[i] - line_start, valid);
+            line_start = positions[i] + 1;
+            if (!valid && line_start < batch_end) {
+                valid_end = line_start + ml_utf8_valid_prefix(base + line_start, batch_end - line_start);
+            }
+        }
+        pos += line_start;
+        if (found < SPLIT_POSITIONS) {
+            break;
+        }
+    }
+    if (!s->stopped && pos < len) {
+        return carry_append(s, data + pos, len - pos);
+    }
+    return 0;
+}
+
+/**
+ * Takes the next chunk, running the thread's idle hook (name_batch.h)
+ * first if it has not arrived yet
+ */
+static int poll_or_idle(ml_async_reader *reader, ml_async_chunk *chunk) {
+    int status = ml_async_poll(reader, chunk, 0);
+    if (status != ML_ASYNC_PENDING) {
+        return status;
+    }
+    ml_input_idle();
+    return ml_async_poll(reader, chunk, 1);
+}
+
+size_t ask_names_async(int fd, unsigned flags, ml_name_callback callback, void *ctx) {
+    if (callback == NULL) {
+        return 0;
+    }
+    ml_async_reader *reader = ml_async_reader_create(fd, 0, 0);
+    size_t *positions = malloc(SPLIT_POSITIONS * sizeof(size_t));
+    if (reader == NULL || positions == NULL) {
+        ml_async_reader_destroy(reader);
+        free(positions);
+        return (size_t)-1;
+    }
+
+    line_splitter s = {flags, callback, ctx, 0, 0, NULL, 0, 0, reader->chunk_size, 0};
+    int status = ml_async_submit(reader) < 0 ? ML_ASYNC_ERROR : ML_ASYNC_READY;
+    ml_async_chunk chunk;
+    int first = 1;
+    int saved_errno = 0;
+    while (status == ML_ASYNC_READY && !s.stopped &&
+           (status = poll_or_idle(reader, &chunk)) == ML_ASYNC_READY) {
+        if (first && ml_codec_detect(chunk.data, chunk.len) != ML_CODEC_NONE) {
+            // Compressed input is decoded by the batch reader (compressed_io.h), not split raw
+            ml_async_release(reader, &chunk);
+            status = ML_ASYNC_ERROR;
+            saved_errno = ENOTSUP;
+            break;
+        }
+        first = 0;
+        int rc = split_chunk(&s, chunk.data, chunk.len, positions);
+        ml_async_release(reader, &chunk);
+        if (rc != 0) {
+            status = ML_ASYNC_ERROR;
+            break;
+        }
+        ml_async_submit(reader);
+    }
+    if (status == ML_ASYNC_EOF && s.carry_len > 0) {
+        emit(&s, s.carry, s.carry_len, carry_valid(&s));  // last line without a trailing newline
+    }
+
+    ml_mem_release(s.carry_cap);
+    free(s.carry);
+    free(positions);
+    ml_async_reader_destroy(reader);
+    if (saved_errno != 0) {
+        errno = saved_errno;
+    }
+    return status == ML_ASYNC_ERROR ? (size_t)-1 : s.total;
+}
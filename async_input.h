@@ -0,0 +1,113 @@
+#ifndef MULTILANG_ASYNC_INPUT_H
+#define MULTILANG_ASYNC_INPUT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "name_batch.h"  // ml_name_callback, ML_BATCH_* flags
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ============================================================================
+// ASYNCHRONOUS CHUNKED INPUT
+// ============================================================================
+// The blocking readers (fgets, getline, fread in the batch reader) stall the
+// thread on every refill. An async reader instead keeps several large reads
+// in flight on a file descriptor, so parsing one chunk overlaps with reading
+// the next ones:
+//
+//   ml_async_submit(r);                        // start reads into free buffers
+//   while (ml_async_poll(r, &chunk, 1) == ML_ASYNC_READY) {
+//       parse(chunk.data, chunk.len);          // other reads keep running
+//       ml_async_release(r, &chunk);
+//       ml_async_submit(r);                    // reuse the buffer right away
+//   }
+//
+// Chunks are always delivered in file order. On a regular file `depth`
+// reads at consecutive offsets are in flight at once; on a pipe or terminal
+// one read is in flight while the previous chunk is parsed (double buffering).
+//
+// Backends: io_uring when it was detected at configure time
+// (MULTILANG_HAVE_IO_URING) and the kernel allows it, otherwise one helper
+// thread doing blocking reads. Both expose the same non-blocking API;
+// MULTILANG_ASYNC=thread in the environment forces the thread backend.
+
+#define ML_ASYNC_DEFAULT_CHUNK (1u << 20)  // 1 MiB per read
+#define ML_ASYNC_DEFAULT_DEPTH 4           // buffers per reader
+
+// ml_async_poll() results
+#define ML_ASYNC_READY    1   // `chunk` holds the next chunk
+#define ML_ASYNC_PENDING  0   // nothing ready yet (non-blocking poll only)
+#define ML_ASYNC_EOF     (-1) // every chunk has been delivered
+#define ML_ASYNC_ERROR   (-2) // a read failed; see ml_async_error()
+
+typedef struct ml_async_reader ml_async_reader;
+
+typedef struct ml_async_chunk {
+    const char *data;
+    size_t len;
+    uint64_t offset;  // position of data[0] in the input
+    unsigned buffer;  // internal: which buffer to release
+} ml_async_chunk;
+
+/**
+ * Creates a reader over `fd` (not closed by the reader) with `depth`
+ * buffers of `chunk_size` bytes (0 selects the defaults, with smaller chunks
+ * under a --max-mem budget; depth is at least 2)
+ *
+ * @return Reader handle, or NULL if allocation failed
+ */
+ml_async_reader *ml_async_reader_create(int fd, size_t chunk_size, unsigned depth);
+
+/**
+ * Starts reads into every free buffer without blocking
+ *
+ * @return Number of reads started, or -1 on error
+ */
+int ml_async_submit(ml_async_reader *reader);
+
+/**
+ * Takes the next chunk in file order
+ *
+ * @param wait Non-zero to block until it is available
+ * @return ML_ASYNC_READY, ML_ASYNC_PENDING, ML_ASYNC_EOF or ML_ASYNC_ERROR
+ */
+int ml_async_poll(ml_async_reader *reader, ml_async_chunk *chunk, int wait);
+
+/**
+ * Hands a delivered chunk's buffer back for the next ml_async_submit()
+ */
+void ml_async_release(ml_async_reader *reader, const ml_async_chunk *chunk);
+
+/**
+ * @return errno of the failed read after ML_ASYNC_ERROR, else 0
+ */
+int ml_async_error(const ml_async_reader *reader);
+
+/**
+ * @return "io_uring" or "thread"
+ */
+const char *ml_async_backend_name(const ml_async_reader *reader);
+
+/**
+ * Cancels outstanding reads and releases the reader
+ */
+void ml_async_reader_destroy(ml_async_reader *reader);
+
+/**
+ * Streams every line of `fd` to `callback` through an async reader
+ * (same flags and callback contract as ask_names_batch_stream()). The
+ * thread's idle hook (name_batch.h) runs before it waits for a chunk.
+ *
+ * @return Number of names delivered, or (size_t)-1 if a read failed or the
+ *         input is compressed (ENOTSUP: read it with ml_batch_reader_open(),
+ *         which decodes it on a helper thread)
+ */
+size_t ask_names_async(int fd, unsigned flags, ml_name_callback callback, void *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //MULTILANG_ASYNC_INPUT_H
@@ -0,0 +1,348 @@
+// Coroutine name input: Executor, AsyncLineReader and async_ask_name()
+#include "async_name.h"
+#include "line_scan.h"
+#include "ml_stats.h"
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <sys/epoll.h>
+#define USE_EPOLL 1
+#else
+#include <sys/event.h>
+#include <sys/time.h>
+#endif
+
+namespace InputCpp {
+
+    namespace {
+        constexpr size_t kBlockSize = 64 * 1024;
+        constexpr int kMaxEvents = 64;
+
+        void set_nonblocking(int fd) {
+            int flags = fcntl(fd, F_GETFL, 0);
+            if (flags >= 0) {
+                fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+            }
+        }
+    }
+
+    // ========================================================================
+    // EXECUTOR
+    // ========================================================================
+
+    // Fire-and-forget coroutine that owns one spawned task
+    struct Executor::Detached {
+        struct promise_type {
+            Detached get_return_object() const noexcept { return {}; }
+            std::suspend_never initial_suspend() const noexcept { return {}; }
+            std::suspend_never final_suspend() const noexcept { return {}; }
+            void return_void() const noexcept {}
+            void unhandled_exception() const noexcept { std::terminate(); }
+        };
+    };
+
+    Executor::Detached Executor::run_detached(Executor &executor, Task<void> task) {
+        co_await executor.schedule();  // start on a run() thread, not in spawn()
+        std::exception_ptr error;
+        try {
+            co_await std::move(task);
+        } catch (...) {
+            error = std::current_exception();
+        }
+        executor.task_finished(error);
+    }
+
+    Executor::Executor() {
+#ifdef USE_EPOLL
+        poll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+#else
+        poll_fd_ = kqueue();
+#endif
+        if (poll_fd_ < 0 || pipe(wake_pipe_) != 0) {
+            throw std::runtime_error("Executor: cannot create poller");
+        }
+        set_nonblocking(wake_pipe_[0]);
+        set_nonblocking(wake_pipe_[1]);
+
+        // Level-triggered and data == nullptr: tells wake-ups apart from fds
+#ifdef USE_EPOLL
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.ptr = nullptr;
+        epoll_ctl(poll_fd_, EPOLL_CTL_ADD, wake_pipe_[0], &ev);
+#else
+        struct kevent change;
+        EV_SET(&change, wake_pipe_[0], EVFILT_READ, EV_ADD, 0, 0, nullptr);
+        kevent(poll_fd_, &change, 1, nullptr, 0, nullptr);
+#endif
+    }
+
+    Executor::~Executor() {
+        // Tasks spawned without a run() are still parked at their first
+        // schedule(); dropping them destroys the tasks they own
+        for (std::coroutine_handle<> handle : ready_) {
+            handle.destroy();
+        }
+        close(wake_pipe_[0]);
+        close(wake_pipe_[1]);
+        close(poll_fd_);
+    }
+
+    void Executor::spawn(Task<void> task) {
+        live_.fetch_add(1, std::memory_order_relaxed);
+        run_detached(*this, std::move(task));
+    }
+
+    void Executor::run(unsigned threads) {
+        std::vector<std::thread> helpers;
+        for (unsigned i = 1; i < threads; i++) {
+            helpers.emplace_back([this] { run_loop(); });
+        }
+        run_loop();
+        for (std::thread &helper : helpers) {
+            helper.join();
+        }
+
+        // The final wake-up is left in the pipe so every thread saw it
+        char drain[64];
+        while (read(wake_pipe_[0], drain, sizeof(drain)) > 0) {
+        }
+
+        std::exception_ptr error = std::exchange(first_error_, nullptr);
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    void Executor::run_loop() {
+        std::vector<std::coroutine_handle<>> woken;
+        woken.reserve(kMaxEvents);
+
+        for (;;) {
+            std::coroutine_handle<> next;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (!ready_.empty()) {
+                    next = ready_.front();
+                    ready_.pop_front();
+                } else if (live_.load(std::memory_order_acquire) == 0) {
+                    return;
+                } else {
+                    sleeping_++;
+                }
+            }
+            if (next) {
+                next.resume();
+                continue;
+            }
+
+            // Nothing runnable: sleep until a descriptor or post() wakes us
+            woken.clear();
+            bool drain = false;
+#ifdef USE_EPOLL
+            epoll_event events[kMaxEvents];
+            int n = epoll_wait(poll_fd_, events, kMaxEvents, -1);
+            for (int i = 0; i < n; i++) {
+                if (events[i].data.ptr == nullptr) {
+                    drain = true;
+                } else {
+                    woken.push_back(std::coroutine_handle<>::from_address(events[i].data.ptr));
+                }
+            }
+#else
+            struct kevent events[kMaxEvents];
+            int n = kevent(poll_fd_, nullptr, 0, events, kMaxEvents, nullptr);
+            for (int i = 0; i < n; i++) {
+                if (events[i].udata == nullptr) {
+                    drain = true;
+                } else {
+                    woken.push_back(std::coroutine_handle<>::from_address(events[i].udata));
+                }
+            }
+#endif
+            if (drain && live_.load(std::memory_order_acquire) != 0) {
+                char buf[64];
+                while (read(wake_pipe_[0], buf, sizeof(buf)) > 0) {
+                }
+                if (live_.load(std::memory_order_acquire) == 0) {
+                    wake();  // the last task finished while we drained
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            sleeping_--;
+            ready_.insert(ready_.end(), woken.begin(), woken.end());
+        }
+    }
+
+    void Executor::post(std::coroutine_handle<> handle) {
+        bool wake_one;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ready_.push_back(handle);
+            wake_one = sleeping_ > 0;
+        }
+        if (wake_one) {
+            wake();
+        }
+    }
+
+    void Executor::wake() {
+        char byte = 1;
+        ssize_t ignored = write(wake_pipe_[1], &byte, 1);  // EAGAIN: already pending
+        (void)ignored;
+    }
+
+    void Executor::task_finished(std::exception_ptr error) {
+        if (error) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!first_error_) {
+                first_error_ = error;
+            }
+        }
+        if (live_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            wake();  // the last task: release every sleeping run() thread
+        }
+    }
+
+    void Executor::resume_when_readable(int fd, std::coroutine_handle<> handle) {
+#ifdef USE_EPOLL
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+        ev.data.ptr = handle.address();
+        int rc = epoll_ctl(poll_fd_, EPOLL_CTL_MOD, fd, &ev);
+        if (rc != 0 && errno == ENOENT) {
+            rc = epoll_ctl(poll_fd_, EPOLL_CTL_ADD, fd, &ev);
+        }
+#else
+        struct kevent change;
+        EV_SET(&change, fd, EVFILT_READ, EV_ADD | EV_ONESHOT, 0, 0, handle.address());
+        int rc = kevent(poll_fd_, &change, 1, nullptr, 0, nullptr);
+#endif
+        if (rc != 0) {
+            // Not pollable (a regular file is always readable): retry right away
+            post(handle);
+        }
+    }
+
+    void Executor::forget(int fd) {
+#ifdef USE_EPOLL
+        epoll_ctl(poll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+#else
+        struct kevent change;
+        EV_SET(&change, fd, EVFILT_READ, EV_DELETE, 0, 0, nullptr);
+        kevent(poll_fd_, &change, 1, nullptr, 0, nullptr);
+#endif
+    }
+
+    // ========================================================================
+    // ASYNC LINE READER
+    // ========================================================================
+
+    AsyncLineReader::AsyncLineReader(Executor &executor, int fd)
+        : executor_(executor), fd_(fd), saved_flags_(fcntl(fd, F_GETFL, 0)) {
+        set_nonblocking(fd_);
+        buf_ = static_cast<char*>(malloc(kBlockSize));
+        cap_ = buf_ != nullptr ? kBlockSize : 0;
+    }
+
+    AsyncLineReader::~AsyncLineReader() {
+        executor_.forget(fd_);
+        if (saved_flags_ >= 0) {
+            fcntl(fd_, F_SETFL, saved_flags_);
+        }
+        free(buf_);
+    }
+
+    AsyncLineReader::Status AsyncLineReader::try_read_line(std::string_view &line) {
+        if (buf_ == nullptr) {
+            error_ = ENOMEM;
+            return Status::End;
+        }
+
+        for (;;) {
+            const char *base = buf_ + start_;
+            size_t offset = ml_find_newline(base + scanned_, end_ - start_ - scanned_);
+            if (scanned_ + offset < end_ - start_) {
+                size_t len = scanned_ + offset;
+                line = std::string_view(base, len);
+                start_ += len + 1;
+                scanned_ = 0;
+                return Status::Line;
+            }
+            scanned_ = end_ - start_;
+
+            if (eof_) {
+                if (start_ == end_) {
+                    return Status::End;
+                }
+                line = std::string_view(base, end_ - start_);  // no trailing '\n'
+                start_ = end_;
+                scanned_ = 0;
+                return Status::Line;
+            }
+
+            // Move the partial line to the front; grow if it fills the buffer
+            size_t pending = end_ - start_;
+            if (start_ > 0) {
+                memmove(buf_, buf_ + start_, pending);
+                start_ = 0;
+                end_ = pending;
+            }
+            if (end_ == cap_) {
+                char *grown = static_cast<char*>(realloc(buf_, cap_ * 2));
+                if (grown == nullptr) {
+                    error_ = ENOMEM;
+                    eof_ = true;
+                    continue;
+                }
+                buf_ = grown;
+                cap_ *= 2;
+            }
+
+            ssize_t got = ::read(fd_, buf_ + end_, cap_ - end_);
+            if (got > 0) {
+                end_ += static_cast<size_t>(got);
+            } else if (got == 0) {
+                eof_ = true;
+            } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return Status::WouldBlock;
+            } else if (errno != EINTR) {
+                error_ = errno;
+                eof_ = true;
+            }
+        }
+    }
+
+    // ========================================================================
+    // ASYNC ASK_NAME
+    // ========================================================================
+
+    // The recorded latency runs from the first resume to completion, so it
+    // includes the time spent waiting for the source.
+    Task<std::optional<std::string>> async_ask_name(AsyncLineReader &source) {
+        MlStats::Scope stats(ML_STATS_ASK_NAME_ASYNC);
+
+        std::string_view line;
+        AsyncLineReader::Status status;
+        while ((status = source.try_read_line(line)) == AsyncLineReader::Status::WouldBlock) {
+            co_await source.readable();
+        }
+        if (status == AsyncLineReader::Status::End) {
+            co_return std::nullopt;
+        }
+
+        std::string name(line);
+        stats.bytes_read = line.size() + 1;
+        stats.bytes_copied = name.size() + 1;
+        stats.alloc_string(name);
+        co_return name;
+    }
+}
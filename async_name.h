@@ -0,0 +1,301 @@
+#ifndef MULTILANG_ASYNC_NAME_H
+#define MULTILANG_ASYNC_NAME_H
+
+// C++20 coroutine name input (C++ only)
+//
+// The ask_name_* functions block their thread until a whole line arrives,
+// so fanning in from many sockets or pipes costs one thread per source.
+// Here a source is an AsyncLineReader over a non-blocking descriptor, and
+// InputCpp::async_ask_name() is a lazy Task that suspends instead of
+// blocking whenever the source has no complete line yet:
+//
+//   InputCpp::Executor executor;
+//   for (int fd : sockets) {
+//       executor.spawn(serve(executor, fd));   // Task<void> coroutines that
+//   }                                          //   co_await async_ask_name()
+//   executor.run(2);                           // two threads, any number of fds
+//
+// The Executor waits on every suspended source with one epoll (kqueue on
+// macOS/BSD) instance and resumes a coroutine when its descriptor turns
+// readable. Several threads may run the same executor; a given coroutine
+// only ever runs on one of them at a time.
+//
+// Sources are not read through the chunked async reader (async_input.h): an
+// ml_async_reader completes its reads on its own io_uring ring or helper
+// thread and has no descriptor to wait on, so one per source would cost a
+// ring or a thread each, which is what this fan-in avoids. Readiness of the
+// sockets and pipes themselves needs just one poller per executor.
+
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace InputCpp {
+
+    template <typename T>
+    class Task;
+
+    namespace detail {
+        template <typename T>
+        struct TaskPromise;
+
+        struct TaskPromiseBase {
+            std::coroutine_handle<> continuation = std::noop_coroutine();
+            std::exception_ptr error;
+
+            struct FinalAwaiter {
+                bool await_ready() const noexcept { return false; }
+
+                template <typename Promise>
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> done) noexcept {
+                    // Symmetric transfer: resume the awaiting coroutine
+                    // without growing the stack
+                    return done.promise().continuation;
+                }
+
+                void await_resume() const noexcept {}
+            };
+
+            std::suspend_always initial_suspend() const noexcept { return {}; }
+            FinalAwaiter final_suspend() const noexcept { return {}; }
+            void unhandled_exception() noexcept { error = std::current_exception(); }
+        };
+
+        template <typename T>
+        struct TaskPromise : TaskPromiseBase {
+            std::optional<T> value;
+
+            Task<T> get_return_object() noexcept;
+            void return_value(T result) { value.emplace(std::move(result)); }
+
+            T take() {
+                if (error) {
+                    std::rethrow_exception(error);
+                }
+                return std::move(*value);
+            }
+        };
+
+        template <>
+        struct TaskPromise<void> : TaskPromiseBase {
+            Task<void> get_return_object() noexcept;
+            void return_void() const noexcept {}
+
+            void take() const {
+                if (error) {
+                    std::rethrow_exception(error);
+                }
+            }
+        };
+    }
+
+    /**
+     * @brief Lazy coroutine producing a T
+     *
+     * Nothing runs until the task is awaited (or handed to
+     * Executor::spawn()); the awaiting coroutine is resumed when it finishes,
+     * and exceptions propagate to it. Move-only; owns the coroutine frame.
+     */
+    template <typename T = void>
+    class [[nodiscard]] Task {
+    public:
+        using promise_type = detail::TaskPromise<T>;
+        using handle_type = std::coroutine_handle<promise_type>;
+
+        Task(Task &&other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+        Task &operator=(Task &&other) noexcept {
+            if (this != &other) {
+                if (handle_) {
+                    handle_.destroy();
+                }
+                handle_ = std::exchange(other.handle_, {});
+            }
+            return *this;
+        }
+        Task(const Task &) = delete;
+        Task &operator=(const Task &) = delete;
+
+        ~Task() {
+            if (handle_) {
+                handle_.destroy();
+            }
+        }
+
+        auto operator co_await() && noexcept {
+            struct Awaiter {
+                handle_type handle;
+
+                bool await_ready() const noexcept { return !handle || handle.done(); }
+
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<> caller) noexcept {
+                    handle.promise().continuation = caller;
+                    return handle;  // start the task on this thread
+                }
+
+                T await_resume() { return handle.promise().take(); }
+            };
+            return Awaiter{handle_};
+        }
+
+    private:
+        friend struct detail::TaskPromise<T>;
+        explicit Task(handle_type handle) noexcept : handle_(handle) {}
+
+        handle_type handle_;
+    };
+
+    namespace detail {
+        template <typename T>
+        Task<T> TaskPromise<T>::get_return_object() noexcept {
+            return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+        }
+
+        inline Task<void> TaskPromise<void>::get_return_object() noexcept {
+            return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+        }
+    }
+
+    /**
+     * @brief Event loop resuming coroutines when their descriptors are ready
+     */
+    class Executor {
+    public:
+        Executor();
+        ~Executor();
+
+        Executor(const Executor &) = delete;
+        Executor &operator=(const Executor &) = delete;
+
+        /**
+         * @brief Starts `task` on the next run() and keeps it alive until it
+         *        finishes (fire and forget)
+         */
+        void spawn(Task<void> task);
+
+        /**
+         * @brief Runs coroutines until every spawned task has finished
+         *
+         * @param threads Threads to run on, including the caller (0 = 1)
+         * @throws The first exception that escaped a spawned task
+         */
+        void run(unsigned threads = 1);
+
+        /**
+         * @brief Awaitable that moves the awaiting coroutine onto a run() thread
+         */
+        auto schedule() noexcept {
+            struct Awaiter {
+                Executor &executor;
+                bool await_ready() const noexcept { return false; }
+                void await_suspend(std::coroutine_handle<> handle) { executor.post(handle); }
+                void await_resume() const noexcept {}
+            };
+            return Awaiter{*this};
+        }
+
+        /**
+         * @brief Resumes `handle` once `fd` is readable (or has hung up)
+         *
+         * One-shot: a coroutine re-arms it each time it would block.
+         */
+        void resume_when_readable(int fd, std::coroutine_handle<> handle);
+
+        /**
+         * @brief Drops `fd` from the poller before it is closed or reused
+         */
+        void forget(int fd);
+
+    private:
+        struct Detached;
+        static Detached run_detached(Executor &executor, Task<void> task);
+
+        void post(std::coroutine_handle<> handle);
+        void run_loop();
+        void task_finished(std::exception_ptr error);
+        void wake();
+
+        int poll_fd_ = -1;
+        int wake_pipe_[2] = {-1, -1};
+        std::mutex mutex_;
+        std::deque<std::coroutine_handle<>> ready_;     // guarded by mutex_
+        unsigned sleeping_ = 0;                         // threads in the poller
+        std::atomic<size_t> live_{0};                   // spawned, not finished
+        std::exception_ptr first_error_;
+    };
+
+    /**
+     * @brief Line source over a descriptor, read without ever blocking
+     *
+     * Sets O_NONBLOCK on `fd` (restored by the destructor, fd not closed).
+     * Like LineReader, data read ahead stays in this reader, so nothing else
+     * may read `fd` while it is in use.
+     */
+    class AsyncLineReader {
+    public:
+        enum class Status { Line, WouldBlock, End };
+
+        AsyncLineReader(Executor &executor, int fd);
+        ~AsyncLineReader();
+
+        AsyncLineReader(const AsyncLineReader &) = delete;
+        AsyncLineReader &operator=(const AsyncLineReader &) = delete;
+
+        /**
+         * @brief Takes the next line (without '\n') if one is complete
+         *
+         * @param line Set on Status::Line to a view valid until the next call
+         * @return Line, WouldBlock (await readable() and retry) or End
+         */
+        Status try_read_line(std::string_view &line);
+
+        /**
+         * @brief Awaitable that suspends until the descriptor is readable
+         */
+        auto readable() noexcept {
+            struct Awaiter {
+                AsyncLineReader &reader;
+                bool await_ready() const noexcept { return false; }
+                void await_suspend(std::coroutine_handle<> handle) {
+                    reader.executor_.resume_when_readable(reader.fd_, handle);
+                }
+                void await_resume() const noexcept {}
+            };
+            return Awaiter{*this};
+        }
+
+        /**
+         * @return errno of a failed read (End was returned), else 0
+         */
+        int error() const { return error_; }
+
+    private:
+        Executor &executor_;
+        int fd_;
+        int saved_flags_;
+        char *buf_ = nullptr;
+        size_t cap_ = 0;
+        size_t start_ = 0;
+        size_t end_ = 0;
+        size_t scanned_ = 0;  // bytes after start_ known to hold no '\n'
+        bool eof_ = false;
+        int error_ = 0;
+    };
+
+    /**
+     * @brief Awaitable counterpart of ask_name_string()
+     *
+     * Completes with the next name from `source`, or std::nullopt at end of
+     * input. No prompt and no greeting: the sources are sockets and pipes,
+     * and the caller decides where (and on which thread) greetings go.
+     */
+    Task<std::optional<std::string>> async_ask_name(AsyncLineReader &source);
+}
+
+#endif //MULTILANG_ASYNC_NAME_H
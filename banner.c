@@ -4,6 +4,7 @@
 
 #define BANNER_WIDTH 80
 #define MIN_SEPARATOR_WIDTH 50
+#define BANNER_CAPACITY 1024
 
 /**
  * Expected output:
@@ -14,13 +15,30 @@
  *
  */
 
+// The banner is rendered once into this buffer and then emitted with a
+// single fwrite(), instead of one printf() per glyph and per padding run.
+static char banner_text[BANNER_CAPACITY];
+static size_t banner_length = 0;
+
+/**
+ * Appends `count` copies of `glyph` to the banner buffer
+ */
+static void append_repeated(const char *glyph, size_t count) {
+    size_t glyph_len = strlen(glyph);
+    for (size_t i = 0; i < count && banner_length + glyph_len < BANNER_CAPACITY; i++) {
+        memcpy(banner_text + banner_length, glyph, glyph_len);
+        banner_length += glyph_len;
+    }
+}
+
 /**
- * Prints a string centered within the banner width
+ * Appends a string centered within the banner width
  */
-static void print_centered(const char *text) {
+static void append_centered(const char *text) {
     size_t text_len = strlen(text);
     if (text_len >= BANNER_WIDTH) {
-        printf("%s\n", text);
+        append_repeated(text, 1);
+        append_repeated("\n", 1);
         return;
     }
 
@@ -28,33 +46,32 @@ static void print_centered(const char *text) {
     size_t left_padding = total_padding / 2;
     size_t right_padding = total_padding - left_padding; // Handle odd widths
 
-    printf("%*s%s%*s\n", (int)left_padding, "", text, (int)right_padding, "");
+    append_repeated(" ", left_padding);
+    append_repeated(text, 1);
+    append_repeated(" ", right_padding);
+    append_repeated("\n", 1);
 }
 
 /**
- * Prints a horizontal separator line centered
+ * Appends a horizontal separator line centered
  */
-static void print_separator(size_t width) {
+static void append_separator(size_t width) {
     if (width < MIN_SEPARATOR_WIDTH) {
         width = MIN_SEPARATOR_WIDTH;
     }
 
     if (width >= BANNER_WIDTH) {
-        for (size_t i = 0; i < BANNER_WIDTH; i++) {
-            printf("═");
-        }
-        printf("\n");
+        append_repeated("═", BANNER_WIDTH);
+        append_repeated("\n", 1);
         return;
     }
 
     size_t total_padding = BANNER_WIDTH - width;
     size_t left_padding = total_padding / 2;
 
-    printf("%*s", (int)left_padding, "");
-    for (size_t i = 0; i < width; i++) {
-        printf("═");
-    }
-    printf("\n");
+    append_repeated(" ", left_padding);
+    append_repeated("═", width);
+    append_repeated("\n", 1);
 }
 
 /**
@@ -66,7 +83,14 @@ static size_t max_length(const char *str1, const char *str2) {
     return (len1 > len2) ? len1 : len2;
 }
 
-void print_banner(void) {
+/**
+ * Renders the complete banner into banner_text (first call only)
+ */
+static void build_banner(void) {
+    if (banner_length != 0) {
+        return;
+    }
+
     const char *title = "Multi Programming Language Codebase";
     const char *subtitle = "A software development education project";
 
@@ -74,13 +98,16 @@ void print_banner(void) {
     size_t content_width = max_length(title, subtitle);
     size_t separator_width = content_width + 6; // Add padding
 
-    printf("\n");
-    printf("\n");
+    append_repeated("\n", 2);
+
+    append_centered(title);
+    append_separator(separator_width);
+    append_centered(subtitle);
 
-    print_centered(title);
-    print_separator(separator_width);
-    print_centered(subtitle);
+    append_repeated("\n", 2);
+}
 
-    printf("\n");
-    printf("\n");
+void print_banner(void) {
+    build_banner();
+    fwrite(banner_text, 1, banner_length, stdout);
 }
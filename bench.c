@@ -0,0 +1,329 @@
+// Cross-language benchmark harness
+//
+// Runs every ask_name implementation against a synthetic, non-interactive
+// input stream and reports throughput and per-call latency percentiles.
+//
+// Usage:
+//   MultiLangBench [-n LINES] [impl ...]
+//
+//   impl is any of: c, c_heap, c_arena, cpp, cpp_heap, cpp_arena, rust,
+//   rust_batch (default: all of them)
+//
+// The implementations print prompts and greetings to stdout, so stdout is
+// redirected to /dev/null while they run; the report is written to the
+// original stdout.
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "get_input.h"
+#include "get_input_mem.h"
+#include "get_input_cpp.h"
+#include "get_input_mem_cpp.h"
+#include "greet_rust.h"
+#include "name_arena.h"
+#include "output_sink.h"
+#include "greeting_format.h"
+#include "latency_histogram.h"
+
+#define DEFAULT_LINES 1000000
+#define NAME_BUFFER_SIZE 100
+#define MIN_NAME_LEN 3
+#define MAX_NAME_LEN 24
+#define ARENA_RESET_BYTES (64u * 1024u * 1024u)
+#define RUST_BATCH_NAMES 4096
+#define RUST_BATCH_BYTES (RUST_BATCH_NAMES * 32)
+
+// ============================================================================
+// IMPLEMENTATION WRAPPERS
+// ============================================================================
+// Every implementation is adapted to the same signature so the timing loop
+// is identical for all of them. The heap versions free their result right
+// away, which is part of their real cost.
+
+static void run_c_stack(char *buf, size_t size) {
+    ask_name(buf, size);
+}
+
+static void run_c_heap(char *buf, size_t size) {
+    (void)buf;
+    free_name(ask_name_malloc(size));
+}
+
+static void run_cpp_stack(char *buf, size_t size) {
+    ask_name_cpp(buf, size);
+}
+
+static void run_cpp_heap(char *buf, size_t size) {
+    (void)buf;
+    free_name_cpp(ask_name_cpp_malloc(size));
+}
+
+// The arena versions keep every name alive (the scenario arenas are for)
+// and only release them once ARENA_RESET_BYTES have accumulated
+static name_arena *bench_arena(void) {
+    static name_arena *arena = NULL;
+    if (arena == NULL) {
+        arena = name_arena_create(0);
+    } else if (name_arena_bytes_reserved(arena) > ARENA_RESET_BYTES) {
+        name_arena_reset(arena);
+    }
+    return arena;
+}
+
+static void run_c_arena(char *buf, size_t size) {
+    (void)buf;
+    ask_name_arena(bench_arena(), size);
+}
+
+static void run_cpp_arena(char *buf, size_t size) {
+    (void)buf;
+    ask_name_cpp_arena(bench_arena(), size);
+}
+
+static void run_rust(char *buf, size_t size) {
+    ask_name_rust(buf, size);
+}
+
+// The Rust batch version crosses the FFI boundary once per RUST_BATCH_NAMES
+// names; each call hands out the next name of the current batch, so its
+// latency samples show the amortized cost
+static void run_rust_batch(char *buf, size_t size) {
+    static char names[RUST_BATCH_BYTES];
+    static size_t offsets[RUST_BATCH_NAMES + 1];
+    static size_t count = 0;
+    static size_t next = 0;
+
+    if (next == count) {
+        count = ask_names_rust_batch(names, sizeof(names), offsets, RUST_BATCH_NAMES);
+        next = 0;
+        if (count == 0) {
+            return;
+        }
+    }
+    size_t len = offsets[next + 1] - offsets[next] - 1;
+    size_t copy_len = len < size - 1 ? len : size - 1;
+    memcpy(buf, names + offsets[next], copy_len);
+    buf[copy_len] = '\0';
+    ml_greeting_write(ml_stdout_sink(), ML_GREETING_RUST, buf, copy_len);
+    next++;
+}
+
+typedef struct {
+    const char *name;
+    const char *label;
+    void (*run)(char *buf, size_t size);
+} bench_impl;
+
+// Rust must stay last: its stdin buffer lives inside the Rust runtime and
+// cannot be discarded between runs the way the C stdio buffer can. Each Rust
+// run consumes the whole input, which leaves that buffer empty for the next.
+static const bench_impl IMPLS[] = {
+    {"c",          "C (stack, fgets)",        run_c_stack},
+    {"c_heap",     "C (heap, malloc)",        run_c_heap},
+    {"c_arena",    "C (arena)",               run_c_arena},
+    {"cpp",        "C++ (stack, LineReader)", run_cpp_stack},
+    {"cpp_heap",   "C++ (heap, malloc)",      run_cpp_heap},
+    {"cpp_arena",  "C++ (arena)",             run_cpp_arena},
+    {"rust",       "Rust (FFI, per name)",    run_rust},
+    {"rust_batch", "Rust (FFI, batch)",       run_rust_batch},
+};
+
+#define IMPL_COUNT (sizeof(IMPLS) / sizeof(IMPLS[0]))
+
+// ============================================================================
+// HELPERS
+// ============================================================================
+
+/**
+ * Returns a monotonic timestamp in nanoseconds
+ */
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * Writes `lines` synthetic names (one per line) to a temporary file
+ *
+ * Names are generated from a fixed-seed LCG so every run and every
+ * implementation sees exactly the same byte stream.
+ *
+ * @return Number of bytes written, or 0 on failure
+ */
+static size_t write_synthetic_input(const char *path, size_t lines) {
+    FILE *out = fopen(path, "w");
+    if (out == NULL) {
+        perror("fopen");
+        return 0;
+    }
+
+    uint32_t state = 0x2545F491u;
+    size_t total = 0;
+    char line[MAX_NAME_LEN + 2];
+
+    for (size_t i = 0; i < lines; i++) {
+        state = state * 1664525u + 1013904223u;
+        size_t len = MIN_NAME_LEN + (state >> 24) % (MAX_NAME_LEN - MIN_NAME_LEN + 1);
+        for (size_t j = 0; j < len; j++) {
+            state = state * 1664525u + 1013904223u;
+            line[j] = (char)((j == 0 ? 'A' : 'a') + (state >> 24) % 26);
+        }
+        line[len] = '\n';
+        fwrite(line, 1, len + 1, out);
+        total += len + 1;
+    }
+
+    if (fclose(out) != 0) {
+        perror("fclose");
+        return 0;
+    }
+    return total;
+}
+
+/**
+ * Points stdin (both the fd and the C stdio stream) at the start of `path`
+ */
+static int reset_stdin(const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        perror("open");
+        return -1;
+    }
+    if (dup2(fd, STDIN_FILENO) < 0) {
+        perror("dup2");
+        close(fd);
+        return -1;
+    }
+    close(fd);
+
+    // Drop anything stdio buffered from the previous run
+    clearerr(stdin);
+    fseek(stdin, 0, SEEK_SET);
+    return 0;
+}
+
+/**
+ * Times `lines` consecutive calls of one implementation and prints a report row
+ */
+static void run_benchmark(FILE *report, const bench_impl *impl, const char *path,
+                          size_t lines, size_t input_bytes, uint64_t *samples) {
+    if (reset_stdin(path) != 0) {
+        return;
+    }
+
+    char buf[NAME_BUFFER_SIZE];
+    uint64_t start = now_ns();
+    for (size_t i = 0; i < lines; i++) {
+        uint64_t t0 = now_ns();
+        impl->run(buf, sizeof(buf));
+        samples[i] = now_ns() - t0;
+    }
+    uint64_t elapsed = now_ns() - start;
+    fflush(stdout);
+
+    ml_sort_u64(samples, lines);
+
+    double seconds = (double)elapsed / 1e9;
+    fprintf(report, "%-24s %12.0f %10.2f %9llu %9llu %9llu\n",
+            impl->label,
+            (double)lines / seconds,
+            (double)input_bytes / seconds / (1024.0 * 1024.0),
+            (unsigned long long)ml_percentile(samples, lines, 50.0),
+            (unsigned long long)ml_percentile(samples, lines, 99.0),
+            (unsigned long long)ml_percentile(samples, lines, 99.9));
+    fflush(report);
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [-n LINES] [impl ...]\n", prog);
+    fprintf(stderr, "  impl: c, c_heap, c_arena, cpp, cpp_heap, cpp_arena, rust, rust_batch (default: all)\n");
+}
+
+// ============================================================================
+// ENTRY POINT
+// ============================================================================
+
+int main(int argc, char **argv) {
+    size_t lines = DEFAULT_LINES;
+    int selected[IMPL_COUNT] = {0};
+    int any_selected = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            lines = strtoull(argv[++i], NULL, 10);
+            continue;
+        }
+
+        size_t k;
+        for (k = 0; k < IMPL_COUNT; k++) {
+            if (strcmp(argv[i], IMPLS[k].name) == 0) {
+                selected[k] = 1;
+                any_selected = 1;
+                break;
+            }
+        }
+        if (k == IMPL_COUNT) {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (lines == 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    // Keep a handle on the real stdout for the report, then silence the
+    // prompts and greetings the implementations print
+    FILE *report = fdopen(dup(STDOUT_FILENO), "w");
+    int devnull = open("/dev/null", O_WRONLY);
+    if (report == NULL || devnull < 0) {
+        perror("stdout redirect");
+        return 1;
+    }
+    fflush(stdout);
+    dup2(devnull, STDOUT_FILENO);
+    close(devnull);
+
+    const char *tmpdir = getenv("TMPDIR");
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/multilang_bench_XXXXXX", tmpdir ? tmpdir : "/tmp");
+    int tmp_fd = mkstemp(path);
+    if (tmp_fd < 0) {
+        perror("mkstemp");
+        return 1;
+    }
+    close(tmp_fd);
+
+    size_t input_bytes = write_synthetic_input(path, lines);
+    uint64_t *samples = malloc(lines * sizeof(uint64_t));
+    if (input_bytes == 0 || samples == NULL) {
+        fprintf(stderr, "Failed to prepare benchmark input\n");
+        unlink(path);
+        return 1;
+    }
+
+    fprintf(report, "MultiLang benchmark: %zu lines, %.2f MB of input\n\n",
+            lines, (double)input_bytes / (1024.0 * 1024.0));
+    fprintf(report, "%-24s %12s %10s %9s %9s %9s\n",
+            "implementation", "lines/s", "MB/s", "p50 ns", "p99 ns", "p999 ns");
+
+    for (size_t k = 0; k < IMPL_COUNT; k++) {
+        if (!any_selected || selected[k]) {
+            run_benchmark(report, &IMPLS[k], path, lines, input_bytes, samples);
+        }
+    }
+
+    free(samples);
+    unlink(path);
+    fclose(report);
+    return 0;
+}
@@ -0,0 +1,137 @@
+
+#ifndef BOUNDED_QUEUE_H
+#define BOUNDED_QUEUE_H
+
+// C++-only bounded lock-free MPMC queue
+//
+// Classic sequence-numbered ring (Dmitry Vyukov's bounded MPMC design): each
+// cell carries a sequence counter that tells producers and consumers whether
+// the cell is free or full for their lap around the ring, so push and pop
+// are a single CAS on the shared position plus one store on the cell.
+// No locks; the blocking wrappers wait with backoff().
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <thread>
+
+namespace Pipeline {
+
+    // Keeps the producer and consumer positions on separate cache lines
+    inline constexpr size_t kCacheLine = 64;
+
+    /**
+     * @brief Wait strategy for the blocking queue operations
+     *
+     * Busy-spins first (the other side is usually just ahead), then yields,
+     * then sleeps briefly so an idle stage does not burn a core.
+     */
+    inline void backoff(unsigned spins) {
+        if (spins < 64) {
+            return;
+        }
+        if (spins < 256) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+
+    template <typename T>
+    class BoundedQueue {
+    public:
+        /**
+         * @param capacity Rounded up to a power of two (minimum 2)
+         */
+        explicit BoundedQueue(size_t capacity) {
+            size_t cap = 2;
+            while (cap < capacity) {
+                cap <<= 1;
+            }
+            mask_ = cap - 1;
+            cells_ = std::make_unique<Cell[]>(cap);
+            for (size_t i = 0; i < cap; i++) {
+                cells_[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        BoundedQueue(const BoundedQueue &) = delete;
+        BoundedQueue &operator=(const BoundedQueue &) = delete;
+
+        size_t capacity() const { return mask_ + 1; }
+
+        /**
+         * @return false if the queue is full
+         */
+        bool try_push(T value) {
+            size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+            for (;;) {
+                Cell &cell = cells_[pos & mask_];
+                size_t seq = cell.sequence.load(std::memory_order_acquire);
+                auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+                if (diff == 0) {
+                    if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        cell.value = std::move(value);
+                        cell.sequence.store(pos + 1, std::memory_order_release);
+                        return true;
+                    }
+                } else if (diff < 0) {
+                    return false;  // full
+                } else {
+                    pos = enqueue_pos_.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        /**
+         * @return false if the queue is empty
+         */
+        bool try_pop(T &value) {
+            size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+            for (;;) {
+                Cell &cell = cells_[pos & mask_];
+                size_t seq = cell.sequence.load(std::memory_order_acquire);
+                auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos + 1);
+                if (diff == 0) {
+                    if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        value = std::move(cell.value);
+                        cell.sequence.store(pos + mask_ + 1, std::memory_order_release);
+                        return true;
+                    }
+                } else if (diff < 0) {
+                    return false;  // empty
+                } else {
+                    pos = dequeue_pos_.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        void push(T value) {
+            for (unsigned spins = 0; !try_push(value); spins++) {
+                backoff(spins);
+            }
+        }
+
+        T pop() {
+            T value;
+            for (unsigned spins = 0; !try_pop(value); spins++) {
+                backoff(spins);
+            }
+            return value;
+        }
+
+    private:
+        struct Cell {
+            std::atomic<size_t> sequence;
+            T value;
+        };
+
+        std::unique_ptr<Cell[]> cells_;
+        size_t mask_ = 0;
+        alignas(kCacheLine) std::atomic<size_t> enqueue_pos_{0};
+        alignas(kCacheLine) std::atomic<size_t> dequeue_pos_{0};
+    };
+}
+
+#endif // BOUNDED_QUEUE_H
@@ -0,0 +1,822 @@
+#include "compressed_io.h"
+#include "mem_budget.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef MULTILANG_HAVE_ZSTD
+#include <zstd.h>
+#endif
+#ifdef MULTILANG_HAVE_LZ4
+#include <lz4frame.h>
+#endif
+
+// Codec threads for compressed input and output
+//
+// Each direction hands whole buffers ("slots") between the caller and one
+// helper thread through a mutex and two condition variables, like the thread
+// fallback of async_input.c: the helper decodes into (or compresses out of)
+// one slot while the caller works on the other, so neither waits for the
+// other as long as both keep up.
+//
+// Slots, the compressed-side buffers and the codec contexts are charged to
+// the --max-mem budget (mem_budget.h). The slots and buffers shrink under a
+// small budget, and so does the zstd compressor's window; the decoders need
+// whatever window the frame was written with. Context memory is charged by
+// the helper thread as the codec allocates it: ZSTD_sizeof_*Stream() for
+// zstd, the frame's block buffers for lz4 (which has no such query).
+
+#define ZSLOTS 2
+#define ZSLOT_SIZE (1u << 20)      // decoded or uncompressed bytes per handoff
+#define ZSLOT_MIN_SIZE (16u * 1024u)
+#define ZREAD_SIZE (128u * 1024u)  // compressed bytes per fread()
+#define ZSTD_LEVEL 1               // names compress well even at the fastest setting
+#define ZSTD_MAX_WINDOW_LOG 19     // what ZSTD_LEVEL picks for large inputs
+#define LZ4_BLOCK (64u * 1024u)    // input per LZ4F_compressUpdate() call
+#define LZ4_HISTORY (64u * 1024u)  // linked blocks keep this much of the previous one
+#define LZ4_STATE (16u * 1024u)    // LZ4_stream_t of the compressor (about 16 KiB)
+
+static const unsigned char ZSTD_MAGIC[ML_CODEC_MAGIC_LEN] = {0x28, 0xB5, 0x2F, 0xFD};
+static const unsigned char LZ4_MAGIC[ML_CODEC_MAGIC_LEN] = {0x04, 0x22, 0x4D, 0x18};
+
+ml_codec ml_codec_detect(const void *head, size_t len) {
+    if (len < ML_CODEC_MAGIC_LEN) {
+        return ML_CODEC_NONE;
+    }
+    if (memcmp(head, ZSTD_MAGIC, ML_CODEC_MAGIC_LEN) == 0) {
+        return ML_CODEC_ZSTD;
+    }
+    if (memcmp(head, LZ4_MAGIC, ML_CODEC_MAGIC_LEN) == 0) {
+        return ML_CODEC_LZ4;
+    }
+    return ML_CODEC_NONE;
+}
+
+int ml_codec_supported(ml_codec codec) {
+    switch (codec) {
+        case ML_CODEC_NONE:
+            return 1;
+        case ML_CODEC_ZSTD:
+#ifdef MULTILANG_HAVE_ZSTD
+            return 1;
+#else
+            return 0;
+#endif
+        case ML_CODEC_LZ4:
+#ifdef MULTILANG_HAVE_LZ4
+            return 1;
+#else
+            return 0;
+#endif
+    }
+    return 0;
+}
+
+const char *ml_codec_name(ml_codec codec) {
+    switch (codec) {
+        case ML_CODEC_ZSTD:
+            return "zstd";
+        case ML_CODEC_LZ4:
+            return "lz4";
+        case ML_CODEC_NONE:
+            break;
+    }
+    return "none";
+}
+
+int ml_codec_parse(const char *name, ml_codec *codec) {
+    if (strcmp(name, "zstd") == 0) {
+        *codec = ML_CODEC_ZSTD;
+    } else if (strcmp(name, "lz4") == 0) {
+        *codec = ML_CODEC_LZ4;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Halves the default slot until both slots take at most a quarter of what
+ * is left of a --max-mem budget
+ */
+static size_t budget_slot_size(void) {
+    size_t size = ZSLOT_SIZE;
+    while (size > ZSLOT_MIN_SIZE && size > ml_mem_available() / (4 * ZSLOTS)) {
+        size /= 2;
+    }
+    return size;
+}
+
+typedef struct {
+    char *data;
+    size_t len;
+    unsigned flags;  // ZW_* for writer slots
+} zslot;
+
+/**
+ * Allocates and charges `ZSLOTS` slots of `size` bytes
+ *
+ * @return 0 on success, -1 on allocation failure (nothing is left allocated)
+ */
+static int alloc_slots(zslot *slots, size_t size) {
+    for (unsigned i = 0; i < ZSLOTS; i++) {
+        slots[i].data = malloc(size);
+        slots[i].len = 0;
+        slots[i].flags = 0;
+        if (slots[i].data == NULL) {
+            while (i-- > 0) {
+                free(slots[i].data);
+            }
+            return -1;
+        }
+    }
+    ml_mem_charge(ZSLOTS * size);
+    return 0;
+}
+
+static void free_slots(zslot *slots, size_t size) {
+    for (unsigned i = 0; i < ZSLOTS; i++) {
+        free(slots[i].data);
+    }
+    ml_mem_release(ZSLOTS * size);
+}
+
+/**
+ * Brings the charge for a codec context up to `now` bytes. Contexts only
+ * grow (they keep their largest buffers), so neither does the charge.
+ */
+static void charge_context(size_t *charged, size_t now) {
+    if (now > *charged) {
+        ml_mem_charge(now - *charged);
+        *charged = now;
+    }
+}
+
+#ifdef MULTILANG_HAVE_LZ4
+/**
+ * @return Bytes of one lz4 block of size `id`
+ */
+static size_t lz4_block_size(LZ4F_blockSizeID_t id) {
+    switch (id) {
+        case LZ4F_max256KB:
+            return 256u * 1024u;
+        case LZ4F_max1MB:
+            return 1024u * 1024u;
+        case LZ4F_max4MB:
+            return 4096u * 1024u;
+        default:
+            return 64u * 1024u;  // LZ4F_max64KB and LZ4F_default
+    }
+}
+#endif
+
+// ============================================================================
+// DECOMPRESSING READER
+// ============================================================================
+
+struct ml_zreader {
+    FILE *stream;
+    ml_codec codec;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t filled;   // the helper published a slot (or finished)
+    pthread_cond_t drained;  // the caller gave a slot back (or asked to stop)
+    zslot slots[ZSLOTS];
+    size_t slot_size;
+    unsigned head;           // next slot the caller reads (guarded by lock)
+    unsigned ready;          // published slots (guarded by lock)
+    size_t read_pos;         // caller's offset into slots[head]
+    int done;                // helper published its last slot (guarded by lock)
+    int failed;              // guarded by lock
+    int stop;                // guarded by lock
+
+    // Helper thread only
+    unsigned tail;           // next slot the helper fills
+    char *in;                // compressed input
+    size_t in_cap;
+    size_t in_len;
+    size_t in_pos;
+    int in_eof;
+    int frame_open;          // a frame has started but not ended
+    size_t ctx_charged;      // codec context memory charged so far
+#ifdef MULTILANG_HAVE_ZSTD
+    ZSTD_DCtx *zstd;
+#endif
+#ifdef MULTILANG_HAVE_LZ4
+    LZ4F_dctx *lz4;
+#endif
+};
+
+/**
+ * Decodes as much of in[in_pos, in_len) as fits into dst[0, cap)
+ *
+ * @return 0 on success, -1 on corrupt input
+ */
+static int decode_step(ml_zreader *r, char *dst, size_t cap, size_t *made) {
+#ifdef MULTILANG_HAVE_ZSTD
+    if (r->codec == ML_CODEC_ZSTD) {
+        ZSTD_inBuffer in = {r->in, r->in_len, r->in_pos};
+        ZSTD_outBuffer out = {dst, cap, 0};
+        size_t hint = ZSTD_decompressStream(r->zstd, &out, &in);
+        if (ZSTD_isError(hint)) {
+            return -1;
+        }
+        if (in.pos != r->in_pos || out.pos != 0) {
+            r->frame_open = hint != 0;
+        }
+        r->in_pos = in.pos;
+        *made = out.pos;
+        return 0;
+    }
+#endif
+#ifdef MULTILANG_HAVE_LZ4
+    if (r->codec == ML_CODEC_LZ4) {
+        size_t dst_size = cap;
+        size_t src_size = r->in_len - r->in_pos;
+        size_t hint = LZ4F_decompress(r->lz4, dst, &dst_size, r->in + r->in_pos, &src_size, NULL);
+        if (LZ4F_isError(hint)) {
+            return -1;
+        }
+        // Between frames the hint is the next header's size, not "incomplete"
+        if (src_size != 0 || dst_size != 0) {
+            r->frame_open = hint != 0;
+        }
+        r->in_pos += src_size;
+        *made = dst_size;
+        return 0;
+    }
+#endif
+    (void)r;
+    (void)dst;
+    (void)cap;
+    *made = 0;
+    return -1;
+}
+
+/**
+ * @return Bytes the decoder context holds now (lz4: as far as the frame
+ *         header tells; between frames, what the last frame needed)
+ */
+static size_t decoder_memory(ml_zreader *r) {
+#ifdef MULTILANG_HAVE_ZSTD
+    if (r->codec == ML_CODEC_ZSTD) {
+        return ZSTD_sizeof_DStream(r->zstd);
+    }
+#endif
+#ifdef MULTILANG_HAVE_LZ4
+    if (r->codec == ML_CODEC_LZ4) {
+        LZ4F_frameInfo_t info;
+        size_t no_input = 0;
+        if (LZ4F_isError(LZ4F_getFrameInfo(r->lz4, &info, NULL, &no_input))) {
+            return r->ctx_charged;  // no header decoded right now
+        }
+        // Input and output block buffers, plus the previous block's history
+        size_t block = lz4_block_size(info.blockSizeID);
+        return 2 * block + (info.blockMode == LZ4F_blockLinked ? 2 * LZ4_HISTORY : 0);
+    }
+#endif
+    (void)r;
+    return 0;
+}
+
+/**
+ * Fills one slot with decoded data
+ *
+ * @return 1 if the input has ended (or failed), 0 if there may be more
+ */
+static int decode_slot(ml_zreader *r, zslot *slot, int *failed) {
+    slot->len = 0;
+    while (slot->len < r->slot_size) {
+        if (r->in_pos == r->in_len && !r->in_eof) {
+            r->in_len = fread(r->in, 1, r->in_cap, r->stream);
+            r->in_pos = 0;
+            if (r->in_len == 0) {
+                r->in_eof = 1;
+                *failed = ferror(r->stream) != 0;
+            }
+        }
+        size_t made = 0;
+        if (decode_step(r, slot->data + slot->len, r->slot_size - slot->len, &made) != 0) {
+            *failed = 1;
+            return 1;
+        }
+        slot->len += made;
+        if (made == 0 && r->in_pos == r->in_len && r->in_eof) {
+            *failed = *failed || r->frame_open;  // truncated frame
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void *zreader_main(void *arg) {
+    ml_zreader *r = arg;
+    for (;;) {
+        pthread_mutex_lock(&r->lock);
+        while (r->ready == ZSLOTS && !r->stop) {
+            pthread_cond_wait(&r->drained, &r->lock);
+        }
+        int stop = r->stop;
+        pthread_mutex_unlock(&r->lock);
+        if (stop) {
+            break;
+        }
+
+        // The caller does not touch a slot until it is published
+        zslot *slot = &r->slots[r->tail];
+        int failed = 0;
+        int end = decode_slot(r, slot, &failed);
+        charge_context(&r->ctx_charged, decoder_memory(r));
+
+        pthread_mutex_lock(&r->lock);
+        if (slot->len > 0) {
+            r->tail = (r->tail + 1) % ZSLOTS;
+            r->ready++;
+        }
+        r->done = end;
+        r->failed = failed;
+        pthread_cond_signal(&r->filled);
+        pthread_mutex_unlock(&r->lock);
+        if (end) {
+            break;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Creates the codec context of `codec`
+ *
+ * @return 0 on success, -1 if it is not built in (errno = ENOTSUP) or
+ *         allocation failed
+ */
+static int open_decoder(ml_zreader *r) {
+    switch (r->codec) {
+#ifdef MULTILANG_HAVE_ZSTD
+        case ML_CODEC_ZSTD:
+            r->zstd = ZSTD_createDCtx();
+            return r->zstd != NULL ? 0 : (errno = ENOMEM, -1);
+#endif
+#ifdef MULTILANG_HAVE_LZ4
+        case ML_CODEC_LZ4:
+            return LZ4F_isError(LZ4F_createDecompressionContext(&r->lz4, LZ4F_VERSION)) ? (errno = ENOMEM, -1) : 0;
+#endif
+        default:
+            errno = ENOTSUP;
+            return -1;
+    }
+}
+
+static void close_decoder(ml_zreader *r) {
+#ifdef MULTILANG_HAVE_ZSTD
+    ZSTD_freeDCtx(r->zstd);
+#endif
+#ifdef MULTILANG_HAVE_LZ4
+    LZ4F_freeDecompressionContext(r->lz4);
+#endif
+    (void)r;
+}
+
+ml_zreader *ml_zreader_create(FILE *stream, ml_codec codec, const void *prefix, size_t prefix_len) {
+    if (!ml_codec_supported(codec) || codec == ML_CODEC_NONE) {
+        errno = ENOTSUP;
+        return NULL;
+    }
+    ml_zreader *r = calloc(1, sizeof(*r));
+    if (r == NULL) {
+        return NULL;
+    }
+    r->stream = stream;
+    r->codec = codec;
+    r->slot_size = budget_slot_size();
+    size_t read_size = r->slot_size < ZREAD_SIZE ? r->slot_size : ZREAD_SIZE;  // shrinks with a budget too
+    r->in_cap = prefix_len > read_size ? prefix_len : read_size;
+    r->in = malloc(r->in_cap);
+    if (r->in == NULL || open_decoder(r) != 0 || alloc_slots(r->slots, r->slot_size) != 0) {
+        int saved_errno = errno;
+        close_decoder(r);
+        free(r->in);
+        free(r);
+        errno = saved_errno;
+        return NULL;
+    }
+    ml_mem_charge(r->in_cap);
+    if (prefix_len > 0) {
+        memcpy(r->in, prefix, prefix_len);
+    }
+    r->in_len = prefix_len;
+
+    pthread_mutex_init(&r->lock, NULL);
+    pthread_cond_init(&r->filled, NULL);
+    pthread_cond_init(&r->drained, NULL);
+    if (pthread_create(&r->thread, NULL, zreader_main, r) != 0) {
+        pthread_cond_destroy(&r->drained);
+        pthread_cond_destroy(&r->filled);
+        pthread_mutex_destroy(&r->lock);
+        free_slots(r->slots, r->slot_size);
+        ml_mem_release(r->in_cap);
+        close_decoder(r);
+        free(r->in);
+        free(r);
+        errno = EAGAIN;
+        return NULL;
+    }
+    return r;
+}
+
+size_t ml_zreader_read(ml_zreader *r, void *buf, size_t len) {
+    if (r == NULL || len == 0) {
+        return 0;
+    }
+    pthread_mutex_lock(&r->lock);
+    while (r->ready == 0 && !r->done) {
+        pthread_cond_wait(&r->filled, &r->lock);
+    }
+    if (r->ready == 0) {
+        pthread_mutex_unlock(&r->lock);
+        return 0;
+    }
+    zslot *slot = &r->slots[r->head];
+    pthread_mutex_unlock(&r->lock);
+
+    // A published slot is the caller's until it is handed back
+    size_t n = slot->len - r->read_pos;
+    n = n < len ? n : len;
+    memcpy(buf, slot->data + r->read_pos, n);
+    r->read_pos += n;
+    if (r->read_pos == slot->len) {
+        r->read_pos = 0;
+        pthread_mutex_lock(&r->lock);
+        r->head = (r->head + 1) % ZSLOTS;
+        r->ready--;
+        pthread_cond_signal(&r->drained);
+        pthread_mutex_unlock(&r->lock);
+    }
+    return n;
+}
+
+int ml_zreader_failed(ml_zreader *r) {
+    pthread_mutex_lock(&r->lock);
+    int failed = r->failed;
+    pthread_mutex_unlock(&r->lock);
+    return failed;
+}
+
+void ml_zreader_destroy(ml_zreader *r) {
+    if (r == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&r->lock);
+    r->stop = 1;
+    pthread_cond_signal(&r->drained);
+    pthread_mutex_unlock(&r->lock);
+    pthread_join(r->thread, NULL);
+
+    pthread_cond_destroy(&r->drained);
+    pthread_cond_destroy(&r->filled);
+    pthread_mutex_destroy(&r->lock);
+    free_slots(r->slots, r->slot_size);
+    ml_mem_release(r->in_cap + r->ctx_charged);
+    close_decoder(r);
+    free(r->in);
+    free(r);
+}
+
+// ============================================================================
+// COMPRESSING WRITER
+// ============================================================================
+
+#define ZW_FLUSH 0x1u  // compress and write everything so far
+#define ZW_END   0x2u  // end the frame; the helper exits after this slot
+
+struct ml_zwriter {
+    int fd;
+    ml_codec codec;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t filled;   // the caller queued a slot
+    pthread_cond_t drained;  // the helper is done with a slot
+    zslot slots[ZSLOTS];
+    size_t slot_size;
+    unsigned head;           // next slot the helper compresses (guarded by lock)
+    unsigned queued;         // guarded by lock
+    int failed;              // guarded by lock
+
+    // Caller only
+    unsigned fill;           // slot being filled
+    int filling;             // slots[fill] is taken by the caller
+
+    // Helper thread only
+    char *out;               // compressed output
+    size_t out_cap;
+    int started;             // the frame header is written (lz4)
+    size_t ctx_charged;      // codec context memory charged so far
+#ifdef MULTILANG_HAVE_ZSTD
+    ZSTD_CCtx *zstd;
+#endif
+#ifdef MULTILANG_HAVE_LZ4
+    LZ4F_cctx *lz4;
+#endif
+};
+
+#if defined(MULTILANG_HAVE_ZSTD) || defined(MULTILANG_HAVE_LZ4)
+/**
+ * Writes all of data[0, len), retrying on partial writes and EINTR
+ */
+static int write_full(int fd, const char *data, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, data, len);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+#endif
+
+#ifdef MULTILANG_HAVE_LZ4
+// autoFlush: every LZ4F_compressUpdate() call (one LZ4_BLOCK) becomes a
+// block right away, so the context needs no block buffer of its own
+static const LZ4F_preferences_t LZ4_PREFS = {
+    .frameInfo = {.blockSizeID = LZ4F_max64KB, .contentChecksumFlag = LZ4F_contentChecksumEnabled},
+    .autoFlush = 1,
+};
+#endif
+
+/**
+ * Compresses one slot and writes the result
+ *
+ * @return 0 on success, -1 on a codec or write error
+ */
+static int encode_slot(ml_zwriter *w, const zslot *slot) {
+#ifdef MULTILANG_HAVE_ZSTD
+    if (w->codec == ML_CODEC_ZSTD) {
+        ZSTD_EndDirective mode = (slot->flags & ZW_END) ? ZSTD_e_end
+                               : (slot->flags & ZW_FLUSH) ? ZSTD_e_flush : ZSTD_e_continue;
+        ZSTD_inBuffer in = {slot->data, slot->len, 0};
+        size_t left;
+        do {
+            ZSTD_outBuffer out = {w->out, w->out_cap, 0};
+            left = ZSTD_compressStream2(w->zstd, &out, &in, mode);
+            if (ZSTD_isError(left) || write_full(w->fd, w->out, out.pos) != 0) {
+                return -1;
+            }
+        } while (mode == ZSTD_e_continue ? in.pos < in.size : left != 0);
+        return 0;
+    }
+#endif
+#ifdef MULTILANG_HAVE_LZ4
+    if (w->codec == ML_CODEC_LZ4) {
+        size_t n;
+        if (!w->started) {
+            n = LZ4F_compressBegin(w->lz4, w->out, w->out_cap, &LZ4_PREFS);
+            if (LZ4F_isError(n) || write_full(w->fd, w->out, n) != 0) {
+                return -1;
+            }
+            w->started = 1;
+        }
+        for (size_t pos = 0; pos < slot->len; pos += LZ4_BLOCK) {
+            size_t piece = slot->len - pos < LZ4_BLOCK ? slot->len - pos : LZ4_BLOCK;
+            n = LZ4F_compressUpdate(w->lz4, w->out, w->out_cap, slot->data + pos, piece, NULL);
+            if (LZ4F_isError(n) || write_full(w->fd, w->out, n) != 0) {
+                return -1;
+            }
+        }
+        if (slot->flags & (ZW_FLUSH | ZW_END)) {
+            n = (slot->flags & ZW_END) ? LZ4F_compressEnd(w->lz4, w->out, w->out_cap, NULL)
+                                       : LZ4F_flush(w->lz4, w->out, w->out_cap, NULL);
+            if (LZ4F_isError(n) || write_full(w->fd, w->out, n) != 0) {
+                return -1;
+            }
+        }
+        return 0;
+    }
+#endif
+    (void)w;
+    (void)slot;
+    return -1;
+}
+
+/**
+ * @return Bytes the encoder context holds now
+ */
+static size_t encoder_memory(ml_zwriter *w) {
+#ifdef MULTILANG_HAVE_ZSTD
+    if (w->codec == ML_CODEC_ZSTD) {
+        return ZSTD_sizeof_CStream(w->zstd);
+    }
+#endif
+#ifdef MULTILANG_HAVE_LZ4
+    if (w->codec == ML_CODEC_LZ4) {
+        return w->started ? LZ4_HISTORY + LZ4_STATE : 0;
+    }
+#endif
+    (void)w;
+    return 0;
+}
+
+static void *zwriter_main(void *arg) {
+    ml_zwriter *w = arg;
+    int failed = 0;
+    for (;;) {
+        pthread_mutex_lock(&w->lock);
+        while (w->queued == 0) {
+            pthread_cond_wait(&w->filled, &w->lock);
+        }
+        zslot *slot = &w->slots[w->head];
+        pthread_mutex_unlock(&w->lock);
+
+        // After a failure the rest is dropped, but slots keep coming back
+        // so the caller never blocks
+        failed = failed || encode_slot(w, slot) != 0;
+        charge_context(&w->ctx_charged, encoder_memory(w));
+        unsigned flags = slot->flags;
+
+        pthread_mutex_lock(&w->lock);
+        w->head = (w->head + 1) % ZSLOTS;
+        w->queued--;
+        w->failed = failed;
+        pthread_cond_signal(&w->drained);
+        pthread_mutex_unlock(&w->lock);
+        if (flags & ZW_END) {
+            break;
+        }
+    }
+    return NULL;
+}
+
+#ifdef MULTILANG_HAVE_ZSTD
+/**
+ * Lowers the compressor's window (most of its memory) until it takes at
+ * most a quarter of what is left of a --max-mem budget
+ */
+static int budget_window_log(void) {
+    int log = ZSTD_MAX_WINDOW_LOG;
+    int min_log = ZSTD_cParam_getBounds(ZSTD_c_windowLog).lowerBound;
+    while (log > min_log && ((size_t)1 << log) > ml_mem_available() / 4) {
+        log--;
+    }
+    return log;
+}
+#endif
+
+static int open_encoder(ml_zwriter *w) {
+    switch (w->codec) {
+#ifdef MULTILANG_HAVE_ZSTD
+        case ML_CODEC_ZSTD:
+            w->zstd = ZSTD_createCCtx();
+            if (w->zstd == NULL) {
+                errno = ENOMEM;
+                return -1;
+            }
+            ZSTD_CCtx_setParameter(w->zstd, ZSTD_c_compressionLevel, ZSTD_LEVEL);
+            ZSTD_CCtx_setParameter(w->zstd, ZSTD_c_windowLog, budget_window_log());
+            w->out_cap = ZSTD_CStreamOutSize() < w->slot_size ? ZSTD_CStreamOutSize() : w->slot_size;
+            return 0;
+#endif
+#ifdef MULTILANG_HAVE_LZ4
+        case ML_CODEC_LZ4:
+            if (LZ4F_isError(LZ4F_createCompressionContext(&w->lz4, LZ4F_VERSION))) {
+                errno = ENOMEM;
+                return -1;
+            }
+            w->out_cap = LZ4F_compressBound(LZ4_BLOCK, &LZ4_PREFS);  // covers a flush or the end too
+            return 0;
+#endif
+        default:
+            errno = ENOTSUP;
+            return -1;
+    }
+}
+
+static void close_encoder(ml_zwriter *w) {
+#ifdef MULTILANG_HAVE_ZSTD
+    ZSTD_freeCCtx(w->zstd);
+#endif
+#ifdef MULTILANG_HAVE_LZ4
+    LZ4F_freeCompressionContext(w->lz4);
+#endif
+    (void)w;
+}
+
+ml_zwriter *ml_zwriter_create(int fd, ml_codec codec) {
+    if (!ml_codec_supported(codec) || codec == ML_CODEC_NONE) {
+        errno = ENOTSUP;
+        return NULL;
+    }
+    ml_zwriter *w = calloc(1, sizeof(*w));
+    if (w == NULL) {
+        return NULL;
+    }
+    w->fd = fd;
+    w->codec = codec;
+    w->slot_size = budget_slot_size();
+    if (open_encoder(w) != 0 || (w->out = malloc(w->out_cap)) == NULL
+        || alloc_slots(w->slots, w->slot_size) != 0) {
+        int saved_errno = errno;
+        free(w->out);
+        close_encoder(w);
+        free(w);
+        errno = saved_errno;
+        return NULL;
+    }
+    ml_mem_charge(w->out_cap);
+
+    pthread_mutex_init(&w->lock, NULL);
+    pthread_cond_init(&w->filled, NULL);
+    pthread_cond_init(&w->drained, NULL);
+    if (pthread_create(&w->thread, NULL, zwriter_main, w) != 0) {
+        pthread_cond_destroy(&w->drained);
+        pthread_cond_destroy(&w->filled);
+        pthread_mutex_destroy(&w->lock);
+        free_slots(w->slots, w->slot_size);
+        ml_mem_release(w->out_cap);
+        free(w->out);
+        close_encoder(w);
+        free(w);
+        errno = EAGAIN;
+        return NULL;
+    }
+    return w;
+}
+
+/**
+ * Takes a free slot for filling, waiting while the helper has both
+ */
+static zslot *fill_slot(ml_zwriter *w) {
+    if (!w->filling) {
+        pthread_mutex_lock(&w->lock);
+        while (w->queued == ZSLOTS) {
+            pthread_cond_wait(&w->drained, &w->lock);
+        }
+        w->fill = (w->head + w->queued) % ZSLOTS;  // the first slot after the queued ones
+        pthread_mutex_unlock(&w->lock);
+        w->slots[w->fill].len = 0;
+        w->slots[w->fill].flags = 0;
+        w->filling = 1;
+    }
+    return &w->slots[w->fill];
+}
+
+static void queue_slot(ml_zwriter *w, unsigned flags) {
+    zslot *slot = fill_slot(w);
+    slot->flags = flags;
+    w->filling = 0;
+    pthread_mutex_lock(&w->lock);
+    w->queued++;
+    pthread_cond_signal(&w->filled);
+    pthread_mutex_unlock(&w->lock);
+}
+
+int ml_zwriter_write(ml_zwriter *w, const struct iovec *iov, int count, int flush) {
+    for (int i = 0; i < count; i++) {
+        const char *data = iov[i].iov_base;
+        size_t len = iov[i].iov_len;
+        while (len > 0) {
+            zslot *slot = fill_slot(w);
+            size_t n = w->slot_size - slot->len;
+            n = n < len ? n : len;
+            memcpy(slot->data + slot->len, data, n);
+            slot->len += n;
+            data += n;
+            len -= n;
+            if (slot->len == w->slot_size) {
+                queue_slot(w, 0);
+            }
+        }
+    }
+    if (flush) {
+        queue_slot(w, ZW_FLUSH);
+    }
+    pthread_mutex_lock(&w->lock);
+    int failed = w->failed;
+    pthread_mutex_unlock(&w->lock);
+    return failed ? -1 : 0;
+}
+
+int ml_zwriter_finish(ml_zwriter *w) {
+    if (w == NULL) {
+        return 0;
+    }
+    queue_slot(w, ZW_END);
+    pthread_join(w->thread, NULL);
+    int failed = w->failed;
+
+    pthread_cond_destroy(&w->drained);
+    pthread_cond_destroy(&w->filled);
+    pthread_mutex_destroy(&w->lock);
+    free_slots(w->slots, w->slot_size);
+    ml_mem_release(w->out_cap + w->ctx_charged);
+    free(w->out);
+    close_encoder(w);
+    free(w);
+    return failed ? -1 : 0;
+}
@@ -0,0 +1,136 @@
+#ifndef MULTILANG_COMPRESSED_IO_H
+#define MULTILANG_COMPRESSED_IO_H
+
+#include <stddef.h>
+#include <stdio.h>    // for FILE
+#include <sys/uio.h>  // for struct iovec
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ============================================================================
+// STREAMING ZSTD / LZ4 INPUT AND OUTPUT
+// ============================================================================
+// Name dumps are usually stored compressed. Instead of decompressing them
+// into a pipe with a separate process, the batch readers (name_batch.h)
+// recognize a zstd or lz4 frame at the start of their input and decode it
+// themselves, and the buffered output sink (output_sink.h) can compress what
+// it writes (--compress).
+//
+// Both directions run the codec on a helper thread with two buffers: the
+// parser reads one decompressed buffer while the next one is decoded, and
+// the greetings fill one buffer while the previous one is compressed and
+// written.
+//
+// The codecs are found at configure time (libzstd, liblz4; CMake options
+// MULTILANG_ZSTD and MULTILANG_LZ4). A codec that was not built in is still
+// detected, so its input is refused (ENOTSUP) instead of parsed as text.
+
+typedef enum {
+    ML_CODEC_NONE = 0,
+    ML_CODEC_ZSTD = 1,
+    ML_CODEC_LZ4 = 2,
+} ml_codec;
+
+#define ML_CODEC_MAGIC_LEN 4  // bytes ml_codec_detect() needs
+
+/**
+ * Recognizes the frame magic number at `head` (zstd 28 B5 2F FD, lz4 frame
+ * 04 22 4D 18). Neither can start a line of text: 0xB5 is not a UTF-8 lead
+ * byte and 0x04 is a control character.
+ *
+ * @return The codec, or ML_CODEC_NONE (also if `len` < ML_CODEC_MAGIC_LEN)
+ */
+ml_codec ml_codec_detect(const void *head, size_t len);
+
+/**
+ * @return Non-zero if `codec` was built in (ML_CODEC_NONE always is)
+ */
+int ml_codec_supported(ml_codec codec);
+
+/**
+ * @return "zstd", "lz4" or "none"
+ */
+const char *ml_codec_name(ml_codec codec);
+
+/**
+ * Parses "zstd" or "lz4"
+ *
+ * @return 0 on success, -1 for anything else
+ */
+int ml_codec_parse(const char *name, ml_codec *codec);
+
+// ----------------------------------------------------------------------------
+// Decompressing reader
+// ----------------------------------------------------------------------------
+
+typedef struct ml_zreader ml_zreader;
+
+/**
+ * Starts decoding `stream` on a helper thread. `prefix` holds bytes already
+ * read from the start of the stream (e.g. the magic number that identified
+ * it); they are decoded first. Concatenated frames are decoded back to back.
+ * The stream is not closed.
+ *
+ * @return Reader handle, or NULL (errno is ENOTSUP if the codec is not built
+ *         in, ENOMEM otherwise)
+ */
+ml_zreader *ml_zreader_create(FILE *stream, ml_codec codec, const void *prefix, size_t prefix_len);
+
+/**
+ * Copies up to `len` decompressed bytes to `buf`, waiting for the helper
+ * thread if nothing is decoded yet
+ *
+ * @return Bytes copied; 0 at the end of the input or after an error
+ */
+size_t ml_zreader_read(ml_zreader *reader, void *buf, size_t len);
+
+/**
+ * @return Non-zero if reading or decoding failed (corrupt or truncated input)
+ */
+int ml_zreader_failed(ml_zreader *reader);
+
+/**
+ * Stops the helper thread (after the read it may be blocked in) and frees
+ * the reader
+ */
+void ml_zreader_destroy(ml_zreader *reader);
+
+// ----------------------------------------------------------------------------
+// Compressing writer
+// ----------------------------------------------------------------------------
+
+typedef struct ml_zwriter ml_zwriter;
+
+/**
+ * Starts one compressed frame on `fd` (not closed by the writer), written by
+ * a helper thread
+ *
+ * @return Writer handle, or NULL (errno is ENOTSUP if the codec is not built
+ *         in, ENOMEM otherwise)
+ */
+ml_zwriter *ml_zwriter_create(int fd, ml_codec codec);
+
+/**
+ * Queues `count` pieces of uncompressed data; waits only while both buffers
+ * are in use. With `flush`, everything queued so far is compressed and
+ * written without waiting for more input (a zstd/lz4 flush, not the end of
+ * the frame).
+ *
+ * @return 0 on success, -1 if compressing or writing has failed
+ */
+int ml_zwriter_write(ml_zwriter *writer, const struct iovec *iov, int count, int flush);
+
+/**
+ * Ends the frame, waits until it is written and frees the writer
+ *
+ * @return 0 on success, -1 if any compression or write failed
+ */
+int ml_zwriter_finish(ml_zwriter *writer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //MULTILANG_COMPRESSED_IO_H
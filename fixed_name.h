@@ -0,0 +1,147 @@
+#ifndef FIXED_NAME_H
+#define FIXED_NAME_H
+
+// C++-only fixed-capacity name with inline storage
+//
+// FixedName<N> keeps up to N bytes inside the object itself, so returning
+// one by value or storing thousands in a std::vector never touches the heap
+// and keeps neighbouring names on neighbouring cache lines. The length is
+// encoded in the spare byte after the text (see below), so a FixedName<31>
+// is exactly 32 bytes: two per cache line.
+
+#include <algorithm>
+#include <cstddef>
+#include <string_view>
+#include "ml_stats.h"
+#include "output_sink.h"
+#include "greeting_format.h"
+
+namespace InputCpp {
+
+    /**
+     * @brief What FixedName does with a name longer than its capacity
+     */
+    enum class NameOverflow {
+        Truncate,  // keep the first N bytes (minus a partial UTF-8 character)
+        Reject,    // store an empty name
+    };
+
+    namespace detail {
+        /**
+         * @brief constexpr twin of ml_utf8_truncate() (utf8_scan.h): the
+         *        longest prefix of at most `max` bytes that does not end
+         *        inside a multi-byte UTF-8 sequence
+         */
+        constexpr size_t utf8_truncate(std::string_view text, size_t max) noexcept {
+            if (text.size() <= max) {
+                return text.size();
+            }
+            auto continuation = [&](size_t i) {
+                return (static_cast<unsigned char>(text[i]) & 0xC0) == 0x80;
+            };
+            if (!continuation(max)) {
+                return max;
+            }
+            size_t j = max;
+            while (j > 0 && max - j < 3 && continuation(j - 1)) {
+                j--;
+            }
+            return j > 0 && static_cast<unsigned char>(text[j - 1]) >= 0xC0 ? j - 1 : max;
+        }
+    }
+
+    template <size_t N, NameOverflow Policy = NameOverflow::Truncate>
+    class FixedName {
+        static_assert(N > 0 && N < 256, "FixedName capacity must fit in the spare byte");
+
+    public:
+        static constexpr NameOverflow overflow_policy = Policy;
+
+        constexpr FixedName() noexcept {
+            set_size(0);
+        }
+
+        constexpr explicit FixedName(std::string_view text) noexcept {
+            assign(text);
+        }
+
+        /**
+         * @brief Replaces the contents with `text`, applying the overflow policy
+         *
+         * @return true if `text` was stored completely
+         */
+        constexpr bool assign(std::string_view text) noexcept {
+            if (text.size() > N && Policy == NameOverflow::Reject) {
+                set_size(0);
+                return false;
+            }
+            size_t len = detail::utf8_truncate(text, N);
+            std::copy_n(text.data(), len, data_);
+            set_size(len);
+            return len == text.size();
+        }
+
+        static constexpr size_t capacity() noexcept { return N; }
+
+        constexpr size_t size() const noexcept { return N - static_cast<unsigned char>(data_[N]); }
+        constexpr bool empty() const noexcept { return size() == 0; }
+
+        constexpr const char *data() const noexcept { return data_; }
+        constexpr const char *c_str() const noexcept { return data_; }
+        constexpr std::string_view view() const noexcept { return {data_, size()}; }
+        constexpr operator std::string_view() const noexcept { return view(); }
+
+        friend constexpr bool operator==(const FixedName &a, const FixedName &b) noexcept {
+            return a.view() == b.view();
+        }
+
+    private:
+        // data_[N] holds the unused capacity N - size. When the name is full
+        // that is 0, so it doubles as the terminator; otherwise data_[size]
+        // is set to '\0' explicitly.
+        constexpr void set_size(size_t len) noexcept {
+            data_[len] = '\0';
+            data_[N] = static_cast<char>(N - len);
+        }
+
+        char data_[N + 1] = {};
+    };
+
+    static_assert(sizeof(FixedName<31>) == 32, "FixedName<N> must add exactly one byte");
+
+    namespace detail {
+        // Prints `prompt` and reads one line through the shared stdin reader
+        // (get_input_cpp.cpp); the view is valid until the next input call
+        bool prompt_and_read_line(const char *prompt, std::string_view &line);
+    }
+
+    /**
+     * @brief Reads a name into a FixedName<N> and returns it by value
+     *
+     * No heap allocation at all: the line is read in place by the shared
+     * stdin reader and copied once into the returned object. Names longer
+     * than N bytes are handled according to `Policy`.
+     *
+     * @return The name (empty at end of input or when rejected)
+     *
+     * Example usage (C++ only):
+     *   std::vector<InputCpp::FixedName<31>> names;
+     *   names.push_back(InputCpp::ask_name_fixed<31>());
+     */
+    template <size_t N, NameOverflow Policy = NameOverflow::Truncate>
+    FixedName<N, Policy> ask_name_fixed() {
+        MlStats::Scope stats(ML_STATS_ASK_NAME_FIXED);
+
+        FixedName<N, Policy> name;
+        std::string_view input;
+        if (detail::prompt_and_read_line("Enter your name (C++ fixed-capacity version): ", input)) {
+            name.assign(input);
+            stats.bytes_read = input.size() + 1;
+            stats.bytes_copied = name.size() + 1;
+            Greeting::CppFixed::write(ml_stdout_sink(), name.data(), name.size());
+        }
+        return name;
+    }
+}
+
+#endif // FIXED_NAME_H
@@ -1,16 +1,33 @@
 #include "get_input.h"
+#include "output_sink.h"
+#include "greeting_format.h"
+#include "ml_stats.h"
 #include <stdio.h>
 #include <string.h>
 #include <limits.h>
 
 // user input is stored on the stack, (not heap), so it can be accessed directly
 void ask_name(char *name, size_t size) {
+    uint64_t stats_start = ml_stats_begin();
+    size_t bytes_read = 0;
+    size_t len = 0;
+
     printf("Enter your name: ");
     if (size > INT_MAX) {
         size = INT_MAX;
     }
     if (fgets(name, (int) size, stdin) != NULL) {
-        name[strcspn(name, "\n")] = '\0'; // remove newline character
-        printf("Hello, %s!\n", name);
+        len = strcspn(name, "\n");
+        bytes_read = len + (name[len] == '\n');
+        name[len] = '\0'; // remove newline character
+        ml_greeting_write(ml_stdout_sink(), ML_GREETING_C, name, len);
     }
-}
\ No newline at end of file
+
+    // fgets copies straight into the caller's buffer: that is the only copy
+    ml_stats_end(ML_STATS_ASK_NAME, stats_start, bytes_read, bytes_read ? len + 1 : 0);
+}
+
+// Same text ask_name prints, for callers that do their own I/O (server, pipeline)
+size_t greet_name_c(const char *name, size_t len, char *out, size_t cap) {
+    return ml_greeting_format(ML_GREETING_C, name, len, out, cap);
+}
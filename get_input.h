@@ -3,8 +3,20 @@
 
 #include <stddef.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 // declare functions from other files in this header file
 // avoid buffer overflows by specifying the size of the name buffer
 void ask_name(char *name, size_t size);
 
+// Greeting logic of ask_name without any I/O
+// Writes "Hello, <name>!\n" to `out`; returns bytes written, or 0 if `cap` is too small
+size_t greet_name_c(const char *name, size_t len, char *out, size_t cap);
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif //MULTILANG_GET_INPUT_H
@@ -1,47 +1,105 @@
 // C++ implementation of asking for user input using std::string
 #include "get_input_cpp.h"
-#include <iostream>
+#include "line_reader.h"
+#include "output_sink.h"
+#include "greeting_format.h"
+#include "ml_stats.h"
+#include "utf8_scan.h"
 #include <string>
+#include <string_view>
 #include <cstring>
+#include <climits>
 
 // C-compatible function (stack-based, similar to get_input.c)
 extern "C" void ask_name_cpp(char *name, size_t size) {
-    std::cout << "Enter your name (C++ version): ";
+    MlStats::Scope stats(ML_STATS_ASK_NAME_CPP);
+    InputCpp::write_prompt("Enter your name (C++ version): ");
 
     // check size limmit
     if (size > INT_MAX) {
         size = INT_MAX;
     }
-    std::string input;
-    if (std::getline(std::cin, input)) {
-        // copy to buffer, ensuring null termination
-        size_t copy_len = std::min(input.length(), size - 1);
-        std::strncpy(name, input.c_str(), copy_len);
+    std::string_view input;
+    if (InputCpp::LineReader::shared_stdin().read_line(input)) {
+        // copy to buffer, ensuring null termination (never splitting a UTF-8 character)
+        size_t copy_len = ml_utf8_truncate(input.data(), input.length(), size - 1);
+        std::memcpy(name, input.data(), copy_len);
         name[copy_len] = '\0';
+        stats.bytes_read = input.length() + 1;
+        stats.bytes_copied = copy_len + 1;
 
-        std::cout << "Hello from C++,  " << name << "!" << std::endl;
+        Greeting::Cpp::write(ml_stdout_sink(), name, copy_len);
     } else {
         name[0] = '\0'; // Empty string on error
-        std::cerr << "Error: Failed to read input." << std::endl;
+        InputCpp::report_input_error("Error: Failed to read input.");
     }
 }
 
-// Pure C++ version using std::string (not callable from C)
-//namespace InputCpp {
-//    std::string ask_name_string() {
-//        std::cout << "Enter your name (C++ std::string version): ";
-//
-//        std::string name;
-//        if (std::getline(std::cin, name)) {
-//            std::cout << "Hello from C++, " << name << "!" << std::endl;
-//            return name;
-//        }
+// Greeting logic shared with the pipeline workers (no I/O, C-compatible)
+extern "C" size_t greet_name_cpp(const char *name, size_t len, char *out, size_t cap) {
+    // Same text ask_name_cpp prints
+    return Greeting::Cpp::format(name, len, out, cap);
+}
+
+// Zero-copy C++ version (not callable from C)
 //
-//        std::cerr << "Error reading input" << std::endl;
-//        return "";
-//    }
-//}
+// Returns a view straight into the shared LineReader buffer: no allocation
+// and no copy per name. The view is invalidated by the next input call that
+// goes through the shared reader (ask_name_view, ask_name_cpp, ...), so copy
+// it (std::string(view)) if it has to outlive that.
+namespace InputCpp {
+    std::string_view ask_name_view() {
+        MlStats::Scope stats(ML_STATS_ASK_NAME_VIEW);
+        InputCpp::write_prompt("Enter your name (C++ string_view version): ");
+
+        std::string_view name;
+        if (LineReader::shared_stdin().read_line(name)) {
+            stats.bytes_read = name.size() + 1;  // nothing is copied
+            Greeting::CppView::write(ml_stdout_sink(), name);
+            return name;
+        }
+
+        InputCpp::report_input_error("Error reading input");
+        return {};
+    }
+}
+
+// Line input behind InputCpp::ask_name_fixed<N>() (fixed_name.h): the
+// template lives in the header, the I/O stays here
+namespace InputCpp::detail {
+    bool prompt_and_read_line(const char *prompt, std::string_view &line) {
+        InputCpp::write_prompt(prompt);
+        if (LineReader::shared_stdin().read_line(line)) {
+            return true;
+        }
+        InputCpp::report_input_error("Error reading input");
+        return false;
+    }
+}
+
+// Pure C++ version using std::string (not callable from C)
 //
+// Owns its result, so unlike ask_name_view() it stays valid across later
+// input calls. The awaitable counterpart is async_ask_name() (async_name.h).
+namespace InputCpp {
+    std::string ask_name_string() {
+        MlStats::Scope stats(ML_STATS_ASK_NAME_STRING);
+        InputCpp::write_prompt("Enter your name (C++ std::string version): ");
+
+        std::string_view line;
+        if (LineReader::shared_stdin().read_line(line)) {
+            std::string name(line);
+            stats.bytes_read = line.size() + 1;
+            stats.bytes_copied = name.size() + 1;
+            stats.alloc_string(name);
+            Greeting::Cpp::write(ml_stdout_sink(), name);
+            return name;
+        }
+
+        InputCpp::report_input_error("Error reading input");
+        return "";
+    }
+}
 
 
 
@@ -11,13 +11,23 @@ extern "C" {
 // C++ version of ask_name (stack-based, C-compatible)
 void ask_name_cpp(char *name, size_t size);
 
+// Greeting logic of ask_name_cpp without any I/O (C-compatible)
+// Writes "Hello from C++, <name>!\n" to `out`; returns bytes written, or 0 if `cap` is too small
+size_t greet_name_cpp(const char *name, size_t len, char *out, size_t cap);
+
 #ifdef __cplusplus
 }
 
 // C++-only interface using std::string
 #include <string>
+#include <string_view>
 namespace InputCpp {
+    // Owning version; see async_name.h for the awaitable async_ask_name()
     std::string ask_name_string();
+
+    // Zero-copy version: the view points into a reused internal buffer and is
+    // valid only until the next InputCpp/InputCppMem input call
+    std::string_view ask_name_view();
 }
 #endif
 
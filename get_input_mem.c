@@ -1,4 +1,7 @@
 #include "get_input_mem.h"
+#include "output_sink.h"
+#include "greeting_format.h"
+#include "ml_stats.h"
 #include <stdio.h>
 #include <string.h>
 #include <limits.h>
@@ -9,12 +12,16 @@
 
 
 char* ask_name_malloc(size_t size) {
+    uint64_t stats_start = ml_stats_begin();
+
     // Allocates 100 bytes`size` bytes of memory on the heap for the name
     char *name = malloc(size * sizeof(char));
     if (name == NULL) {
         fprintf(stderr, "Failed to allocate memory\n");
+        ml_stats_end(ML_STATS_ASK_NAME_MALLOC, stats_start, 0, 0);
         return NULL;
     }
+    ml_stats_alloc(ML_STATS_ASK_NAME_MALLOC, size * sizeof(char));
 
     printf("Enter your name: ");
     if (size > INT_MAX) {
@@ -23,12 +30,17 @@ char* ask_name_malloc(size_t size) {
 
     // Read user input and store it in the allocated memory
     if (fgets(name, (int) size, stdin) != NULL) {
-        name[strcspn(name, "\n")] = '\0'; // remove newline character
-        printf("Hello, %s!\n", name);
+        size_t len = strcspn(name, "\n");
+        size_t bytes_read = len + (name[len] == '\n');
+        name[len] = '\0'; // remove newline character
+        ml_greeting_write(ml_stdout_sink(), ML_GREETING_C, name, len);
+        ml_stats_end(ML_STATS_ASK_NAME_MALLOC, stats_start, bytes_read, len + 1);
         return name;
     } else {
         // free the allocated memory
         free(name);
+        ml_stats_free(ML_STATS_ASK_NAME_MALLOC);
+        ml_stats_end(ML_STATS_ASK_NAME_MALLOC, stats_start, 0, 0);
         return NULL;
     }
 }
@@ -37,6 +49,7 @@ char* ask_name_malloc(size_t size) {
 void free_name(char *name) {
     if (name != NULL) {
         free(name);
+        ml_stats_free(ML_STATS_ASK_NAME_MALLOC);
     }
 }
 
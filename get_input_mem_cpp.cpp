@@ -6,10 +6,21 @@
 // 3. Pure C++ with std::string (no manual memory management needed)
 
 #include "get_input_mem_cpp.h"
-#include <iostream>
+#include "line_reader.h"
+#include "output_sink.h"
+#include "greeting_format.h"
+#include "ml_stats.h"
+#include "utf8_scan.h"
+#include "get_input_cpp.h"
+#include "line_scan.h"
+#include "mem_budget.h"
 #include <string>
+#include <string_view>
 #include <cstring>
+#include <cstddef>
 #include <cstdlib>
+#include <algorithm>
+#include <climits>
 #include <limits>
 #include <memory>
 
@@ -21,12 +32,16 @@
  * @brief Allocates memory on the heap and reads user input (C-compatible)
  *
  * This function mimics the behavior of get_input_mem.c but uses C++ features
- * internally (std::getline, std::string). The interface remains C-compatible
+ * internally (InputCpp::LineReader, std::string_view). The interface remains C-compatible
  * so it can be called from C code.
  *
  * Memory Management:
  * - Uses malloc() for C compatibility
- * - Caller MUST free the returned pointer using free() or free_name_cpp()
+ * - Caller MUST free the returned pointer using free_name_cpp(), never free():
+ *   the block starts with a small header in front of the name
+ * - Like ask_name_malloc(), the buffer is `size` bytes, cut to what the
+ *   --max-mem budget (mem_budget.h) has left. The header records the bytes
+ *   charged, so free_name_cpp() returns exactly those to the budget.
  *
  * @param size Maximum size of the buffer to allocate (including null terminator)
  * @return char* Pointer to heap-allocated string, or NULL on failure
@@ -42,44 +57,74 @@
 // Demonstrating dynamic string allocation for user input &
 // Buffers I/O operations
 
-extern "C" char* ask_name_cpp_malloc(size_t size) {
-    // Step 1: Allocate memory on the heap using malloc
-    // static_cast converts void* to char* (C++ requires explicit cast)
-    char *name = static_cast<char*>(malloc(size * sizeof(char)));
-
-    // Step 2: Check if allocation succeeded
-    if (name == nullptr) {
-        std::cerr << "Memory allocation failed (C++ version)" << std::endl;
-        return nullptr;  // Return NULL pointer on failure
-    }
+namespace {
+    // Bytes charged for a name, stored just before it. Padded so the name
+    // keeps malloc()'s alignment.
+    union HeapNameHeader {
+        size_t charged;
+        std::max_align_t align;
+    };
+}
 
-    // Step 3: Prompt user for input
-    std::cout << "Enter your name (C++ heap/malloc version): ";
+extern "C" char* ask_name_cpp_malloc(size_t size) {
+    MlStats::Scope stats(ML_STATS_ASK_NAME_CPP_MALLOC);
 
-    // Step 4: Safety check - ensure size doesn't exceed INT_MAX
+    // Step 1: Safety check - ensure size doesn't exceed INT_MAX
     // (fgets in C uses int, so we maintain compatibility)
+    if (size == 0) {
+        return nullptr;
+    }
     if (size > INT_MAX) {
         size = INT_MAX;
     }
 
-    // Step 5: Read input using C++ std::getline (more robust than fgets)
-    std::string input;
-    if (std::getline(std::cin, input)) {
+    // Step 2: Allocate memory on the heap using malloc, capped at what the
+    // memory budget has left (an ordinary name always fits)
+    // static_cast converts void* to char* (C++ requires explicit cast)
+    size_t room = std::max<size_t>(ml_mem_available(), ML_MEM_LINE_FLOOR) - sizeof(HeapNameHeader);
+    size = std::min(size, room);
+    size_t charged = sizeof(HeapNameHeader) + size * sizeof(char);
+    if (ml_mem_try_grow(0, charged) != 0) {
+        InputCpp::report_input_error("Memory budget exceeded (C++ version)");
+        return nullptr;
+    }
+    auto *header = static_cast<HeapNameHeader*>(malloc(charged));
+
+    // Step 3: Check if allocation succeeded
+    if (header == nullptr) {
+        ml_mem_release(charged);
+        InputCpp::report_input_error("Memory allocation failed (C++ version)");
+        return nullptr;  // Return NULL pointer on failure
+    }
+    header->charged = charged;
+    char *name = reinterpret_cast<char*>(header + 1);
+    stats.alloc(size * sizeof(char));
+
+    // Step 4: Prompt user for input
+    InputCpp::write_prompt("Enter your name (C++ heap/malloc version): ");
+
+    // Step 5: Read input through the shared C++ line reader (no iostream
+    // sentry, no temporary std::string; stays in sync with C's fgets)
+    std::string_view input;
+    if (InputCpp::LineReader::shared_stdin().read_line(input)) {
         // Step 6: Copy input to allocated buffer
-        // Use std::min to prevent buffer overflow
-        size_t copy_len = std::min(input.length(), size - 1);
-        std::strncpy(name, input.c_str(), copy_len);
+        // Cap at size - 1 to prevent buffer overflow, backing off to a UTF-8
+        // character boundary so a multi-byte sequence is never cut in half
+        size_t copy_len = ml_utf8_truncate(input.data(), input.length(), size - 1);
+        std::memcpy(name, input.data(), copy_len);
         name[copy_len] = '\0';  // Ensure null termination
+        stats.bytes_read = input.length() + 1;
+        stats.bytes_copied = copy_len + 1;
 
         // Step 7: Confirm input received
-        std::cout << "Hello from C++ (heap), " << name << "!" << std::endl;
+        Greeting::CppHeap::write(ml_stdout_sink(), name, copy_len);
 
         // Step 8: Return pointer to caller (caller owns the memory now)
         return name;
     } else {
         // Step 9: Handle input error
-        std::cerr << "Error reading input" << std::endl;
-        free(name);  // Clean up allocated memory before returning
+        InputCpp::report_input_error("Error reading input");
+        free_name_cpp(name);  // Clean up allocated memory before returning
         return nullptr;
     }
 }
@@ -94,6 +139,8 @@ extern "C" char* ask_name_cpp_malloc(size_t size) {
  * - Provides symmetry with ask_name_cpp_malloc()
  * - Allows for future enhancements (e.g., logging, debugging)
  * - Makes the API more explicit about ownership
+ * - Returns the bytes recorded in the name's header to the memory budget,
+ *   whatever the caller has since written into the name
  *
  * @param name Pointer to heap-allocated string (can be NULL)
  *
@@ -105,12 +152,159 @@ extern "C" char* ask_name_cpp_malloc(size_t size) {
 extern "C" void free_name_cpp(char *name) {
     // Check for NULL pointer before freeing (defensive programming)
     if (name != nullptr) {
-        free(name);  // Return memory to the heap
+        auto *header = reinterpret_cast<HeapNameHeader*>(name) - 1;
+        ml_mem_release(header->charged);
+        free(header);  // Return memory to the heap
+        ml_stats_free(ML_STATS_ASK_NAME_CPP_MALLOC);
         // Note: After this call, 'name' pointer in caller is now dangling
         // Caller should set it to NULL after calling this function
     }
 }
 
+/**
+ * @brief Reads user input into a name arena (C-compatible)
+ *
+ * Same flow as ask_name_cpp_malloc(), but the name is packed into `arena`
+ * using only strlen + 1 bytes instead of a full `size`-byte malloc() block.
+ * All names from one arena are released together.
+ *
+ * @param arena Arena created with name_arena_create()
+ * @param size Maximum buffer size (including null terminator)
+ * @return char* Pointer into the arena, or NULL on failure
+ *
+ * Example usage from C:
+ *   name_arena *arena = name_arena_create(0);
+ *   char *a = ask_name_cpp_arena(arena, 100);
+ *   char *b = ask_name_cpp_arena(arena, 100);
+ *   // ... use a and b ...
+ *   name_arena_destroy(arena);  // frees both at once
+ */
+extern "C" char* ask_name_cpp_arena(name_arena *arena, size_t size) {
+    if (arena == nullptr || size == 0) {
+        return nullptr;
+    }
+    MlStats::Scope stats(ML_STATS_ASK_NAME_CPP_ARENA);
+
+    InputCpp::write_prompt("Enter your name (C++ arena version): ");
+
+    std::string_view input;
+    if (InputCpp::LineReader::shared_stdin().read_line(input)) {
+        size_t copy_len = ml_utf8_truncate(input.data(), input.length(), size - 1);
+        size_t reserved = name_arena_bytes_reserved(arena);
+        char *name = name_arena_strndup(arena, input.data(), copy_len);
+        if (name == nullptr) {
+            InputCpp::report_input_error("Memory allocation failed (C++ version)");
+            return nullptr;
+        }
+        if (name_arena_bytes_reserved(arena) != reserved) {
+            stats.alloc(name_arena_bytes_reserved(arena) - reserved);
+        }
+        stats.bytes_read = input.length() + 1;
+        stats.bytes_copied = copy_len + 1;
+
+        Greeting::CppArena::write(ml_stdout_sink(), name, copy_len);
+        return name;
+    }
+
+    InputCpp::report_input_error("Error reading input");
+    return nullptr;
+}
+
+/**
+ * @brief Reads user input and interns it (C-compatible)
+ *
+ * Every distinct name is copied exactly once, into `table`; a name that was
+ * seen before costs no allocation and returns the very same pointer as last
+ * time, so retained names can be compared with ==.
+ *
+ * @param table Table created with name_intern_create()
+ * @param size Maximum name size (including null terminator)
+ * @return const char* Canonical copy owned by `table`, or NULL on failure
+ *
+ * Example usage from C:
+ *   name_intern *table = name_intern_create(0);
+ *   const char *a = ask_name_cpp_interned(table, 100);
+ *   const char *b = ask_name_cpp_interned(table, 100);
+ *   if (a == b) { ... same name ... }
+ *   name_intern_destroy(table);  // frees every name at once
+ */
+extern "C" const char* ask_name_cpp_interned(name_intern *table, size_t size) {
+    if (table == nullptr || size == 0) {
+        return nullptr;
+    }
+    MlStats::Scope stats(ML_STATS_ASK_NAME_INTERNED);
+
+    InputCpp::write_prompt("Enter your name (C++ interned version): ");
+
+    std::string_view input;
+    if (InputCpp::LineReader::shared_stdin().read_line(input)) {
+        size_t copy_len = ml_utf8_truncate(input.data(), input.length(), size - 1);
+        size_t before = name_intern_count(table);
+        size_t memory = name_intern_memory(table);
+        const char *name = name_intern_add(table, input.data(), copy_len, nullptr);
+        if (name == nullptr) {
+            InputCpp::report_input_error("Memory allocation failed (C++ version)");
+            return nullptr;
+        }
+        if (name_intern_memory(table) > memory) {
+            stats.alloc(name_intern_memory(table) - memory);
+        }
+        stats.bytes_read = input.length() + 1;
+        stats.bytes_copied = name_intern_count(table) != before ? copy_len + 1 : 0;
+
+        Greeting::CppInterned::write(ml_stdout_sink(), name, copy_len);
+        return name;
+    }
+
+    InputCpp::report_input_error("Error reading input");
+    return nullptr;
+}
+
+/**
+ * @brief Greets every name of the batches on `names` into records on `greetings`
+ *
+ * The backend half of the ring hand-off (spsc_ring.h): no call and no copy
+ * per name crosses the language boundary. Names are read straight out of
+ * the input records and greetings are formatted straight into output
+ * records of about kRecordBytes, so each ring operation covers hundreds of
+ * names.
+ *
+ * Example usage (C/C++, the backend on its own thread):
+ *   ml_ring *names = ml_ring_create(0), *greetings = ml_ring_create(0);
+ *   // thread 1: greet_ring_cpp(names, greetings);
+ *   // thread 2: commit name batches to `names`, ml_ring_close(names),
+ *   //           then read greetings until ml_ring_peek_wait() returns NULL
+ */
+extern "C" size_t greet_ring_cpp(ml_ring *names, ml_ring *greetings) {
+    constexpr size_t kRecordBytes = 64 * 1024;
+    constexpr size_t kGreetingOverhead = 32;  // prefix + suffix, with room to spare
+
+    MlRing::Reader in(names);
+    MlRing::Writer out(greetings);
+    size_t record_bytes = std::min(kRecordBytes, out.max_record() / 2);  // small rings (--max-mem) take smaller records
+    size_t total = 0;
+    for (auto batch = in.next(); !batch.empty(); batch = in.next()) {
+        std::span<char> room = out.reserve(record_bytes);
+        size_t used = 0;
+        size_t pos = 0;
+        while (pos < batch.size()) {
+            size_t len = ml_find_newline(batch.data() + pos, batch.size() - pos);
+            size_t need = std::min(len + kGreetingOverhead, out.max_record());
+            if (need > room.size() - used) {
+                out.commit(used);
+                room = out.reserve(std::max(record_bytes, need));  // a long name gets its own record
+                used = 0;
+            }
+            used += greet_name_cpp(batch.data() + pos, len, room.data() + used, room.size() - used);
+            total++;
+            pos += len + 1;
+        }
+        out.commit(used);
+    }
+    out.close();
+    return total;
+}
+
 // ============================================================================
 // PURE C++ FUNCTIONS (NOT callable from C code)
 // ============================================================================
@@ -140,28 +334,32 @@ namespace InputCppMem {
      *   // Memory automatically freed when 'name' goes out of scope!
      */
     std::unique_ptr<char[]> ask_name_unique(size_t size) {
-        std::cout << "Enter your name (C++ unique_ptr version): ";
+        MlStats::Scope stats(ML_STATS_ASK_NAME_UNIQUE);
+        InputCpp::write_prompt("Enter your name (C++ unique_ptr version): ");
 
         // Allocate memory using std::make_unique (C++14 feature)
         // This is safer than 'new' because it's exception-safe
         auto name = std::make_unique<char[]>(size);
+        stats.alloc(size);
 
         // Read input
-        std::string input;
-        if (std::getline(std::cin, input)) {
+        std::string_view input;
+        if (InputCpp::LineReader::shared_stdin().read_line(input)) {
             // Copy to buffer
-            size_t copy_len = std::min(input.length(), size - 1);
-            std::strncpy(name.get(), input.c_str(), copy_len);
+            size_t copy_len = ml_utf8_truncate(input.data(), input.length(), size - 1);
+            std::memcpy(name.get(), input.data(), copy_len);
             name[copy_len] = '\0';
+            stats.bytes_read = input.length() + 1;
+            stats.bytes_copied = copy_len + 1;
 
-            std::cout << "Hello from C++ (unique_ptr), " << name.get() << "!" << std::endl;
+            Greeting::CppUniquePtr::write(ml_stdout_sink(), name.get(), copy_len);
 
             // Return ownership of the unique_ptr to caller
             // Memory will be freed when the returned unique_ptr is destroyed
             return name;
         }
 
-        std::cerr << "Error reading input" << std::endl;
+        InputCpp::report_input_error("Error reading input");
         return nullptr;  // Return empty unique_ptr on error
         // Memory automatically freed here if allocation succeeded
     }
@@ -189,24 +387,52 @@ namespace InputCppMem {
      *   // No cleanup needed - std::string destructor handles everything!
      */
     std::string ask_name_managed() {
-        std::cout << "Enter your name (C++ managed string version): ";
+        MlStats::Scope stats(ML_STATS_ASK_NAME_MANAGED);
+        InputCpp::write_prompt("Enter your name (C++ managed string version): ");
 
-        // std::string automatically manages its own memory
-        // No need to specify size - it grows as needed
-        std::string name;
+        std::string_view input;
 
-        if (std::getline(std::cin, name)) {
-            std::cout << "Hello from C++ (managed), " << name << "!" << std::endl;
+        if (InputCpp::LineReader::shared_stdin().read_line(input)) {
+            // std::string automatically manages its own memory
+            // No need to specify size - it is sized from the line we read,
+            // cut to what the --max-mem budget has left (it frees itself,
+            // so it is not charged: see mem_budget.h)
+            stats.bytes_read = input.length() + 1;
+            size_t available = std::max<size_t>(ml_mem_available(), ML_MEM_LINE_FLOOR);
+            if (input.length() >= available) {
+                input = input.substr(0, ml_utf8_truncate(input.data(), input.length(), available - 1));
+            }
+            std::string name(input);
+            stats.bytes_copied = name.size() + 1;
+            stats.alloc_string(name);
+            Greeting::CppManaged::write(ml_stdout_sink(), name.data(), name.size());
 
             // Return by value - C++11 move semantics make this efficient
             // No copying occurs, ownership is transferred
             return name;
         }
 
-        std::cerr << "Error reading input" << std::endl;
+        InputCpp::report_input_error("Error reading input");
         return "";  // Return empty string on error
         // No cleanup needed - std::string destructor called automatically
     }
+
+    /**
+     * @brief Reads user input and returns the interned copy held by `names`
+     *
+     * The C++ face of ask_name_cpp_interned(): equal names come back as
+     * views with the same data() pointer, valid for the lifetime of `names`.
+     *
+     * Example usage (C++ only):
+     *   InputCppMem::NameInterner names;
+     *   std::vector<std::string_view> seen;
+     *   seen.push_back(InputCppMem::ask_name_interned(names));
+     *   // names.size() counts distinct names, names.memory() their footprint
+     */
+    std::string_view ask_name_interned(NameInterner &names) {
+        const char *name = ask_name_cpp_interned(names.get(), std::numeric_limits<int>::max());
+        return name != nullptr ? std::string_view(name) : std::string_view();
+    }
 }
 
 // ============================================================================
@@ -218,6 +444,9 @@ namespace InputCppMem {
 // ask_name_cpp_malloc()         | Heap (malloc)| YES (free_name_cpp) | YES
 // ask_name_unique()             | Heap (new)  | NO (automatic)   | NO
 // ask_name_managed()            | Heap (auto) | NO (automatic)   | NO
+// ask_name_cpp_arena()          | Heap (arena)| YES (arena reset/destroy) | YES
+// ask_name_fixed<N>()           | Inline (value) | NO (automatic) | NO
+// ask_name_cpp_interned()       | Heap (shared)  | YES (name_intern_destroy) | YES
 //
 // ============================================================================
 // WHEN TO USE EACH APPROACH
@@ -238,4 +467,14 @@ namespace InputCppMem {
 //    - You want the simplest, safest approach
 //    - You don't need a C-style buffer
 //
+// 4. InputCpp::ask_name_fixed<N>() (fixed_name.h) - Use when:
+//    - Names have a known upper bound (almost all are under 32 bytes)
+//    - You store many names and want them off the heap and contiguous
+//    - Truncating or rejecting longer names is acceptable
+//
+// 5. ask_name_cpp_interned() / ask_name_interned() - Use when:
+//    - The same names repeat many times in the input
+//    - You retain names and want one copy per distinct name
+//    - You compare names a lot (pointer or id equality)
+//
 // ============================================================================
\ No newline at end of file
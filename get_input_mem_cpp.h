@@ -3,17 +3,36 @@
 #define GET_INPUT_MEM_CPP_H
 
 #include <stddef.h>  // for size_t
+#include "name_arena.h"
+#include "name_intern.h"
+#include "spsc_ring.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 // C++ version of ask_name_malloc (heap-based, C-compatible)
+// Release the name with free_name_cpp() only, never free()
 char* ask_name_cpp_malloc(size_t size);
 
-// C++ version of free_name (C-compatible)
+// C++ version of free_name (C-compatible); also refunds the --max-mem budget
 void free_name_cpp(char *name);
 
+// C++ version of ask_name_arena (arena-backed, C-compatible)
+// The name lives in `arena`; release it with name_arena_reset/destroy, never free()
+char* ask_name_cpp_arena(name_arena *arena, size_t size);
+
+// Interning version (C-compatible): returns the table's single shared copy of
+// the name, so repeated names cost no memory and compare equal by pointer.
+// The name lives in `table`; release it with name_intern_destroy, never free()
+const char* ask_name_cpp_interned(name_intern *table, size_t size);
+
+// Ring backend (C-compatible): greets every name in the batches arriving on
+// `names` ('\n'-terminated) with greet_name_cpp() and writes the greetings
+// as records to `greetings`, which it closes once `names` is closed and
+// drained. Returns the number of names greeted. See spsc_ring.h.
+size_t greet_ring_cpp(ml_ring *names, ml_ring *greetings);
+
 #ifdef __cplusplus
 }
 
@@ -23,6 +42,9 @@ void free_name_cpp(char *name);
 namespace InputCppMem {
     std::unique_ptr<char[]> ask_name_unique(size_t size);
     std::string ask_name_managed();
+
+    // Interning version: the view points at `names`' canonical copy
+    std::string_view ask_name_interned(NameInterner &names);
 }
 #endif
 
@@ -3,6 +3,7 @@
 #define MULTILANG_GREET_RUST_H
 
 #include <stddef.h>
+#include "spsc_ring.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -10,6 +11,30 @@ extern "C" {
 
 void ask_name_rust(char *name, size_t size);
 
+// Non-zero once ask_name_rust() has reached the end of stdin
+int ask_name_rust_eof(void);
+
+// Reads many names in one call, with no prompts or greetings: the names are
+// stored NUL-terminated back to back in `buf`, name i starting at offsets[i].
+// `offsets` needs max + 1 entries; offsets[count] is the end of the used
+// part of `buf`, so name i is offsets[i + 1] - offsets[i] - 1 bytes long.
+// Returns the number of names read, 0 at end of input.
+size_t ask_names_rust_batch(char *buf, size_t cap, size_t *offsets, size_t max);
+
+// ask_names_rust_batch() with ML_BATCH_* reader flags (name_batch.h): only
+// ML_BATCH_NORMALIZE is honored, which normalizes each name in `buf` right
+// after it is copied (ml_normalize() in line_scan.h)
+size_t ask_names_rust_batch_flags(char *buf, size_t cap, size_t *offsets, size_t max, unsigned flags);
+
+// Greeting logic of ask_name_rust without any I/O (trims, then formats)
+// Writes "Hello from Rust, <name>!\n" to `out`; returns bytes written, or 0 if `cap` is too small
+size_t greet_name_rust(const char *name, size_t len, char *out, size_t cap);
+
+// Ring backend (spsc_ring.h): greets the '\n'-terminated names of every
+// record on `names` into records on `greetings` until `names` is closed,
+// then closes `greetings`. Returns the number of names greeted.
+size_t greet_ring_rust(ml_ring *names, ml_ring *greetings);
+
 #ifdef __cplusplus
 }
 #endif
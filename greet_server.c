@@ -0,0 +1,732 @@
+#define _GNU_SOURCE  // accept4, SO_REUSEPORT, NI_MAXHOST
+#include "greet_server.h"
+#include "get_input.h"
+#include "get_input_cpp.h"
+#include "greet_rust.h"
+#include "line_scan.h"
+#include "utf8_scan.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <sys/epoll.h>
+#define USE_EPOLL 1
+#else
+#include <sys/event.h>
+#include <sys/time.h>
+#endif
+
+// Event-loop greeting server
+//
+// Sockets are level-triggered: a loop reads every readable connection until
+// EAGAIN, greets each complete line into the connection's output buffer and
+// writes as much as the socket takes. Output that does not fit is kept and
+// the connection is armed for writability; past OUT_HIGH_WATER unsent bytes
+// the loop stops reading from that client until it catches up.
+
+#define DEFAULT_LISTEN "7070"
+#define MAX_NAME_LEN 99          // same limit as the 100-byte buffers in main.c
+#define MAX_LINE 4096            // bytes kept of one line; the rest is dropped
+#define READ_CHUNK (64u * 1024u)
+#define GREETING_SCRATCH (MAX_NAME_LEN + 64)
+#define OUT_HIGH_WATER (1u << 20)
+#define MAX_EVENTS 256
+
+#ifdef MSG_NOSIGNAL
+#define SEND_FLAGS MSG_NOSIGNAL
+#else
+#define SEND_FLAGS 0             // SO_NOSIGPIPE is set per socket instead
+#endif
+
+typedef size_t (*greet_fn)(const char *name, size_t len, char *out, size_t cap);
+
+typedef struct connection {
+    int fd;
+    struct connection *prev;
+    struct connection *next;
+    char in[MAX_LINE];           // start of a line still waiting for its '\n'
+    size_t in_len;
+    char *out;
+    size_t out_len;
+    size_t out_sent;
+    size_t out_cap;
+    int reading;                 // read interest registered (cleared by backpressure)
+    int writing;                 // write interest registered
+    int closing;                 // peer sent EOF: close once the output is sent
+} connection;
+
+typedef struct {
+    int poll_fd;
+    int listen_fd;
+    greet_fn greet;
+    connection *connections;     // every open connection, for shutdown
+    char read_buf[READ_CHUNK];
+} event_loop;
+
+// Tags that tell listener and stop-pipe events apart from connections
+static char listen_tag;
+static char stop_tag;
+
+static int stop_pipe[2] = {-1, -1};
+
+// ============================================================================
+// POLLER (epoll on Linux, kqueue elsewhere)
+// ============================================================================
+
+typedef struct {
+    void *ptr;
+    int readable;
+    int writable;
+    int hangup;
+} poll_event;
+
+static int poller_create(void) {
+#ifdef USE_EPOLL
+    return epoll_create1(EPOLL_CLOEXEC);
+#else
+    return kqueue();
+#endif
+}
+
+/**
+ * Sets the interest of `fd` to (read, write); `added` says whether it is new
+ */
+static int poller_set(int poll_fd, int fd, void *ptr, int read, int write, int added) {
+#ifdef USE_EPOLL
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = (read ? EPOLLIN : 0) | (write ? EPOLLOUT : 0) | EPOLLRDHUP;
+    ev.data.ptr = ptr;
+    return epoll_ctl(poll_fd, added ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, fd, &ev);
+#else
+    (void)added;
+    struct kevent changes[2];
+    EV_SET(&changes[0], fd, EVFILT_READ, EV_ADD | (read ? EV_ENABLE : EV_DISABLE), 0, 0, ptr);
+    EV_SET(&changes[1], fd, EVFILT_WRITE, EV_ADD | (write ? EV_ENABLE : EV_DISABLE), 0, 0, ptr);
+    return kevent(poll_fd, changes, 2, NULL, 0, NULL);
+#endif
+}
+
+/**
+ * Registers a listener; shared listeners wake only one loop per connection
+ */
+static int poller_add_listener(int poll_fd, int fd, void *ptr, int shared) {
+#ifdef USE_EPOLL
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+#ifdef EPOLLEXCLUSIVE
+    if (shared) {
+        ev.events |= EPOLLEXCLUSIVE;
+    }
+#endif
+    ev.data.ptr = ptr;
+    return epoll_ctl(poll_fd, EPOLL_CTL_ADD, fd, &ev);
+#else
+    (void)shared;
+    struct kevent change;
+    EV_SET(&change, fd, EVFILT_READ, EV_ADD, 0, 0, ptr);
+    return kevent(poll_fd, &change, 1, NULL, 0, NULL);
+#endif
+}
+
+static int poller_wait(int poll_fd, poll_event *out, int max) {
+#ifdef USE_EPOLL
+    struct epoll_event events[MAX_EVENTS];
+    int n = epoll_wait(poll_fd, events, max < MAX_EVENTS ? max : MAX_EVENTS, -1);
+    for (int i = 0; i < n; i++) {
+        out[i].ptr = events[i].data.ptr;
+        out[i].readable = (events[i].events & (EPOLLIN | EPOLLRDHUP)) != 0;
+        out[i].writable = (events[i].events & EPOLLOUT) != 0;
+        out[i].hangup = (events[i].events & (EPOLLERR | EPOLLHUP)) != 0;
+    }
+    return n;
+#else
+    struct kevent events[MAX_EVENTS];
+    int n = kevent(poll_fd, NULL, 0, events, max < MAX_EVENTS ? max : MAX_EVENTS, NULL);
+    // kqueue reports the read and write filters of one fd as separate
+    // events: merge them, so run_loop() handles (and may free) a connection
+    // at most once per batch, like with epoll
+    int merged = 0;
+    for (int i = 0; i < n; i++) {
+        int j = 0;
+        while (j < merged && out[j].ptr != events[i].udata) {
+            j++;
+        }
+        if (j == merged) {
+            out[j].ptr = events[i].udata;
+            out[j].readable = 0;
+            out[j].writable = 0;
+            out[j].hangup = 0;
+            merged++;
+        }
+        out[j].readable |= events[i].filter == EVFILT_READ;
+        out[j].writable |= events[i].filter == EVFILT_WRITE;
+        out[j].hangup |= (events[i].flags & EV_ERROR) != 0;
+    }
+    return n < 0 ? n : merged;
+#endif
+}
+
+// ============================================================================
+// CONNECTIONS
+// ============================================================================
+
+static int set_nonblocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags < 0 ? -1 : fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+static void close_connection(event_loop *loop, connection *c) {
+    if (c->prev != NULL) {
+        c->prev->next = c->next;
+    } else {
+        loop->connections = c->next;
+    }
+    if (c->next != NULL) {
+        c->next->prev = c->prev;
+    }
+    close(c->fd);  // also removes it from the poller
+    free(c->out);
+    free(c);
+}
+
+/**
+ * Appends the greeting for one line to the connection's output buffer
+ */
+static int greet_line(event_loop *loop, connection *c, const char *line, size_t len) {
+    if (len > 0 && line[len - 1] == '\r') {
+        len--;  // tolerate CRLF clients (telnet, nc -C)
+    }
+    len = ml_utf8_truncate(line, len, MAX_NAME_LEN);  // never split a character
+
+    if (c->out_cap - c->out_len < GREETING_SCRATCH) {
+        size_t cap = c->out_cap != 0 ? c->out_cap * 2 : 16384;
+        char *grown = realloc(c->out, cap);
+        if (grown == NULL) {
+            return -1;
+        }
+        c->out = grown;
+        c->out_cap = cap;
+    }
+    c->out_len += loop->greet(line, len, c->out + c->out_len, c->out_cap - c->out_len);
+    return 0;
+}
+
+/**
+ * Greets every complete line in data[0, len); keeps a trailing partial line
+ */
+static int consume_input(event_loop *loop, connection *c, const char *data, size_t len) {
+    size_t pos = 0;
+    while (pos < len) {
+        size_t newline = pos + ml_find_newline(data + pos, len - pos);
+        if (newline == len) {
+            // Partial line: keep its start (up to MAX_LINE bytes) for later
+            size_t keep = len - pos;
+            if (keep > MAX_LINE - c->in_len) {
+                keep = MAX_LINE - c->in_len;
+            }
+            memcpy(c->in + c->in_len, data + pos, keep);
+            c->in_len += keep;
+            return 0;
+        }
+
+        int rc;
+        if (c->in_len > 0) {
+            size_t take = newline - pos;
+            if (take > MAX_LINE - c->in_len) {
+                take = MAX_LINE - c->in_len;
+            }
+            memcpy(c->in + c->in_len, data + pos, take);
+            rc = greet_line(loop, c, c->in, c->in_len + take);
+            c->in_len = 0;
+        } else {
+            rc = greet_line(loop, c, data + pos, newline - pos);
+        }
+        if (rc != 0) {
+            return -1;
+        }
+        pos = newline + 1;
+    }
+    return 0;
+}
+
+/**
+ * Sends buffered output and updates the connection's poller interest
+ *
+ * @return 0 to keep the connection, -1 to close it
+ */
+static int flush_output(event_loop *loop, connection *c) {
+    while (c->out_sent < c->out_len) {
+        ssize_t n = send(c->fd, c->out + c->out_sent, c->out_len - c->out_sent, SEND_FLAGS);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            return -1;
+        }
+        c->out_sent += (size_t)n;
+    }
+    if (c->out_sent == c->out_len) {
+        c->out_sent = 0;
+        c->out_len = 0;
+        if (c->closing) {
+            return -1;
+        }
+    }
+
+    int pending = c->out_len - c->out_sent;
+    int want_read = !c->closing && (size_t)pending < OUT_HIGH_WATER;
+    int want_write = pending > 0;
+    if (want_read != c->reading || want_write != c->writing) {
+        c->reading = want_read;
+        c->writing = want_write;
+        if (poller_set(loop->poll_fd, c->fd, c, want_read, want_write, 0) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Reads until the socket is drained
+ *
+ * @return 0 to keep the connection, -1 to close it
+ */
+static int handle_readable(event_loop *loop, connection *c) {
+    for (;;) {
+        ssize_t n = recv(c->fd, loop->read_buf, sizeof(loop->read_buf), 0);
+        if (n > 0) {
+            if (consume_input(loop, c, loop->read_buf, (size_t)n) != 0) {
+                return -1;
+            }
+            if (c->out_len - c->out_sent >= OUT_HIGH_WATER) {
+                break;  // backpressure: flush_output() pauses reading
+            }
+            continue;
+        }
+        if (n == 0) {
+            // Peer is done sending: answer a final unterminated line, then
+            // close once everything is written
+            if (c->in_len > 0 && greet_line(loop, c, c->in, c->in_len) != 0) {
+                return -1;
+            }
+            c->in_len = 0;
+            c->closing = 1;
+            break;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            break;
+        }
+        return -1;
+    }
+    return flush_output(loop, c);
+}
+
+static void accept_connections(event_loop *loop) {
+    for (;;) {
+#ifdef USE_EPOLL
+        int fd = accept4(loop->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+#else
+        int fd = accept(loop->listen_fd, NULL, NULL);
+        if (fd >= 0 && set_nonblocking(fd) != 0) {
+            close(fd);
+            continue;
+        }
+#endif
+        if (fd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;  // EAGAIN (drained, or another loop won the race) or a transient error
+        }
+
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));  // fails harmlessly on Unix sockets
+#ifdef SO_NOSIGPIPE
+        setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+
+        connection *c = calloc(1, sizeof(*c));
+        if (c == NULL) {
+            close(fd);
+            continue;
+        }
+        c->fd = fd;
+        c->reading = 1;
+        if (poller_set(loop->poll_fd, fd, c, 1, 0, 1) != 0) {
+            close(fd);
+            free(c);
+            continue;
+        }
+        c->next = loop->connections;
+        if (c->next != NULL) {
+            c->next->prev = c;
+        }
+        loop->connections = c;
+    }
+}
+
+static void *run_loop(void *arg) {
+    event_loop *loop = arg;
+    poll_event events[MAX_EVENTS];
+
+    int running = 1;
+    while (running) {
+        int n = poller_wait(loop->poll_fd, events, MAX_EVENTS);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("event loop");
+            break;
+        }
+        for (int i = 0; i < n; i++) {
+            if (events[i].ptr == &stop_tag) {
+                running = 0;  // the byte stays in the pipe so every loop sees it
+                continue;
+            }
+            if (events[i].ptr == &listen_tag) {
+                accept_connections(loop);
+                continue;
+            }
+
+            connection *c = events[i].ptr;
+            int rc = 0;
+            if (events[i].readable && c->reading) {
+                rc = handle_readable(loop, c);
+            }
+            if (rc == 0 && events[i].writable) {
+                rc = flush_output(loop, c);
+            }
+            if (rc != 0 || (events[i].hangup && !events[i].readable)) {
+                close_connection(loop, c);
+            }
+        }
+    }
+
+    while (loop->connections != NULL) {
+        close_connection(loop, loop->connections);
+    }
+    return NULL;
+}
+
+// ============================================================================
+// LISTENING SOCKETS
+// ============================================================================
+
+typedef struct {
+    int is_unix;
+    char host[256];
+    char port[32];
+    const char *path;
+} listen_spec;
+
+static int parse_listen(const char *listen, listen_spec *spec) {
+    memset(spec, 0, sizeof(*spec));
+    if (strncmp(listen, "unix:", 5) == 0) {
+        spec->is_unix = 1;
+        spec->path = listen + 5;
+        return spec->path[0] != '\0' ? 0 : -1;
+    }
+
+    const char *colon = strrchr(listen, ':');
+    const char *port = colon != NULL ? colon + 1 : listen;
+    if (colon != NULL) {
+        const char *host = listen;
+        size_t host_len = (size_t)(colon - listen);
+        if (host_len >= 2 && host[0] == '[' && host[host_len - 1] == ']') {
+            host++;            // [::1]:7070
+            host_len -= 2;
+        }
+        if (host_len >= sizeof(spec->host)) {
+            return -1;
+        }
+        memcpy(spec->host, host, host_len);
+    }
+    if (port[0] == '\0' || strlen(port) >= sizeof(spec->port)) {
+        return -1;
+    }
+    strcpy(spec->port, port);
+    return 0;
+}
+
+static int open_unix_listener(const char *path) {
+    struct sockaddr_un addr;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Socket path too long: %s\n", path);
+        return -1;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+
+    // Replace a stale socket from an earlier run, but never any other file
+    struct stat st;
+    if (stat(path, &st) == 0 && S_ISSOCK(st.st_mode)) {
+        unlink(path);
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        listen(fd, SOMAXCONN) != 0 || set_nonblocking(fd) != 0) {
+        perror(path);
+        if (fd >= 0) {
+            close(fd);
+        }
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * Opens one TCP listener on `addr`
+ *
+ * @param reuse_port Request SO_REUSEPORT so several loops can bind the same port
+ */
+static int open_tcp_listener(const struct sockaddr *addr, socklen_t len, int reuse_port) {
+    int fd = socket(addr->sa_family, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+#ifdef SO_REUSEPORT
+    if (reuse_port && setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)) != 0) {
+        close(fd);
+        return -1;
+    }
+#else
+    (void)reuse_port;
+#endif
+    if (bind(fd, addr, len) != 0 || listen(fd, SOMAXCONN) != 0 || set_nonblocking(fd) != 0) {
+        int saved = errno;
+        close(fd);
+        errno = saved;
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * Opens the listener of every loop. With SO_REUSEPORT each loop gets its
+ * own socket on the same port; without it they share one.
+ *
+ * @param shared Set to 1 if all loops share listeners[0]
+ */
+static int open_tcp_listeners(const listen_spec *spec, int *listeners, unsigned count, int *shared) {
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE;
+
+    struct addrinfo *res = NULL;
+    int rc = getaddrinfo(spec->host[0] != '\0' ? spec->host : NULL, spec->port, &hints, &res);
+    if (rc != 0) {
+        fprintf(stderr, "%s:%s: %s\n", spec->host, spec->port, gai_strerror(rc));
+        return -1;
+    }
+
+    // Prefer IPv6 when binding the wildcard address (dual-stack on Linux)
+    struct addrinfo *ai = res;
+    for (struct addrinfo *p = res; p != NULL && spec->host[0] == '\0'; p = p->ai_next) {
+        if (p->ai_family == AF_INET6) {
+            ai = p;
+            break;
+        }
+    }
+
+#ifdef SO_REUSEPORT
+    *shared = count == 1;
+#else
+    *shared = 1;
+#endif
+    listeners[0] = open_tcp_listener(ai->ai_addr, ai->ai_addrlen, !*shared);
+    if (listeners[0] < 0) {
+        perror("listen");
+        freeaddrinfo(res);
+        return -1;
+    }
+
+    // Bind the others to the address the first actually got (port 0 = any)
+    struct sockaddr_storage bound;
+    socklen_t bound_len = sizeof(bound);
+    getsockname(listeners[0], (struct sockaddr *)&bound, &bound_len);
+    for (unsigned i = 1; i < count; i++) {
+        listeners[i] = *shared ? listeners[0]
+                               : open_tcp_listener((struct sockaddr *)&bound, bound_len, 1);
+        if (listeners[i] < 0) {
+            perror("listen");
+            for (unsigned j = 0; j < i; j++) {
+                close(listeners[j]);
+            }
+            freeaddrinfo(res);
+            return -1;
+        }
+    }
+
+    char host[NI_MAXHOST];
+    char port[NI_MAXSERV];
+    if (getnameinfo((struct sockaddr *)&bound, bound_len, host, sizeof(host), port, sizeof(port),
+                    NI_NUMERICHOST | NI_NUMERICSERV) == 0) {
+        fprintf(stderr, "Listening on %s port %s\n", host, port);
+    }
+    freeaddrinfo(res);
+    return 0;
+}
+
+// ============================================================================
+// PUBLIC API
+// ============================================================================
+
+void ml_server_default_options(ml_server_options *opts) {
+    opts->listen = DEFAULT_LISTEN;
+    opts->threads = 0;
+    opts->backend = ML_SERVER_C;
+}
+
+void ml_server_stop(void) {
+    int fd = stop_pipe[1];
+    if (fd >= 0) {
+        char byte = 1;
+        ssize_t ignored = write(fd, &byte, 1);
+        (void)ignored;
+    }
+}
+
+int ml_run_server(const ml_server_options *opts) {
+    ml_server_options config;
+    ml_server_default_options(&config);
+    if (opts != NULL) {
+        config = *opts;
+    }
+    if (config.listen == NULL) {
+        config.listen = DEFAULT_LISTEN;
+    }
+
+    unsigned threads = config.threads;
+    if (threads == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (unsigned)cpus : 1;
+    }
+    greet_fn greet = config.backend == ML_SERVER_RUST ? greet_name_rust
+                   : config.backend == ML_SERVER_CPP  ? greet_name_cpp
+                                                      : greet_name_c;
+
+    listen_spec spec;
+    if (parse_listen(config.listen, &spec) != 0) {
+        fprintf(stderr, "Invalid listen address: %s\n", config.listen);
+        return -1;
+    }
+
+    int *listeners = calloc(threads, sizeof(int));
+    event_loop *loops = calloc(threads, sizeof(event_loop));
+    pthread_t *thread_ids = calloc(threads, sizeof(pthread_t));
+    if (listeners == NULL || loops == NULL || thread_ids == NULL) {
+        fprintf(stderr, "Failed to allocate memory\n");
+        free(listeners);
+        free(loops);
+        free(thread_ids);
+        return -1;
+    }
+
+    int shared = 1;
+    if (spec.is_unix) {
+        listeners[0] = open_unix_listener(spec.path);
+        for (unsigned i = 1; i < threads; i++) {
+            listeners[i] = listeners[0];
+        }
+        if (listeners[0] >= 0) {
+            fprintf(stderr, "Listening on %s\n", spec.path);
+        }
+    } else if (open_tcp_listeners(&spec, listeners, threads, &shared) != 0) {
+        listeners[0] = -1;
+    }
+    if (listeners[0] < 0 || pipe(stop_pipe) != 0) {
+        if (listeners[0] >= 0) {
+            perror("pipe");
+        }
+        free(listeners);
+        free(loops);
+        free(thread_ids);
+        return -1;
+    }
+
+    for (unsigned i = 0; i < threads; i++) {
+        loops[i].poll_fd = -1;
+    }
+    int rc = 0;
+    unsigned started = 0;
+    for (unsigned i = 0; i < threads; i++) {
+        event_loop *loop = &loops[i];
+        loop->listen_fd = listeners[i];
+        loop->greet = greet;
+        loop->poll_fd = poller_create();
+        if (loop->poll_fd < 0 ||
+            poller_add_listener(loop->poll_fd, loop->listen_fd, &listen_tag, shared) != 0 ||
+            poller_add_listener(loop->poll_fd, stop_pipe[0], &stop_tag, 0) != 0) {
+            perror("event loop");
+            rc = -1;
+            break;
+        }
+        // Loop 0 runs on the calling thread
+        if (i > 0 && pthread_create(&thread_ids[i], NULL, run_loop, loop) != 0) {
+            perror("pthread_create");
+            rc = -1;
+            break;
+        }
+        started = i + 1;
+    }
+    fprintf(stderr, "Serving greetings with %u event loop%s\n", started, started == 1 ? "" : "s");
+
+    if (rc == 0) {
+        run_loop(&loops[0]);
+    } else {
+        ml_server_stop();
+    }
+    for (unsigned i = 1; i < started; i++) {
+        pthread_join(thread_ids[i], NULL);
+    }
+
+    for (unsigned i = 0; i < threads; i++) {
+        if (loops[i].poll_fd >= 0) {
+            close(loops[i].poll_fd);
+        }
+        if (i == 0 || !shared) {
+            close(listeners[i]);
+        }
+    }
+    if (spec.is_unix) {
+        unlink(spec.path);
+    }
+    int read_end = stop_pipe[0];
+    int write_end = stop_pipe[1];
+    stop_pipe[0] = -1;
+    stop_pipe[1] = -1;
+    close(read_end);
+    close(write_end);
+
+    free(listeners);
+    free(loops);
+    free(thread_ids);
+    return rc;
+}
@@ -0,0 +1,59 @@
+#ifndef MULTILANG_GREET_SERVER_H
+#define MULTILANG_GREET_SERVER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ============================================================================
+// GREETING SERVER
+// ============================================================================
+// Serves the greeting logic over TCP or a Unix-domain socket so the cost of
+// process startup (banner, iostream init, Rust runtime) is paid once instead
+// of per request. The protocol is line based: every '\n'-terminated name a
+// client sends (a trailing '\r' is dropped) is answered with exactly the
+// line the selected implementation prints, in order.
+//
+// One event loop per thread, each with its own epoll (kqueue on macOS/BSD)
+// instance. TCP loops each own a listening socket bound with SO_REUSEPORT,
+// so the kernel spreads new connections across them; a Unix socket is shared
+// by all loops and accepted non-blocking. Each connection is served entirely
+// by the loop that accepted it, so there is no locking on the hot path.
+
+typedef enum {
+    ML_SERVER_C = 0,     // "Hello, <name>!"           (greet_name_c)
+    ML_SERVER_CPP = 1,   // "Hello from C++, <name>!"  (greet_name_cpp)
+    ML_SERVER_RUST = 2,  // "Hello from Rust, <name>!" (greet_name_rust)
+} ml_server_backend;
+
+typedef struct {
+    const char *listen;   // "PORT", "HOST:PORT" or "unix:PATH"; NULL = "7070"
+    unsigned threads;     // event loops; 0 = one per online CPU
+    ml_server_backend backend;
+} ml_server_options;
+
+/**
+ * Puts the defaults described above into `opts`
+ */
+void ml_server_default_options(ml_server_options *opts);
+
+/**
+ * Serves until ml_server_stop() is called
+ *
+ * @param opts NULL selects the defaults
+ * @return 0 after a clean stop, -1 if the socket could not be set up
+ *         (an error has been printed to stderr)
+ */
+int ml_run_server(const ml_server_options *opts);
+
+/**
+ * Asks a running server to shut down. Async-signal-safe, so it may be
+ * called from a SIGINT/SIGTERM handler.
+ */
+void ml_server_stop(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //MULTILANG_GREET_SERVER_H
@@ -0,0 +1,77 @@
+// Shared greeting formatter: the C ABI over the Greeting::Format table
+#include "greeting_format.h"
+#include <cstring>
+#include <iterator>
+#include <string_view>
+
+namespace Greeting {
+    namespace {
+
+        struct Parts {
+            std::string_view prefix;
+            std::string_view suffix;
+        };
+
+        template <typename F>
+        constexpr Parts parts_of() {
+            return {F::prefix, F::suffix};
+        }
+
+        // Indexed by ml_greeting_style
+        constexpr Parts kStyles[] = {
+            parts_of<C>(),
+            parts_of<Cpp>(),
+            parts_of<Rust>(),
+            parts_of<CppView>(),
+            parts_of<CppFixed>(),
+            parts_of<CppHeap>(),
+            parts_of<CppArena>(),
+            parts_of<CppInterned>(),
+            parts_of<CppUniquePtr>(),
+            parts_of<CppManaged>(),
+        };
+        static_assert(std::size(kStyles) == ML_GREETING_STYLE_COUNT, "one entry per ml_greeting_style");
+
+        // The formats are checked where they are defined, not in each caller
+        constexpr auto kSample = Cpp::text<"Ada">();
+        static_assert(std::string_view(kSample.data(), kSample.size()) == "Hello from C++, Ada!\n");
+
+        const Parts *find_style(ml_greeting_style style) {
+            auto index = static_cast<size_t>(style);
+            return index < std::size(kStyles) ? &kStyles[index] : nullptr;
+        }
+    }
+}
+
+extern "C" size_t ml_greeting_overhead(ml_greeting_style style) {
+    const Greeting::Parts *parts = Greeting::find_style(style);
+    return parts != nullptr ? parts->prefix.size() + parts->suffix.size() : 0;
+}
+
+extern "C" size_t ml_greeting_format(ml_greeting_style style, const char *name, size_t len, char *out, size_t cap) {
+    const Greeting::Parts *parts = Greeting::find_style(style);
+    if (parts == nullptr) {
+        return 0;
+    }
+    size_t total = parts->prefix.size() + len + parts->suffix.size();
+    if (out == nullptr || total > cap) {
+        return 0;
+    }
+    std::memcpy(out, parts->prefix.data(), parts->prefix.size());
+    std::memcpy(out + parts->prefix.size(), name, len);
+    std::memcpy(out + parts->prefix.size() + len, parts->suffix.data(), parts->suffix.size());
+    return total;
+}
+
+extern "C" int ml_greeting_write(ml_sink *sink, ml_greeting_style style, const char *name, size_t len) {
+    const Greeting::Parts *parts = Greeting::find_style(style);
+    if (parts == nullptr) {
+        return -1;
+    }
+    const ml_sink_part sink_parts[3] = {
+        {parts->prefix.data(), parts->prefix.size()},
+        {name, len},
+        {parts->suffix.data(), parts->suffix.size()},
+    };
+    return ml_sink_write_parts(sink, sink_parts, 3);
+}
@@ -0,0 +1,152 @@
+#ifndef MULTILANG_GREETING_FORMAT_H
+#define MULTILANG_GREETING_FORMAT_H
+
+#include <stddef.h>
+#include "output_sink.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ============================================================================
+// SHARED GREETING FORMATTER (C ABI, used by C, C++ and Rust)
+// ============================================================================
+// Every "Hello ..., <name>!\n" line in the project comes from one table of
+// compile-time prefixes and suffixes (Greeting::Format in the C++ section
+// below), so the implementations cannot drift apart and no greeting pays for
+// strlen() or a format string: a greeting is three memcpy()s into a buffer
+// or three parts of one sink write.
+
+// Keep in sync with ML_GREETING_RUST in src/greet_lib.rs
+typedef enum {
+    ML_GREETING_C = 0,           // "Hello, <name>!"
+    ML_GREETING_CPP,             // "Hello from C++, <name>!"
+    ML_GREETING_RUST,            // "Hello from Rust, <name>!"
+    ML_GREETING_CPP_VIEW,        // "Hello from C++ (view), <name>!"
+    ML_GREETING_CPP_FIXED,       // "Hello from C++ (fixed), <name>!"
+    ML_GREETING_CPP_HEAP,        // "Hello from C++ (heap), <name>!"
+    ML_GREETING_CPP_ARENA,       // "Hello from C++ (arena), <name>!"
+    ML_GREETING_CPP_INTERNED,    // "Hello from C++ (interned), <name>!"
+    ML_GREETING_CPP_UNIQUE_PTR,  // "Hello from C++ (unique_ptr), <name>!"
+    ML_GREETING_CPP_MANAGED,     // "Hello from C++ (managed), <name>!"
+    ML_GREETING_STYLE_COUNT
+} ml_greeting_style;
+
+/**
+ * @return Bytes a greeting adds around the name (prefix + suffix), or 0 for
+ *         an unknown style
+ */
+size_t ml_greeting_overhead(ml_greeting_style style);
+
+/**
+ * Writes the greeting for name[0, len) to `out`
+ *
+ * @return Bytes written, or 0 if `cap` is too small or the style is unknown
+ */
+size_t ml_greeting_format(ml_greeting_style style, const char *name, size_t len, char *out, size_t cap);
+
+/**
+ * Writes the greeting for name[0, len) to `sink` as one multi-part write
+ *
+ * @return 0 on success, -1 on a write error or an unknown style
+ */
+int ml_greeting_write(ml_sink *sink, ml_greeting_style style, const char *name, size_t len);
+
+#ifdef __cplusplus
+}
+
+// C++-only interface: the formats themselves, resolved at compile time
+#include <array>
+#include <cstring>
+#include <string_view>
+namespace Greeting {
+    // A string literal held by value, so it can be a template argument
+    template <size_t N>
+    struct Literal {
+        std::array<char, N - 1> bytes{};
+
+        constexpr Literal(const char (&text)[N]) {
+            for (size_t i = 0; i + 1 < N; i++) {
+                bytes[i] = text[i];
+            }
+        }
+
+        constexpr const char *data() const { return bytes.data(); }
+        constexpr size_t size() const { return N - 1; }
+        constexpr std::string_view view() const { return {bytes.data(), N - 1}; }
+    };
+
+    template <Literal Prefix, Literal Suffix = "!\n">
+    struct Format {
+        static constexpr std::string_view prefix = Prefix.view();
+        static constexpr std::string_view suffix = Suffix.view();
+        static constexpr size_t overhead = Prefix.size() + Suffix.size();
+
+        /**
+         * Writes the greeting for name[0, len) to `out`
+         *
+         * @return Bytes written, or 0 if `cap` is too small
+         */
+        static size_t format(const char *name, size_t len, char *out, size_t cap) {
+            size_t total = overhead + len;
+            if (out == nullptr || total > cap) {
+                return 0;
+            }
+            std::memcpy(out, Prefix.data(), Prefix.size());
+            std::memcpy(out + Prefix.size(), name, len);
+            std::memcpy(out + Prefix.size() + len, Suffix.data(), Suffix.size());
+            return total;
+        }
+
+        /**
+         * Writes the greeting for name[0, len) to `sink`
+         *
+         * @return 0 on success, -1 on a write error
+         */
+        static int write(ml_sink *sink, const char *name, size_t len) {
+            const ml_sink_part parts[3] = {
+                {Prefix.data(), Prefix.size()},
+                {name, len},
+                {Suffix.data(), Suffix.size()},
+            };
+            return ml_sink_write_parts(sink, parts, 3);
+        }
+
+        static int write(ml_sink *sink, std::string_view name) {
+            return write(sink, name.data(), name.size());
+        }
+
+        /**
+         * The whole greeting for a name known at compile time
+         */
+        template <Literal Name>
+        static constexpr std::array<char, overhead + Name.size()> text() {
+            std::array<char, overhead + Name.size()> out{};
+            size_t pos = 0;
+            for (char c : prefix) {
+                out[pos++] = c;
+            }
+            for (char c : Name.view()) {
+                out[pos++] = c;
+            }
+            for (char c : suffix) {
+                out[pos++] = c;
+            }
+            return out;
+        }
+    };
+
+    using C = Format<"Hello, ">;
+    using Cpp = Format<"Hello from C++, ">;
+    using Rust = Format<"Hello from Rust, ">;
+    using CppView = Format<"Hello from C++ (view), ">;
+    using CppFixed = Format<"Hello from C++ (fixed), ">;
+    using CppHeap = Format<"Hello from C++ (heap), ">;
+    using CppArena = Format<"Hello from C++ (arena), ">;
+    using CppInterned = Format<"Hello from C++ (interned), ">;
+    using CppUniquePtr = Format<"Hello from C++ (unique_ptr), ">;
+    using CppManaged = Format<"Hello from C++ (managed), ">;
+}
+#endif
+
+#endif //MULTILANG_GREETING_FORMAT_H
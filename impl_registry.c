@@ -0,0 +1,88 @@
+#include "impl_registry.h"
+#include "get_input.h"
+#include "get_input_mem.h"
+#include "get_input_cpp.h"
+#include "get_input_mem_cpp.h"
+#include "greet_rust.h"
+#include "startup_trace.h"
+#include <stdio.h>
+#include <string.h>
+
+// The C and C++ versions share the stdin FILE (see LineReader::shared_stdin)
+static int stdin_at_eof(void) {
+    return feof(stdin) || ferror(stdin);
+}
+
+// Demo order: the sequence main.c runs when no --impl is given
+static const ml_impl ML_IMPLS[] = {
+    {"c",        "C",    "C Stack-based version",            "Stored in C stack",
+     ML_IMPL_STACK, ask_name,     NULL,                NULL,          stdin_at_eof},
+    {"c_heap",   "C",    "C Heap-based version (malloc)",    "Stored in C heap",
+     ML_IMPL_HEAP,  NULL,         ask_name_malloc,     free_name,     stdin_at_eof},
+    {"cpp",      "C++",  "C++ Stack-based version",          "Stored in C++ stack",
+     ML_IMPL_STACK, ask_name_cpp, NULL,                NULL,          stdin_at_eof},
+    {"cpp_heap", "C++",  "C++ Heap-based version (malloc)",  "Stored in C++ heap",
+     ML_IMPL_HEAP,  NULL,         ask_name_cpp_malloc, free_name_cpp, stdin_at_eof},
+    {"rust",     "Rust", "Rust version",                     "Rust returned",
+     ML_IMPL_STACK, ask_name_rust, NULL,               NULL,          ask_name_rust_eof},
+
+    // FUTURE LANGUAGE INTEGRATIONS: one entry each, e.g.
+    // {"python", "Python", "Python version", "Python returned",
+    //  ML_IMPL_STACK, ask_name_python, NULL, NULL, ask_name_python_eof},
+};
+
+#define ML_IMPL_COUNT (sizeof(ML_IMPLS) / sizeof(ML_IMPLS[0]))
+
+size_t ml_impl_count(void) {
+    return ML_IMPL_COUNT;
+}
+
+const ml_impl *ml_impl_at(size_t index) {
+    return index < ML_IMPL_COUNT ? &ML_IMPLS[index] : NULL;
+}
+
+const ml_impl *ml_impl_find(const char *name) {
+    for (size_t i = 0; i < ML_IMPL_COUNT; i++) {
+        if (strcmp(ML_IMPLS[i].name, name) == 0) {
+            return &ML_IMPLS[i];
+        }
+    }
+    return NULL;
+}
+
+void ml_impl_list(char *out, size_t cap) {
+    size_t used = 0;
+    if (cap == 0) {
+        return;
+    }
+    out[0] = '\0';
+    for (size_t i = 0; i < ML_IMPL_COUNT; i++) {
+        int n = snprintf(out + used, cap - used, "%s%s", i > 0 ? "|" : "", ML_IMPLS[i].name);
+        if (n < 0 || (size_t)n >= cap - used) {
+            return;
+        }
+        used += (size_t)n;
+    }
+}
+
+int ml_impl_ask(const ml_impl *impl, char *name, size_t size) {
+    if (size == 0) {
+        return 0;
+    }
+    name[0] = '\0';
+    ml_startup_mark(ML_STARTUP_FIRST_PROMPT);
+    if (impl->kind == ML_IMPL_HEAP) {
+        char *result = impl->ask_heap(size);
+        if (result == NULL) {
+            return 0;
+        }
+        size_t len = strnlen(result, size - 1);
+        memcpy(name, result, len);
+        name[len] = '\0';
+        impl->free_name(result);
+        return 1;
+    }
+    impl->ask(name, size);
+    // A last line without '\n' sets EOF on the read that returned it
+    return name[0] != '\0' || !impl->at_eof();
+}
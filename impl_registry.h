@@ -0,0 +1,67 @@
+#ifndef MULTILANG_IMPL_REGISTRY_H
+#define MULTILANG_IMPL_REGISTRY_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ============================================================================
+// IMPLEMENTATION REGISTRY
+// ============================================================================
+// One table entry per interactive ask_name_* entry point, so a caller picks
+// an implementation by name (--impl=rust) and runs only that one instead of
+// every language in turn. A new language adds its entry to ML_IMPLS in
+// impl_registry.c; nothing else has to change.
+
+typedef enum {
+    ML_IMPL_STACK = 0,  // fills a caller buffer: void ask(char *name, size_t size)
+    ML_IMPL_HEAP,       // returns an allocation: char *ask_heap(size_t size), then free_name()
+} ml_impl_kind;
+
+typedef struct ml_impl {
+    const char *name;       // selector for --impl
+    const char *language;   // section of the demo it belongs to ("C", "C++", "Rust")
+    const char *title;      // e.g. "C Stack-based version"
+    const char *stored_as;  // prefix of the demo's result line, e.g. "Stored in C stack"
+    ml_impl_kind kind;
+    void (*ask)(char *name, size_t size);  // ML_IMPL_STACK
+    char *(*ask_heap)(size_t size);        // ML_IMPL_HEAP
+    void (*free_name)(char *name);         // ML_IMPL_HEAP
+    int (*at_eof)(void);                   // non-zero once the input it reads is exhausted
+} ml_impl;
+
+/**
+ * @return Number of registered implementations
+ */
+size_t ml_impl_count(void);
+
+/**
+ * @return Entry `index` (< ml_impl_count()), in demo order
+ */
+const ml_impl *ml_impl_at(size_t index);
+
+/**
+ * @return The entry called `name`, or NULL if there is none
+ */
+const ml_impl *ml_impl_find(const char *name);
+
+/**
+ * Writes the registered names, separated by '|', to `out` (for usage text)
+ */
+void ml_impl_list(char *out, size_t cap);
+
+/**
+ * Asks for one name with `impl` and leaves it in `name` (heap results are
+ * copied there and freed)
+ *
+ * @return 1 if a name was read, 0 at end of input
+ */
+int ml_impl_ask(const ml_impl *impl, char *name, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //MULTILANG_IMPL_REGISTRY_H
@@ -0,0 +1,109 @@
+#include "latency_histogram.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define BAR_WIDTH 40
+
+static int compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+void ml_sort_u64(uint64_t *samples, size_t count) {
+    qsort(samples, count, sizeof(samples[0]), compare_u64);
+}
+
+uint64_t ml_percentile(const uint64_t *sorted, size_t count, double pct) {
+    if (count == 0) {
+        return 0;
+    }
+    size_t index = (size_t)(pct / 100.0 * (double)(count - 1) + 0.5);
+    return sorted[index];
+}
+
+void ml_latency_init(ml_latency *h) {
+    memset(h, 0, sizeof(*h));
+}
+
+static unsigned bucket_of(uint64_t ns) {
+    unsigned b = 0;
+    while (ns > 1) {
+        ns >>= 1;
+        b++;
+    }
+    return b;
+}
+
+int ml_latency_add(ml_latency *h, uint64_t ns) {
+    if (h->count == h->cap) {
+        size_t cap = h->cap != 0 ? h->cap * 2 : 256;
+        uint64_t *samples = realloc(h->samples, cap * sizeof(samples[0]));
+        if (samples == NULL) {
+            return -1;
+        }
+        h->samples = samples;
+        h->cap = cap;
+    }
+    h->samples[h->count++] = ns;
+    h->sorted = 0;
+    h->buckets[bucket_of(ns)]++;
+    return 0;
+}
+
+uint64_t ml_latency_percentile(ml_latency *h, double pct) {
+    if (!h->sorted) {
+        ml_sort_u64(h->samples, h->count);
+        h->sorted = 1;
+    }
+    return ml_percentile(h->samples, h->count, pct);
+}
+
+/**
+ * Formats `ns` with a unit that keeps it short ("850 ns", "12.5 us", "3.2 s")
+ */
+static void format_duration(uint64_t ns, char *out, size_t cap) {
+    if (ns < 1000) {
+        snprintf(out, cap, "%llu ns", (unsigned long long)ns);
+    } else if (ns < 1000000) {
+        snprintf(out, cap, "%.1f us", (double)ns / 1e3);
+    } else if (ns < 1000000000) {
+        snprintf(out, cap, "%.1f ms", (double)ns / 1e6);
+    } else {
+        snprintf(out, cap, "%.1f s", (double)ns / 1e9);
+    }
+}
+
+void ml_latency_print(const ml_latency *h, FILE *out) {
+    unsigned first = ML_LATENCY_BUCKETS;
+    unsigned last = 0;
+    uint64_t fullest = 0;
+    for (unsigned b = 0; b < ML_LATENCY_BUCKETS; b++) {
+        if (h->buckets[b] != 0) {
+            first = first < b ? first : b;
+            last = b;
+            fullest = fullest > h->buckets[b] ? fullest : h->buckets[b];
+        }
+    }
+    if (first == ML_LATENCY_BUCKETS) {
+        return;
+    }
+
+    for (unsigned b = first; b <= last; b++) {
+        char low[16];
+        char high[16];
+        format_duration(b == 0 ? 0 : (uint64_t)1 << b, low, sizeof(low));
+        format_duration(b + 1 < 64 ? (uint64_t)1 << (b + 1) : UINT64_MAX, high, sizeof(high));
+        int bar = (int)((h->buckets[b] * BAR_WIDTH + fullest - 1) / fullest);
+        char bars[BAR_WIDTH + 1];
+        memset(bars, '#', (size_t)bar);
+        bars[bar] = '\0';
+        fprintf(out, "  %9s - %-9s |%-*s %llu\n", low, high, BAR_WIDTH, bars,
+                (unsigned long long)h->buckets[b]);
+    }
+}
+
+void ml_latency_free(ml_latency *h) {
+    free(h->samples);
+    ml_latency_init(h);
+}
@@ -0,0 +1,66 @@
+#ifndef MULTILANG_LATENCY_HISTOGRAM_H
+#define MULTILANG_LATENCY_HISTOGRAM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ============================================================================
+// LATENCY HISTOGRAM (shared by the benchmark and --replay)
+// ============================================================================
+// Keeps every sample, so percentiles are exact, plus power-of-two buckets
+// for the printed histogram: bucket b counts samples in [2^b, 2^(b+1)) ns
+// (bucket 0 also holds 0 ns).
+
+#define ML_LATENCY_BUCKETS 64
+
+typedef struct {
+    uint64_t *samples;  // sorted by the percentile functions
+    size_t count;
+    size_t cap;
+    int sorted;
+    uint64_t buckets[ML_LATENCY_BUCKETS];
+} ml_latency;
+
+void ml_latency_init(ml_latency *h);
+
+/**
+ * Records one sample of `ns` nanoseconds
+ *
+ * @return 0 on success, -1 if the sample array could not grow
+ */
+int ml_latency_add(ml_latency *h, uint64_t ns);
+
+/**
+ * @return The sample at `pct` percent (0..100), 0 if there are none
+ */
+uint64_t ml_latency_percentile(ml_latency *h, double pct);
+
+/**
+ * Prints one row per bucket from the lowest to the highest one in use,
+ * with a bar scaled to the fullest bucket
+ */
+void ml_latency_print(const ml_latency *h, FILE *out);
+
+void ml_latency_free(ml_latency *h);
+
+/**
+ * Sorts `count` samples in ascending order
+ */
+void ml_sort_u64(uint64_t *samples, size_t count);
+
+/**
+ * @return The value at `pct` percent of `count` ascending samples (nearest
+ *         rank), 0 if `count` is 0
+ */
+uint64_t ml_percentile(const uint64_t *sorted, size_t count, double pct);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //MULTILANG_LATENCY_HISTOGRAM_H
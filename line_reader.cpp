@@ -0,0 +1,194 @@
+// Buffered line input for the C++ implementations
+#include "line_reader.h"
+#include "line_scan.h"
+#include "output_sink.h"
+#include "mem_budget.h"
+#include "utf8_scan.h"
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <stdio.h>     // getline(3)
+#include <unistd.h>    // read(2)
+
+namespace InputCpp {
+
+    LineReader::LineReader(int fd) : fd_(fd) {
+        buf_ = static_cast<char*>(malloc(kBlockSize));
+        cap_ = buf_ != nullptr ? kBlockSize : 0;
+        ml_mem_charge(cap_);
+    }
+
+    LineReader::LineReader(FILE *stream) : stream_(stream) {
+        // getline(3) allocates and grows buf_ on first use
+    }
+
+    LineReader::~LineReader() {
+        ml_mem_release(cap_);
+        free(buf_);
+    }
+
+    bool LineReader::read_line(std::string_view &line) {
+        return stream_ != nullptr ? read_line_stream(line) : read_line_fd(line);
+    }
+
+    bool LineReader::read_line_stream(std::string_view &line) {
+        if (ml_mem_budget() != 0) {
+            return read_line_stream_bounded(line);
+        }
+        // getline(3) locks the stream once and scans its buffer with memchr,
+        // instead of iostream's per-character sgetc/sbumpc through a sentry
+        size_t old_cap = cap_;
+        ssize_t len = ::getline(&buf_, &cap_, stream_);
+        if (cap_ != old_cap) {
+            ml_mem_charge(cap_ - old_cap);  // getline(3) grows without a limit; account for it
+        }
+        if (len < 0) {
+            return false;
+        }
+        if (len > 0 && buf_[len - 1] == '\n') {
+            len--;
+        }
+        line = std::string_view(buf_, static_cast<size_t>(len));
+        return true;
+    }
+
+    bool LineReader::read_line_stream_bounded(std::string_view &line) {
+        // getline(3) cannot be told to stop growing, so under a budget the
+        // line is copied out of the stream's buffer one byte at a time
+        flockfile(stream_);
+        size_t len = 0;
+        int c = EOF;
+        bool cut = false;
+        while ((c = getc_unlocked(stream_)) != EOF && c != '\n') {
+            if (len == cap_) {
+                size_t new_cap = cap_ != 0 ? cap_ * 2 : 128;
+                char *grown = nullptr;
+                if (ml_mem_try_grow(cap_, new_cap) == 0) {
+                    grown = static_cast<char*>(realloc(buf_, new_cap));
+                    if (grown == nullptr) {
+                        ml_mem_release(new_cap - cap_);
+                    }
+                }
+                if (grown == nullptr) {
+                    cut = true;
+                    break;
+                }
+                buf_ = grown;
+                cap_ = new_cap;
+            }
+            buf_[len++] = static_cast<char>(c);
+        }
+        if (cut) {
+            while (c != EOF && c != '\n') {
+                c = getc_unlocked(stream_);  // drop the rest of the cut line
+            }
+            len = len > 0 && static_cast<unsigned char>(buf_[len - 1]) >= 0x80
+                      ? ml_utf8_truncate(buf_, len, len - 1)
+                      : len;
+        }
+        funlockfile(stream_);
+        if (c == EOF && len == 0 && !cut) {
+            return false;
+        }
+        line = std::string_view(buf_, len);
+        return true;
+    }
+
+    bool LineReader::read_line_fd(std::string_view &line) {
+        if (buf_ == nullptr) {
+            return false;
+        }
+
+        size_t scan_from = start_;
+        while (skip_) {
+            // Drop the rest of a line that was cut at the memory budget
+            size_t offset = ml_find_newline(buf_ + start_, end_ - start_);
+            if (offset < end_ - start_) {
+                start_ += offset + 1;
+                scan_from = start_;
+                skip_ = false;
+                break;
+            }
+            start_ = end_ = scan_from = 0;
+            if (eof_ || !fill()) {
+                return false;
+            }
+        }
+        for (;;) {
+            const char *base = buf_ + start_;
+            size_t offset = ml_find_newline(buf_ + scan_from, end_ - scan_from);
+            if (offset < end_ - scan_from) {
+                size_t len = scan_from + offset - start_;
+                line = std::string_view(base, len);
+                start_ += len + 1;
+                return true;
+            }
+
+            if (eof_) {
+                if (start_ == end_) {
+                    return false;
+                }
+                line = std::string_view(base, end_ - start_);  // no trailing '\n'
+                start_ = end_;
+                return true;
+            }
+
+            // Move the partial line to the front; grow if it fills the buffer
+            size_t pending = end_ - start_;
+            if (start_ > 0) {
+                memmove(buf_, buf_ + start_, pending);
+                start_ = 0;
+                end_ = pending;
+            }
+            if (end_ == cap_) {
+                if (ml_mem_try_grow(cap_, cap_ * 2) != 0) {
+                    // Over budget: hand out what is buffered and skip the rest
+                    size_t len = static_cast<unsigned char>(buf_[end_ - 1]) >= 0x80
+                                     ? ml_utf8_truncate(buf_, end_, end_ - 1)
+                                     : end_;
+                    line = std::string_view(buf_, len);
+                    start_ = end_;
+                    skip_ = true;
+                    return true;
+                }
+                char *grown = static_cast<char*>(realloc(buf_, cap_ * 2));
+                if (grown == nullptr) {
+                    ml_mem_release(cap_);
+                    return false;
+                }
+                buf_ = grown;
+                cap_ *= 2;
+            }
+            scan_from = end_;
+            fill();
+        }
+    }
+
+    bool LineReader::fill() {
+        for (;;) {
+            ssize_t got = ::read(fd_, buf_ + end_, cap_ - end_);
+            if (got < 0 && errno == EINTR) {
+                continue;
+            }
+            if (got <= 0) {
+                eof_ = true;
+                return false;
+            }
+            end_ += static_cast<size_t>(got);
+            return true;
+        }
+    }
+
+    LineReader &LineReader::shared_stdin() {
+        static LineReader reader(stdin);
+        return reader;
+    }
+
+    void write_prompt(std::string_view prompt) {
+        ml_sink_write(ml_stdout_sink(), prompt.data(), prompt.size());
+    }
+
+    void report_input_error(const char *message) {
+        fprintf(stderr, "%s\n", message);
+    }
+}
@@ -0,0 +1,96 @@
+
+#ifndef LINE_READER_H
+#define LINE_READER_H
+
+// C++-only buffered line input shared by the C++ implementations
+//
+// Replaces std::getline(std::cin, ...) on the hot paths. std::cin, with
+// sync_with_stdio(true), goes through a sentry and a per-character locked
+// read on every call; LineReader hands out whole lines as std::string_view
+// into a buffer it reuses for the lifetime of the reader.
+//
+// The buffer is charged to the --max-mem budget (mem_budget.h); a line that
+// would grow it past the budget is cut and the rest of it skipped.
+
+#include <cstddef>
+#include <cstdio>
+#include <string_view>
+
+namespace InputCpp {
+
+    class LineReader {
+    public:
+        static constexpr size_t kBlockSize = 64 * 1024;
+
+        /**
+         * @brief Exclusive reader over a file descriptor
+         *
+         * Reads kBlockSize blocks with read(2). Data read ahead stays inside
+         * this reader, so nothing else may read `fd` while it is in use.
+         */
+        explicit LineReader(int fd);
+
+        /**
+         * @brief Reader over a stdio stream shared with C code
+         *
+         * Lines are taken straight out of the stream's own buffer (one lock
+         * per line, no read-ahead of our own), so fgets() calls on the same
+         * FILE before and after stay in sync with this reader.
+         */
+        explicit LineReader(FILE *stream);
+
+        ~LineReader();
+
+        LineReader(const LineReader &) = delete;
+        LineReader &operator=(const LineReader &) = delete;
+
+        /**
+         * @brief Reads the next line without its trailing '\n'
+         *
+         * @param line Set to a view into the internal buffer, valid until
+         *             the next call on this reader
+         * @return false at end of input or on a read error
+         */
+        bool read_line(std::string_view &line);
+
+        /**
+         * @brief The process-wide reader for stdin used by ask_name_cpp & co.
+         *
+         * Stream-backed, so it can be freely mixed with the C fgets() paths
+         * in main.c, which read the same stdin.
+         */
+        static LineReader &shared_stdin();
+
+    private:
+        bool read_line_fd(std::string_view &line);
+        bool read_line_stream(std::string_view &line);
+        bool read_line_stream_bounded(std::string_view &line);
+        bool fill();   // fd mode: one read(2) after end_; false at EOF or error
+
+        int fd_ = -1;
+        FILE *stream_ = nullptr;
+        char *buf_ = nullptr;   // malloc'd: getline(3) may realloc it
+        size_t cap_ = 0;
+        size_t start_ = 0;      // fd mode: first unconsumed byte
+        size_t end_ = 0;        // fd mode: one past the last valid byte
+        bool eof_ = false;
+        bool skip_ = false;     // fd mode: the current line was cut, drop it up to '\n'
+    };
+
+    // Prompt and error output of the C++ implementations. They go through
+    // the shared stdout sink and stdio instead of <iostream>, so no
+    // translation unit carries an ios_base::Init and processes that never
+    // touch C++ input skip the iostream start-up cost.
+
+    /**
+     * @brief Writes `prompt` to stdout (no newline, no flush: reading stdin flushes it)
+     */
+    void write_prompt(std::string_view prompt);
+
+    /**
+     * @brief Prints `message` and a newline to stderr
+     */
+    void report_input_error(const char *message);
+}
+
+#endif // LINE_READER_H
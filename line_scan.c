@@ -0,0 +1,463 @@
+#include "line_scan.h"
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define ML_SCAN_X86 1
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#define ML_SCAN_NEON 1
+#include <arm_neon.h>
+#endif
+
+// Runtime-dispatched scanning kernels
+//
+// Every kernel processes full vectors with the SIMD unit and finishes the
+// tail with the scalar code, so all of them return identical results.
+
+typedef struct {
+    const char *name;
+    size_t (*find_newline)(const char *data, size_t len);
+    size_t (*index_newlines)(const char *data, size_t len, size_t *positions, size_t max);
+    size_t (*skip_leading)(const char *data, size_t len);   // count of leading whitespace
+    size_t (*trim_trailing)(const char *data, size_t len);  // length without trailing whitespace
+    size_t (*normalize)(char *data, size_t len);            // see ml_normalize()
+} scan_kernels;
+
+static int is_space(unsigned char c) {
+    return c == ' ' || (unsigned char)(c - '\t') <= '\r' - '\t';
+}
+
+static unsigned char to_lower_ascii(unsigned char c) {
+    return (unsigned char)(c - 'A') <= 'Z' - 'A' ? (unsigned char)(c | 0x20) : c;
+}
+
+// ============================================================================
+// SCALAR
+// ============================================================================
+
+static size_t find_newline_scalar(const char *data, size_t len) {
+    const char *hit = memchr(data, '\n', len);
+    return hit != NULL ? (size_t)(hit - data) : len;
+}
+
+static size_t index_newlines_scalar(const char *data, size_t len, size_t *positions, size_t max) {
+    size_t count = 0;
+    for (size_t i = 0; i < len && count < max; i++) {
+        if (data[i] == '\n') {
+            positions[count++] = i;
+        }
+    }
+    return count;
+}
+
+static size_t skip_leading_scalar(const char *data, size_t len) {
+    size_t i = 0;
+    while (i < len && is_space((unsigned char)data[i])) {
+        i++;
+    }
+    return i;
+}
+
+static size_t trim_trailing_scalar(const char *data, size_t len) {
+    while (len > 0 && is_space((unsigned char)data[len - 1])) {
+        len--;
+    }
+    return len;
+}
+
+/**
+ * Normalizes data[in, end) into data[out, ...): whitespace runs become one
+ * ' ' (none right after a ' ' already written, as `prev_space` says) and
+ * ASCII letters are lowercased. Bytes >= 0x80 are copied unchanged, so UTF-8
+ * sequences pass through intact.
+ *
+ * @return The new output offset
+ */
+static size_t normalize_bytes(char *data, size_t in, size_t end, size_t out, int *prev_space) {
+    for (; in < end; in++) {
+        unsigned char c = (unsigned char)data[in];
+        if (is_space(c)) {
+            if (!*prev_space) {
+                data[out++] = ' ';
+            }
+            *prev_space = 1;
+        } else {
+            data[out++] = (char)to_lower_ascii(c);
+            *prev_space = 0;
+        }
+    }
+    return out;
+}
+
+// The vector kernels start after the leading whitespace and fix up the one
+// ' ' a trailing run collapses to at the end
+static size_t normalize_finish(char *data, size_t in, size_t len, size_t out, int prev_space) {
+    out = normalize_bytes(data, in, len, out, &prev_space);
+    return out > 0 && data[out - 1] == ' ' ? out - 1 : out;
+}
+
+static size_t normalize_scalar(char *data, size_t len) {
+    return normalize_finish(data, skip_leading_scalar(data, len), len, 0, 0);
+}
+
+static const scan_kernels SCALAR_KERNELS = {
+    "scalar",
+    find_newline_scalar,
+    index_newlines_scalar,
+    skip_leading_scalar,
+    trim_trailing_scalar,
+    normalize_scalar,
+};
+
+// Appends the newline offsets encoded in `mask` (bit i = byte base + i)
+#define EMIT_MASK(mask, base, positions, count, max)          \
+    while ((mask) != 0) {                                      \
+        if ((count) == (max)) {                                \
+            return (count);                                    \
+        }                                                      \
+        (positions)[(count)++] = (base) + (size_t)__builtin_ctzll(mask); \
+        (mask) &= (mask) - 1;                                  \
+    }
+
+#if ML_SCAN_X86
+
+// ============================================================================
+// SSE2 (baseline on every x86-64 CPU)
+// ============================================================================
+
+// 0xFF in every byte of `v` that is whitespace
+static inline __m128i space_cmp_sse2(__m128i v) {
+    __m128i shifted = _mm_sub_epi8(v, _mm_set1_epi8('\t'));
+    __m128i in_range = _mm_cmpeq_epi8(_mm_min_epu8(shifted, _mm_set1_epi8('\r' - '\t')), shifted);
+    return _mm_or_si128(in_range, _mm_cmpeq_epi8(v, _mm_set1_epi8(' ')));
+}
+
+// Bit i set when byte i of `v` is whitespace
+static inline unsigned space_mask_sse2(__m128i v) {
+    return (unsigned)_mm_movemask_epi8(space_cmp_sse2(v));
+}
+
+static size_t find_newline_sse2(const char *data, size_t len) {
+    const __m128i nl = _mm_set1_epi8('\n');
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(data + i));
+        unsigned mask = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(v, nl));
+        if (mask != 0) {
+            return i + (size_t)__builtin_ctz(mask);
+        }
+    }
+    return i + find_newline_scalar(data + i, len - i);
+}
+
+static size_t index_newlines_sse2(const char *data, size_t len, size_t *positions, size_t max) {
+    const __m128i nl = _mm_set1_epi8('\n');
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(data + i));
+        unsigned long long mask = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(v, nl));
+        EMIT_MASK(mask, i, positions, count, max);
+    }
+    size_t tail = index_newlines_scalar(data + i, len - i, positions + count, max - count);
+    for (size_t k = 0; k < tail; k++) {
+        positions[count + k] += i;
+    }
+    return count + tail;
+}
+
+static size_t skip_leading_sse2(const char *data, size_t len) {
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        unsigned other = ~space_mask_sse2(_mm_loadu_si128((const __m128i *)(data + i))) & 0xFFFFu;
+        if (other != 0) {
+            return i + (size_t)__builtin_ctz(other);
+        }
+    }
+    return i + skip_leading_scalar(data + i, len - i);
+}
+
+static size_t trim_trailing_sse2(const char *data, size_t len) {
+    while (len >= 16) {
+        unsigned other = ~space_mask_sse2(_mm_loadu_si128((const __m128i *)(data + len - 16))) & 0xFFFFu;
+        if (other != 0) {
+            return len - 16 + (size_t)(32 - __builtin_clz(other));
+        }
+        len -= 16;
+    }
+    return trim_trailing_scalar(data, len);
+}
+
+/**
+ * Normalizes one 16-byte block (see normalize_bytes()) if it has no two
+ * whitespace bytes in a row, which only needs lowercasing and every
+ * whitespace byte turned into ' ': done on the whole vector.
+ *
+ * @return 0 if the block has to shrink and must go through the scalar code
+ */
+static inline int normalize_vector_sse2(__m128i v, __m128i *result, int *prev_space) {
+    __m128i ws = space_cmp_sse2(v);
+    unsigned mask = (unsigned)_mm_movemask_epi8(ws);
+    if ((mask & ((mask << 1) | (unsigned)*prev_space)) != 0) {
+        return 0;
+    }
+    __m128i shifted = _mm_sub_epi8(v, _mm_set1_epi8('A'));
+    __m128i upper = _mm_cmpeq_epi8(_mm_min_epu8(shifted, _mm_set1_epi8('Z' - 'A')), shifted);
+    __m128i lowered = _mm_or_si128(v, _mm_and_si128(upper, _mm_set1_epi8(0x20)));
+    *result = _mm_or_si128(_mm_andnot_si128(ws, lowered), _mm_and_si128(ws, _mm_set1_epi8(' ')));
+    *prev_space = (int)(mask >> 15);
+    return 1;
+}
+
+// Stores go to data + out <= data + in, so they only overwrite bytes that
+// were already loaded
+static size_t normalize_sse2(char *data, size_t len) {
+    size_t in = skip_leading_sse2(data, len);
+    size_t out = 0;
+    int prev_space = 0;
+    for (; in + 16 <= len; in += 16) {
+        __m128i result;
+        if (normalize_vector_sse2(_mm_loadu_si128((const __m128i *)(data + in)), &result, &prev_space)) {
+            _mm_storeu_si128((__m128i *)(data + out), result);
+            out += 16;
+        } else {
+            out = normalize_bytes(data, in, in + 16, out, &prev_space);
+        }
+    }
+    return normalize_finish(data, in, len, out, prev_space);
+}
+
+static const scan_kernels SSE2_KERNELS = {
+    "sse2",
+    find_newline_sse2,
+    index_newlines_sse2,
+    skip_leading_sse2,
+    trim_trailing_sse2,
+    normalize_sse2,
+};
+
+// ============================================================================
+// AVX2 (selected at runtime)
+// ============================================================================
+
+#define ML_AVX2 __attribute__((target("avx2")))
+
+ML_AVX2 static size_t find_newline_avx2(const char *data, size_t len) {
+    const __m256i nl = _mm256_set1_epi8('\n');
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(data + i));
+        unsigned mask = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, nl));
+        if (mask != 0) {
+            return i + (size_t)__builtin_ctz(mask);
+        }
+    }
+    return i + find_newline_sse2(data + i, len - i);
+}
+
+ML_AVX2 static size_t index_newlines_avx2(const char *data, size_t len, size_t *positions, size_t max) {
+    const __m256i nl = _mm256_set1_epi8('\n');
+    size_t count = 0;
+    size_t i = 0;
+    // 64 bytes per iteration: two compares folded into one 64-bit mask
+    for (; i + 64 <= len; i += 64) {
+        __m256i lo = _mm256_loadu_si256((const __m256i *)(data + i));
+        __m256i hi = _mm256_loadu_si256((const __m256i *)(data + i + 32));
+        unsigned long long mask =
+            (unsigned long long)(unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, nl)) |
+            ((unsigned long long)(unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, nl)) << 32);
+        EMIT_MASK(mask, i, positions, count, max);
+    }
+    size_t tail = index_newlines_sse2(data + i, len - i, positions + count, max - count);
+    for (size_t k = 0; k < tail; k++) {
+        positions[count + k] += i;
+    }
+    return count + tail;
+}
+
+static const scan_kernels AVX2_KERNELS = {
+    "avx2",
+    find_newline_avx2,
+    index_newlines_avx2,
+    skip_leading_sse2,   // names are short: 16-byte steps are already enough
+    trim_trailing_sse2,
+    normalize_sse2,      // and calls into the scalar code would pay AVX/SSE transitions
+};
+
+#endif // ML_SCAN_X86
+
+#if ML_SCAN_NEON
+
+// ============================================================================
+// NEON (baseline on every AArch64 CPU)
+// ============================================================================
+
+// NEON has no movemask: narrow each 0x00/0xFF byte to a nibble instead,
+// giving a 64-bit mask with 4 bits per input byte
+static inline uint64_t nibble_mask(uint8x16_t cmp) {
+    uint8x8_t narrowed = vshrn_n_u16(vreinterpretq_u16_u8(cmp), 4);
+    return vget_lane_u64(vreinterpret_u64_u8(narrowed), 0);
+}
+
+static inline uint8x16_t space_cmp_neon(uint8x16_t v) {
+    uint8x16_t in_range = vcleq_u8(vsubq_u8(v, vdupq_n_u8('\t')), vdupq_n_u8('\r' - '\t'));
+    return vorrq_u8(in_range, vceqq_u8(v, vdupq_n_u8(' ')));
+}
+
+static size_t find_newline_neon(const char *data, size_t len) {
+    const uint8x16_t nl = vdupq_n_u8('\n');
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        uint64_t mask = nibble_mask(vceqq_u8(vld1q_u8((const uint8_t *)data + i), nl));
+        if (mask != 0) {
+            return i + (size_t)(__builtin_ctzll(mask) >> 2);
+        }
+    }
+    return i + find_newline_scalar(data + i, len - i);
+}
+
+static size_t index_newlines_neon(const char *data, size_t len, size_t *positions, size_t max) {
+    const uint8x16_t nl = vdupq_n_u8('\n');
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        uint64_t nibbles = nibble_mask(vceqq_u8(vld1q_u8((const uint8_t *)data + i), nl));
+        nibbles &= 0x8888888888888888ull;  // one bit per byte
+        while (nibbles != 0) {
+            if (count == max) {
+                return count;
+            }
+            positions[count++] = i + (size_t)(__builtin_ctzll(nibbles) >> 2);
+            nibbles &= nibbles - 1;
+        }
+    }
+    size_t tail = index_newlines_scalar(data + i, len - i, positions + count, max - count);
+    for (size_t k = 0; k < tail; k++) {
+        positions[count + k] += i;
+    }
+    return count + tail;
+}
+
+static size_t skip_leading_neon(const char *data, size_t len) {
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        uint64_t other = ~nibble_mask(space_cmp_neon(vld1q_u8((const uint8_t *)data + i)));
+        if (other != 0) {
+            return i + (size_t)(__builtin_ctzll(other) >> 2);
+        }
+    }
+    return i + skip_leading_scalar(data + i, len - i);
+}
+
+static size_t trim_trailing_neon(const char *data, size_t len) {
+    while (len >= 16) {
+        uint64_t other = ~nibble_mask(space_cmp_neon(vld1q_u8((const uint8_t *)data + len - 16)));
+        if (other != 0) {
+            return len - 16 + (size_t)(16 - (__builtin_clzll(other) >> 2));
+        }
+        len -= 16;
+    }
+    return trim_trailing_scalar(data, len);
+}
+
+// See normalize_sse2(); the nibble mask has 4 bits per byte, so a
+// whitespace byte following another one is a shift by 4
+static size_t normalize_neon(char *data, size_t len) {
+    const uint8x16_t upper_a = vdupq_n_u8('A');
+    const uint8x16_t letters = vdupq_n_u8('Z' - 'A');
+    const uint8x16_t case_bit = vdupq_n_u8(0x20);
+    const uint8x16_t space = vdupq_n_u8(' ');
+    size_t in = skip_leading_neon(data, len);
+    size_t out = 0;
+    int prev_space = 0;
+    for (; in + 16 <= len; in += 16) {
+        uint8x16_t v = vld1q_u8((const uint8_t *)data + in);
+        uint8x16_t ws = space_cmp_neon(v);
+        uint64_t mask = nibble_mask(ws);
+        if ((mask & ((mask << 4) | (prev_space ? 0xFu : 0u))) != 0) {
+            out = normalize_bytes(data, in, in + 16, out, &prev_space);
+            continue;
+        }
+        uint8x16_t upper = vcleq_u8(vsubq_u8(v, upper_a), letters);
+        uint8x16_t lowered = vorrq_u8(v, vandq_u8(upper, case_bit));
+        vst1q_u8((uint8_t *)data + out, vbslq_u8(ws, space, lowered));
+        out += 16;
+        prev_space = (int)(mask >> 63);
+    }
+    return normalize_finish(data, in, len, out, prev_space);
+}
+
+static const scan_kernels NEON_KERNELS = {
+    "neon",
+    find_newline_neon,
+    index_newlines_neon,
+    skip_leading_neon,
+    trim_trailing_neon,
+    normalize_neon,
+};
+
+#endif // ML_SCAN_NEON
+
+// ============================================================================
+// DISPATCH
+// ============================================================================
+
+static const scan_kernels *select_kernels(void) {
+    const char *forced = getenv("MULTILANG_SIMD");
+    if (forced != NULL && strcmp(forced, "scalar") == 0) {
+        return &SCALAR_KERNELS;
+    }
+#if ML_SCAN_X86
+    __builtin_cpu_init();
+    int want_sse2 = forced != NULL && strcmp(forced, "sse2") == 0;
+    if (!want_sse2 && __builtin_cpu_supports("avx2")) {
+        return &AVX2_KERNELS;
+    }
+    return &SSE2_KERNELS;
+#elif ML_SCAN_NEON
+    return &NEON_KERNELS;
+#else
+    return &SCALAR_KERNELS;
+#endif
+}
+
+static _Atomic(const scan_kernels *) active_kernels = NULL;
+
+static const scan_kernels *kernels(void) {
+    const scan_kernels *k = atomic_load_explicit(&active_kernels, memory_order_acquire);
+    if (k == NULL) {
+        // Racing threads all compute the same answer, so last store wins harmlessly
+        k = select_kernels();
+        atomic_store_explicit(&active_kernels, k, memory_order_release);
+    }
+    return k;
+}
+
+size_t ml_find_newline(const char *data, size_t len) {
+    return kernels()->find_newline(data, len);
+}
+
+size_t ml_index_newlines(const char *data, size_t len, size_t *positions, size_t max) {
+    if (max == 0) {
+        return 0;
+    }
+    return kernels()->index_newlines(data, len, positions, max);
+}
+
+void ml_trim(const char **data, size_t *len) {
+    const scan_kernels *k = kernels();
+    size_t lead = k->skip_leading(*data, *len);
+    *data += lead;
+    *len = k->trim_trailing(*data, *len - lead);
+}
+
+size_t ml_normalize(char *data, size_t len) {
+    return kernels()->normalize(data, len);
+}
+
+const char *ml_scan_kernel_name(void) {
+    return kernels()->name;
+}
@@ -0,0 +1,76 @@
+#ifndef MULTILANG_LINE_SCAN_H
+#define MULTILANG_LINE_SCAN_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ============================================================================
+// VECTORIZED LINE SPLITTING AND TRIMMING (C ABI, shared by C, C++ and Rust)
+// ============================================================================
+// One implementation of "where does the line end" and "what is whitespace"
+// for every language, so the streaming paths all agree on the result.
+//
+// The kernel is picked once at runtime: AVX2 or SSE2 on x86-64, NEON on
+// AArch64, plain C everywhere else. MULTILANG_SIMD=scalar|sse2|avx2|neon in
+// the environment forces a specific kernel (if the CPU supports it).
+//
+// Whitespace is the ASCII set of C's isspace(): ' ', '\t', '\n', '\v', '\f', '\r'
+
+/**
+ * @return Offset of the first '\n' in data[0, len), or len if there is none
+ */
+size_t ml_find_newline(const char *data, size_t len);
+
+/**
+ * Records the offsets of up to `max` newlines in data[0, len)
+ *
+ * Splitting a whole chunk in one call avoids a separate scan setup per line,
+ * which dominates for short lines like names.
+ *
+ * @return Number of offsets written to `positions`
+ */
+size_t ml_index_newlines(const char *data, size_t len, size_t *positions, size_t max);
+
+/**
+ * Strips leading and trailing whitespace by adjusting the view in place
+ */
+void ml_trim(const char **data, size_t *len);
+
+/**
+ * Normalizes a name in place before dedupe or lookup: strips leading and
+ * trailing whitespace, collapses every internal run of whitespace into one
+ * ' ' and lowercases ASCII letters. Bytes >= 0x80 are left as they are, so
+ * UTF-8 input stays well-formed (non-ASCII letters are not case-folded).
+ *
+ * Blocks that only need lowercasing are rewritten with vector instructions;
+ * blocks where whitespace has to be squeezed out take the scalar path.
+ *
+ * @return The normalized length (at most `len`)
+ */
+size_t ml_normalize(char *data, size_t len);
+
+/**
+ * @return Name of the active kernel ("avx2", "sse2", "neon" or "scalar")
+ */
+const char *ml_scan_kernel_name(void);
+
+#ifdef __cplusplus
+}
+
+// C++-only interface
+#include <string>
+namespace InputCpp {
+
+    /**
+     * Normalizes `name` in place (see ml_normalize())
+     */
+    inline void normalize_name(std::string &name) {
+        name.resize(ml_normalize(name.data(), name.size()));
+    }
+}
+#endif
+
+#endif //MULTILANG_LINE_SCAN_H
@@ -1,11 +1,37 @@
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 #include "banner.h"
 #include "get_input.h"
 #include "get_input_mem.h"
 #include "get_input_cpp.h"
 #include "get_input_mem_cpp.h"
 #include "greet_rust.h"
+#include "name_batch.h"
+#include "async_input.h"
+#include "output_sink.h"
+#include "greeting_format.h"
+#include "pipeline.h"
+#include "greet_server.h"
+#include "spsc_ring.h"
+#include "utf8_scan.h"
+#include "impl_registry.h"
+#include "name_index.h"
+#include "sharded_input.h"
+#include "name_freq.h"
+#include "startup_trace.h"
+#include "mem_budget.h"
+#include "ml_stats.h"
+#include "session_replay.h"
+#include "compressed_io.h"
 
 // ============================================================================
 // FUTURE LANGUAGE INTEGRATIONS
@@ -23,109 +49,918 @@
 // #include "greet_wasm.h"      // WebAssembly modules
 // ============================================================================
 
-int main(void) {
-    // Display banner at program
-    print_banner();
+// Batch mode: greet every line of stdin without per-line prompts or flushes
+static int greet_batch_name(const char *name, size_t len, void *ctx) {
+    (void)ctx;
+    ml_greeting_write(ml_stdout_sink(), ML_GREETING_C, name, len);
+    return 0;
+}
 
-    printf("=== Multi-Language Input Demo ===\n\n");
+// Rust batch mode: one FFI call per RUST_BATCH_NAMES names instead of per name
+#define RUST_BATCH_NAMES 4096
+#define RUST_BATCH_BYTES (RUST_BATCH_NAMES * 32)
+
+static size_t greet_rust_batch(unsigned flags) {
+    static char names[RUST_BATCH_BYTES];
+    static size_t offsets[RUST_BATCH_NAMES + 1];
+    size_t total = 0;
+    size_t count;
+
+    while ((count = ask_names_rust_batch_flags(names, sizeof(names), offsets, RUST_BATCH_NAMES, flags)) > 0) {
+        for (size_t i = 0; i < count; i++) {
+            ml_greeting_write(ml_stdout_sink(), ML_GREETING_RUST, names + offsets[i],
+                              offsets[i + 1] - offsets[i] - 1);
+        }
+        total += count;
+    }
+    return total;
+}
+
+typedef enum {
+    BATCH_OFF = 0,
+    BATCH_C,     // --batch / --batch=c: C batch API (name_batch.h)
+    BATCH_RUST,  // --batch=rust: ask_names_rust_batch()
+} batch_mode;
+
+typedef enum {
+    RING_OFF = 0,
+    RING_CPP,    // --ring / --ring=cpp: greet_ring_cpp()
+    RING_RUST,   // --ring=rust: greet_ring_rust()
+} ring_mode;
+
+typedef struct {
+    batch_mode batch; // --batch[=c|rust]: stream stdin without prompts
+    int pipeline;     // --pipeline[=cpp|rust]: multi-threaded greeting pipeline
+    int show_banner;  // cleared by --no-banner / --quiet
+    const char *input; // --input FILE: read names from FILE (mapped) instead of stdin
+    int async;        // --async: C batch mode over overlapped reads (async_input.h)
+    unsigned reader_flags; // ML_BATCH_* flags for the C readers (--valid-utf8, --normalize)
+    int serve;        // --serve[=c|cpp|rust]: socket greeting server (greet_server.h)
+    ring_mode ring;   // --ring[=cpp|rust]: backend thread fed through shared rings (spsc_ring.h)
+    const ml_impl *impl; // --impl=NAME: run only this interactive implementation (impl_registry.h)
+    unsigned long repeat; // --repeat N: names to ask for with --impl
+    const char *write_index; // --write-index FILE: store the names in a binary index (name_index.h)
+    const char *lookup;      // --lookup FILE: look the names up in a binary index
+    unsigned threads;        // --threads N: split --input FILE into N independent shards (sharded_input.h)
+    int unordered;           // --unordered: merge the shards' output as it comes
+    int count;               // --count[=exact|sketch]: top-K and distinct names (name_freq.h)
+    ml_freq_options freq_opts;
+    int startup_trace;       // --startup-trace: report start-up milestones on stderr (startup_trace.h)
+    const char *record;      // --record FILE: log every interactive call (session_replay.h)
+    const char *replay;      // --replay[=max|recorded] FILE: re-run a recorded session and time it
+    ml_replay_speed replay_speed;
+    size_t max_mem;          // --max-mem SIZE: memory budget of the input/output layers (mem_budget.h)
+    ml_codec compress;       // --compress[=zstd|lz4]: compress the greetings (compressed_io.h)
+    ml_pipeline_options pipeline_opts;
+    ml_server_options server_opts;
+} cli_options;
+
+static void print_usage(const char *prog) {
+    char impls[128];
+    ml_impl_list(impls, sizeof(impls));
+    fprintf(stderr, "Usage: %s [--impl=%s [--repeat N]]\n"
+                    "          [--batch[=c|rust]] [--pipeline[=cpp|rust] [--workers N]] [--input FILE] [--async]\n"
+                    "          [--ring[=cpp|rust]] [--valid-utf8] [--normalize]\n"
+                    "          [--threads N [--unordered]] [--write-index FILE | --lookup FILE]\n"
+                    "          [--count[=exact|sketch] [--top K] [--threads N]]\n"
+                    "          [--serve[=c|cpp|rust] [--listen PORT|HOST:PORT|unix:PATH] [--workers N]]\n"
+                    "          [--record FILE | --replay[=max|recorded] FILE] [--max-mem SIZE[K|M|G]]\n"
+                    "          [--compress[=zstd|lz4]] [--no-banner | --quiet] [--startup-trace]\n", prog, impls);
+}
+
+/**
+ * Parses the command line into `opts`
+ *
+ * @return 0 on success, -1 on an unknown argument
+ */
+static int parse_args(int argc, char **argv, cli_options *opts) {
+    opts->batch = BATCH_OFF;
+    opts->pipeline = 0;
+    opts->show_banner = 1;
+    opts->input = NULL;
+    opts->async = 0;
+    opts->serve = 0;
+    opts->reader_flags = 0;
+    opts->ring = RING_OFF;
+    opts->impl = NULL;
+    opts->repeat = 0;
+    opts->write_index = NULL;
+    opts->lookup = NULL;
+    opts->threads = 0;
+    opts->unordered = 0;
+    opts->count = 0;
+    ml_freq_default_options(&opts->freq_opts);
+    opts->startup_trace = 0;
+    opts->record = NULL;
+    opts->replay = NULL;
+    opts->replay_speed = ML_REPLAY_MAX_SPEED;
+    opts->max_mem = 0;
+    opts->compress = ML_CODEC_NONE;
+    ml_pipeline_default_options(&opts->pipeline_opts);
+    ml_server_default_options(&opts->server_opts);
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--batch") == 0 || strcmp(argv[i], "--batch=c") == 0) {
+            opts->batch = BATCH_C;
+        } else if (strcmp(argv[i], "--batch=rust") == 0) {
+            opts->batch = BATCH_RUST;
+        } else if (strcmp(argv[i], "--pipeline") == 0 || strcmp(argv[i], "--pipeline=cpp") == 0) {
+            opts->pipeline = 1;
+            opts->pipeline_opts.backend = ML_PIPELINE_CPP;
+        } else if (strcmp(argv[i], "--pipeline=rust") == 0) {
+            opts->pipeline = 1;
+            opts->pipeline_opts.backend = ML_PIPELINE_RUST;
+        } else if (strncmp(argv[i], "--impl=", 7) == 0) {
+            opts->impl = ml_impl_find(argv[i] + 7);
+            if (opts->impl == NULL) {
+                fprintf(stderr, "Unknown implementation: %s\n", argv[i] + 7);
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+            char *end;
+            opts->repeat = strtoul(argv[++i], &end, 10);
+            if (*end != '\0' || opts->repeat == 0) {
+                fprintf(stderr, "--repeat needs a positive count\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            char *end;
+            unsigned long threads = strtoul(argv[++i], &end, 10);
+            if (*end != '\0' || threads == 0 || threads > 4096) {
+                fprintf(stderr, "--threads needs a count between 1 and 4096\n");
+                return -1;
+            }
+            opts->threads = (unsigned)threads;
+        } else if (strcmp(argv[i], "--unordered") == 0) {
+            opts->unordered = 1;
+        } else if (strcmp(argv[i], "--count") == 0 || strcmp(argv[i], "--count=exact") == 0) {
+            opts->count = 1;
+            opts->freq_opts.mode = ML_FREQ_EXACT;
+        } else if (strcmp(argv[i], "--count=sketch") == 0) {
+            opts->count = 1;
+            opts->freq_opts.mode = ML_FREQ_SKETCH;
+        } else if (strcmp(argv[i], "--top") == 0 && i + 1 < argc) {
+            char *end;
+            opts->freq_opts.top = (size_t)strtoull(argv[++i], &end, 10);
+            if (*end != '\0' || opts->freq_opts.top == 0) {
+                fprintf(stderr, "--top needs a positive count\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--write-index") == 0 && i + 1 < argc) {
+            opts->write_index = argv[++i];
+        } else if (strcmp(argv[i], "--lookup") == 0 && i + 1 < argc) {
+            opts->lookup = argv[++i];
+        } else if (strcmp(argv[i], "--ring") == 0 || strcmp(argv[i], "--ring=cpp") == 0) {
+            opts->ring = RING_CPP;
+        } else if (strcmp(argv[i], "--ring=rust") == 0) {
+            opts->ring = RING_RUST;
+        } else if (strcmp(argv[i], "--workers") == 0 && i + 1 < argc) {
+            char *end;
+            unsigned long workers = strtoul(argv[++i], &end, 10);
+            if (*end != '\0' || workers == 0 || workers > 4096) {
+                fprintf(stderr, "--workers needs a count between 1 and 4096\n");
+                return -1;
+            }
+            opts->pipeline_opts.workers = (unsigned)workers;
+            opts->server_opts.threads = opts->pipeline_opts.workers;
+        } else if (strcmp(argv[i], "--serve") == 0 || strcmp(argv[i], "--serve=c") == 0) {
+            opts->serve = 1;
+            opts->server_opts.backend = ML_SERVER_C;
+        } else if (strcmp(argv[i], "--serve=cpp") == 0) {
+            opts->serve = 1;
+            opts->server_opts.backend = ML_SERVER_CPP;
+        } else if (strcmp(argv[i], "--serve=rust") == 0) {
+            opts->serve = 1;
+            opts->server_opts.backend = ML_SERVER_RUST;
+        } else if (strcmp(argv[i], "--listen") == 0 && i + 1 < argc) {
+            opts->server_opts.listen = argv[++i];
+        } else if (strcmp(argv[i], "--async") == 0) {
+            opts->async = 1;
+        } else if (strcmp(argv[i], "--valid-utf8") == 0) {
+            opts->reader_flags |= ML_BATCH_VALID_UTF8;
+        } else if (strcmp(argv[i], "--normalize") == 0) {
+            opts->reader_flags |= ML_BATCH_NORMALIZE;
+        } else if (strcmp(argv[i], "--input") == 0 && i + 1 < argc) {
+            opts->input = argv[++i];
+        } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            opts->record = argv[++i];
+        } else if ((strcmp(argv[i], "--replay") == 0 || strcmp(argv[i], "--replay=max") == 0) && i + 1 < argc) {
+            opts->replay = argv[++i];
+            opts->replay_speed = ML_REPLAY_MAX_SPEED;
+        } else if (strcmp(argv[i], "--replay=recorded") == 0 && i + 1 < argc) {
+            opts->replay = argv[++i];
+            opts->replay_speed = ML_REPLAY_RECORDED;
+        } else if (strcmp(argv[i], "--max-mem") == 0 && i + 1 < argc) {
+            if (ml_mem_parse_size(argv[++i], &opts->max_mem) != 0) {
+                fprintf(stderr, "--max-mem needs a positive size (e.g. 64M)\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--compress") == 0) {
+            opts->compress = ML_CODEC_ZSTD;
+        } else if (strncmp(argv[i], "--compress=", 11) == 0) {
+            if (ml_codec_parse(argv[i] + 11, &opts->compress) != 0) {
+                fprintf(stderr, "Unknown codec: %s (zstd or lz4)\n", argv[i] + 11);
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--startup-trace") == 0) {
+            opts->startup_trace = 1;
+        } else if (strcmp(argv[i], "--no-banner") == 0 || strcmp(argv[i], "--quiet") == 0) {
+            opts->show_banner = 0;
+        } else {
+            fprintf(stderr, "Unknown argument: %s\n", argv[i]);
+            return -1;
+        }
+    }
+
+    if (opts->compress != ML_CODEC_NONE) {
+        int streaming = opts->pipeline || opts->batch != BATCH_OFF || opts->input != NULL || opts->async
+                        || opts->ring != RING_OFF || opts->lookup != NULL;
+        if (!streaming || opts->serve || opts->impl != NULL || opts->count || opts->write_index != NULL) {
+            fprintf(stderr, "--compress applies to the greetings of --batch, --pipeline, --ring, --threads and --lookup\n");
+            return -1;
+        }
+        if (!ml_codec_supported(opts->compress)) {
+            fprintf(stderr, "--compress=%s: this build has no %s support\n",
+                    ml_codec_name(opts->compress), ml_codec_name(opts->compress));
+            return -1;
+        }
+    }
+    if (opts->repeat != 0 && opts->impl == NULL) {
+        fprintf(stderr, "--repeat only applies to --impl\n");
+        return -1;
+    }
+    int index_mode = opts->write_index != NULL || opts->lookup != NULL || opts->count;
+    if (opts->record != NULL || opts->replay != NULL) {
+        if (opts->record != NULL && opts->replay != NULL) {
+            fprintf(stderr, "--record and --replay cannot be combined\n");
+            return -1;
+        }
+        if (opts->serve || opts->pipeline || opts->batch != BATCH_OFF || opts->input != NULL || opts->async
+            || opts->ring != RING_OFF || index_mode || opts->threads != 0) {
+            fprintf(stderr, "--record and --replay apply to the interactive demo and --impl only\n");
+            return -1;
+        }
+        if (opts->replay != NULL && opts->repeat != 0) {
+            fprintf(stderr, "--repeat does not apply to --replay (it replays every recorded call)\n");
+            return -1;
+        }
+    }
+    if (opts->impl != NULL && (opts->serve || opts->pipeline || opts->batch != BATCH_OFF || opts->input != NULL
+                               || opts->async || opts->ring != RING_OFF || index_mode)) {
+        fprintf(stderr, "--impl selects an interactive implementation and cannot be combined with other modes\n");
+        return -1;
+    }
+    if (opts->impl != NULL && opts->repeat == 0) {
+        opts->repeat = 1;
+    }
+    if (index_mode) {
+        if ((opts->write_index != NULL) + (opts->lookup != NULL) + opts->count > 1 || opts->serve || opts->pipeline
+            || opts->batch != BATCH_OFF || opts->async || opts->ring != RING_OFF || opts->unordered
+            || (opts->threads != 0 && !opts->count)) {
+            fprintf(stderr, "--write-index, --lookup and --count read names from stdin or --input and cannot be combined with other modes\n");
+            return -1;
+        }
+        opts->freq_opts.threads = opts->threads;
+        return 0;
+    }
+    if (opts->serve && (opts->pipeline || opts->batch != BATCH_OFF || opts->input != NULL || opts->async
+                        || opts->ring != RING_OFF)) {
+        fprintf(stderr, "--serve reads from sockets and cannot be combined with stdin/file modes\n");
+        return -1;
+    }
+    if (opts->ring != RING_OFF) {
+        if (opts->pipeline || opts->batch != BATCH_OFF || opts->async) {
+            fprintf(stderr, "--ring cannot be combined with --batch, --pipeline or --async\n");
+            return -1;
+        }
+        return 0;
+    }
+
+    // A file has no one to prompt: --input alone means C batch mode
+    if ((opts->input != NULL || opts->async) && !opts->pipeline && opts->batch == BATCH_OFF) {
+        opts->batch = BATCH_C;
+    }
+    if (opts->input != NULL && !opts->pipeline && opts->batch == BATCH_RUST) {
+        fprintf(stderr, "--input is not supported with --batch=rust (it reads stdin)\n");
+        return -1;
+    }
+    if (opts->reader_flags != 0 && !opts->pipeline && opts->batch != BATCH_C
+        && !(opts->batch == BATCH_RUST && opts->reader_flags == ML_BATCH_NORMALIZE)) {
+        fprintf(stderr, "--valid-utf8 only applies to --batch=c and --pipeline, --normalize also to --batch=rust\n");
+        return -1;
+    }
+    if (opts->freq_opts.top != ML_FREQ_DEFAULT_TOP) {
+        fprintf(stderr, "--top only applies to --count\n");
+        return -1;
+    }
+    if (opts->unordered && opts->threads == 0) {
+        fprintf(stderr, "--unordered only applies to --threads\n");
+        return -1;
+    }
+    if (opts->threads != 0 && (opts->input == NULL || opts->async || opts->batch == BATCH_RUST)) {
+        fprintf(stderr, "--threads splits one --input FILE for --batch=c or --pipeline[=cpp|rust]\n");
+        return -1;
+    }
+    if (opts->async && (opts->pipeline || opts->batch != BATCH_C)) {
+        fprintf(stderr, "--async only applies to the C batch mode\n");
+        return -1;
+    }
+    return 0;
+}
+
+static void handle_stop_signal(int sig) {
+    (void)sig;
+    ml_server_stop();
+}
+
+/**
+ * Runs the greeting server until SIGINT/SIGTERM
+ *
+ * @return Process exit code
+ */
+static int serve(const ml_server_options *server_opts) {
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = handle_stop_signal;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);  // a client hanging up must not kill the server
+
+    return ml_run_server(server_opts) == 0 ? 0 : 1;
+}
+
+/**
+ * Reports that the names input `path` (NULL = stdin) could not be opened or
+ * read. ENOTSUP means it is compressed: with a codec this build lacks, or,
+ * given `mode`, fine but the mode cannot decode it.
+ */
+static void report_input_error(const char *path, const char *mode) {
+    const char *what = path != NULL ? path : "stdin";
+    if (errno == EBADMSG) {
+        fprintf(stderr, "%s: compressed input is corrupt or truncated\n", what);
+    } else if (errno != ENOTSUP) {
+        perror(what);
+    } else if (mode != NULL) {
+        fprintf(stderr, "%s: compressed input is not supported with %s\n", what, mode);
+    } else {
+        fprintf(stderr, "%s: compressed with a codec this build does not include\n", what);
+    }
+}
+
+/**
+ * Idle hook of the main thread in the streaming modes (name_batch.h)
+ */
+static void flush_stdout_sink(void *ctx) {
+    (void)ctx;
+    ml_sink_flush(ml_stdout_sink());
+}
+
+/**
+ * Ends a streaming mode: sends what the stdout sink still buffers and ends a
+ * compressed frame now rather than at exit, so a write error (a full disk, a
+ * closed pipe) still turns into a failing exit status
+ *
+ * @return `rc`, or 1 if the output could not be written
+ */
+static int finish_output(int rc) {
+    if (ml_sink_set_codec(ml_stdout_sink(), ML_CODEC_NONE) != 0) {
+        perror("stdout");
+        return 1;
+    }
+    return rc;
+}
+
+/**
+ * Reports input that ended early on corrupt or truncated compressed data
+ * (the names before that point were still processed)
+ *
+ * @return Non-zero if `reader` failed
+ */
+static int input_failed(const ml_batch_reader *reader, const char *path) {
+    if (!ml_batch_reader_failed(reader)) {
+        return 0;
+    }
+    errno = EBADMSG;
+    report_input_error(path, NULL);
+    return 1;
+}
+
+/**
+ * Runs the C batch mode over `reader`
+ *
+ * @return Number of names greeted
+ */
+static size_t greet_batch_reader(ml_batch_reader *reader) {
+    ml_name_view views[1024];
+    size_t total = 0;
+    size_t n;
+    while ((n = ml_batch_reader_next(reader, views, sizeof(views) / sizeof(views[0]))) > 0) {
+        for (size_t i = 0; i < n; i++) {
+            greet_batch_name(views[i].data, views[i].len, NULL);
+        }
+        total += n;
+    }
+    return total;
+}
+
+/**
+ * Runs the C batch mode over an async reader of `path` (NULL = stdin)
+ * with the given ML_BATCH_* flags
+ *
+ * @return Number of names greeted, or (size_t)-1 on error
+ */
+static size_t greet_async_batch(const char *path, unsigned flags) {
+    int fd = path != NULL ? open(path, O_RDONLY) : STDIN_FILENO;
+    if (fd < 0) {
+        return (size_t)-1;
+    }
+    size_t count = ask_names_async(fd, flags, greet_batch_name, NULL);
+    if (fd != STDIN_FILENO) {
+        close(fd);
+    }
+    return count;
+}
+
+// ============================================================================
+// RING MODE
+// ============================================================================
+// The driver thread reads names and packs them, '\n'-terminated, into
+// records of RING_RECORD_BYTES on one ring; the backend thread greets a
+// whole record per step and answers with greeting records on a second ring,
+// which the driver copies to stdout. Nothing crosses the language boundary
+// per name and nothing is locked.
+
+#define RING_RECORD_BYTES (64 * 1024)
+
+typedef struct {
+    ring_mode backend;
+    ml_ring *names;
+    ml_ring *greetings;
+    size_t count;
+} ring_backend;
+
+static void *run_ring_backend(void *arg) {
+    ring_backend *b = arg;
+    b->count = b->backend == RING_RUST ? greet_ring_rust(b->names, b->greetings)
+                                       : greet_ring_cpp(b->names, b->greetings);
+    return NULL;
+}
+
+/**
+ * Writes every greeting record available right now to stdout
+ *
+ * @return Number of records written
+ */
+static size_t drain_greetings(ml_ring *greetings) {
+    size_t records = 0;
+    size_t len;
+    const void *record;
+    while ((record = ml_ring_peek(greetings, &len)) != NULL) {
+        ml_sink_write(ml_stdout_sink(), record, len);
+        ml_ring_release(greetings);
+        records++;
+    }
+    return records;
+}
+
+/**
+ * Reserves a names record without ever blocking on a full ring: while the
+ * backend is behind, its queued greetings are written out, so it can always
+ * make progress (both rings full would otherwise deadlock)
+ */
+static char *reserve_names(ml_ring *names, ml_ring *greetings, size_t len) {
+    char *room;
+    while ((room = ml_ring_reserve(names, len)) == NULL) {
+        if (drain_greetings(greetings) == 0) {
+            sched_yield();
+        }
+    }
+    return room;
+}
+
+/**
+ * Greets every name of `reader` on a backend thread fed through rings
+ *
+ * @return Number of names greeted, or (size_t)-1 if the rings or the
+ *         thread could not be created
+ */
+static size_t greet_ring(ml_batch_reader *reader, ring_mode backend) {
+    ring_backend b = {backend, ml_ring_create(0), ml_ring_create(0), 0};
+    pthread_t thread;
+    if (b.names == NULL || b.greetings == NULL || pthread_create(&thread, NULL, run_ring_backend, &b) != 0) {
+        ml_ring_destroy(b.names);
+        ml_ring_destroy(b.greetings);
+        return (size_t)-1;
+    }
+
+    size_t max_name = ml_ring_max_record(b.names) / 2;  // its greeting must fit in one record too
+    size_t record_bytes = max_name < RING_RECORD_BYTES ? max_name : RING_RECORD_BYTES;  // small rings (--max-mem)
+    char *room = reserve_names(b.names, b.greetings, record_bytes);
+    size_t cap = record_bytes;
+    size_t used = 0;
+    ml_name_view views[256];
+    size_t n;
+    while ((n = ml_batch_reader_next(reader, views, sizeof(views) / sizeof(views[0]))) > 0) {
+        for (size_t i = 0; i < n; i++) {
+            size_t len = ml_utf8_truncate(views[i].data, views[i].len, max_name);
+            if (len + 1 > cap - used) {
+                ml_ring_commit(b.names, used);
+                cap = len + 1 > record_bytes ? len + 1 : record_bytes;
+                room = reserve_names(b.names, b.greetings, cap);
+                used = 0;
+            }
+            memcpy(room + used, views[i].data, len);
+            room[used + len] = '\n';
+            used += len + 1;
+        }
+    }
+    ml_ring_commit(b.names, used);
+    ml_ring_close(b.names);
+
+    size_t len;
+    const void *record;
+    while ((record = ml_ring_peek_wait(b.greetings, &len)) != NULL) {
+        ml_sink_write(ml_stdout_sink(), record, len);
+        ml_ring_release(b.greetings);
+    }
+    pthread_join(thread, NULL);
+    ml_ring_destroy(b.names);
+    ml_ring_destroy(b.greetings);
+    return b.count;
+}
+
+// ============================================================================
+// INDEX MODE
+// ============================================================================
+// --write-index stores the trimmed, non-empty names in a binary index file
+// that later jobs map instead of re-parsing greetings; --lookup answers
+// one query name per input line from such a file; --count reports the most
+// frequent of those names.
 
-    // ========== C VERSIONS ==========
-    printf("--- C IMPLEMENTATIONS ---\n\n");
+#define INDEX_READER_FLAGS (ML_BATCH_TRIM | ML_BATCH_SKIP_EMPTY)
 
-    // 1. C Stack-based version
-    printf("1. C Stack-based version:\n");
+/**
+ * @return Number of names written, or (size_t)-1 on error (errno is set)
+ */
+static size_t write_name_index(ml_batch_reader *reader, const char *path) {
+    ml_index_writer *writer = ml_index_writer_create(ML_INDEX_SORTED | ML_INDEX_HASHED);
+    if (writer == NULL) {
+        return (size_t)-1;
+    }
+    ml_name_view views[256];
+    size_t n;
+    int rc = 0;
+    while (rc == 0 && (n = ml_batch_reader_next(reader, views, sizeof(views) / sizeof(views[0]))) > 0) {
+        for (size_t i = 0; i < n && rc == 0; i++) {
+            rc = ml_index_writer_add(writer, views[i].data, views[i].len);
+        }
+    }
+    size_t count = ml_index_writer_count(writer);
+    if (rc == 0 && !ml_batch_reader_failed(reader)) {  // never save part of a corrupt input
+        rc = ml_index_writer_save(writer, path);
+    }
+    ml_index_writer_destroy(writer);
+    return rc == 0 ? count : (size_t)-1;
+}
+
+/**
+ * Prints "<name>\t<id>" for every query found, "<name>\t-" otherwise
+ *
+ * @return Number of queries found, or (size_t)-1 if the index cannot be opened
+ */
+static size_t lookup_names(ml_batch_reader *reader, const char *path, size_t *queries) {
+    ml_name_index *index = ml_index_open(path);
+    if (index == NULL) {
+        return (size_t)-1;
+    }
+    ml_sink *sink = ml_stdout_sink();
+    ml_name_view views[256];
+    size_t n;
+    size_t found = 0;
+    *queries = 0;
+    while ((n = ml_batch_reader_next(reader, views, sizeof(views) / sizeof(views[0]))) > 0) {
+        for (size_t i = 0; i < n; i++) {
+            size_t id = ml_index_find(index, views[i].data, views[i].len);
+            char result[32];
+            if (id != ML_INDEX_NOT_FOUND) {
+                snprintf(result, sizeof(result), "\t%zu\n", id);
+                found++;
+            } else {
+                snprintf(result, sizeof(result), "\t-\n");
+            }
+            ml_sink_write(sink, views[i].data, views[i].len);
+            ml_sink_write(sink, result, strlen(result));
+        }
+        *queries += n;
+    }
+    ml_index_close(index);
+    return found;
+}
+
+/**
+ * --count: prints the top names like `sort | uniq -c | sort -rn | head`
+ * and the totals on stderr
+ *
+ * @return Exit status
+ */
+static int count_names(const char *path, const ml_freq_options *freq_opts) {
+    ml_freq_report *report;
+    if (path != NULL) {
+        report = ml_freq_count_file(path, freq_opts);
+    } else {
+        ml_batch_reader *reader = ml_batch_reader_create(stdin, 0, freq_opts->reader_flags);
+        report = reader != NULL ? ml_freq_count_reader(reader, freq_opts) : NULL;
+        ml_batch_reader_destroy(reader);
+    }
+    if (report == NULL && errno == ENOMEM && ml_mem_budget() != 0) {
+        fprintf(stderr, "%s: memory budget exceeded (--max-mem); --count=sketch counts in bounded memory\n",
+                path != NULL ? path : "stdin");
+        return 1;
+    }
+    if (report == NULL) {
+        report_input_error(path, NULL);
+        return 1;
+    }
+
+    const ml_freq_entry *top;
+    size_t n = ml_freq_top(report, &top);
+    for (size_t i = 0; i < n; i++) {
+        printf("%7" PRIu64 " %s\n", top[i].count, top[i].name);
+    }
+    const char *approx = ml_freq_is_estimate(report) ? "~" : "";
+    fprintf(stderr, "Counted %" PRIu64 " names, %s%" PRIu64 " distinct\n",
+            ml_freq_total(report), approx, ml_freq_distinct(report));
+    ml_freq_destroy(report);
+    return 0;
+}
+
+// ============================================================================
+// INTERACTIVE MODE
+// ============================================================================
+
+/**
+ * Prints the demo's "--- C++ IMPLEMENTATIONS ---" heading for `language`
+ */
+static void print_section(const char *language) {
+    size_t entries = 0;
+    for (size_t i = 0; i < ml_impl_count(); i++) {
+        entries += strcmp(ml_impl_at(i)->language, language) == 0;
+    }
+    printf("--- ");
+    for (const char *c = language; *c != '\0'; c++) {
+        putchar(toupper((unsigned char)*c));
+    }
+    printf(" IMPLEMENTATION%s ---\n\n", entries > 1 ? "S" : "");
+}
+
+/**
+ * ml_impl_ask(), logged to `record` (--record) when it is not NULL
+ *
+ * @return 1 if a name was read, 0 at end of input
+ */
+static int ask_recorded(const ml_impl *impl, char *name, size_t size, ml_session_writer *record) {
+    uint64_t start = ml_session_clock();
+    int got = ml_impl_ask(impl, name, size);
+    if (got && record != NULL) {
+        ml_session_writer_add(record, start, impl->name, name, strlen(name));
+    }
+    return got;
+}
+
+/**
+ * --impl: asks for up to `repeat` names with one implementation, stopping
+ * early at end of input; the implementation prints its own greetings
+ */
+static void run_impl(const ml_impl *impl, unsigned long repeat, ml_session_writer *record) {
     char name[100];
-    ask_name(name, sizeof(name));
-    printf("Stored in C stack: %s\n\n", name);
-
-    // 2. C Heap-based version (malloc)
-    printf("2. C Heap-based version (malloc):\n");
-    char *heap_name = ask_name_malloc(100);
-    if (heap_name != NULL) {
-        printf("Stored in C heap: %s\n", heap_name);
-        free_name(heap_name);
-    }
-    printf("\n");
-
-    // ========== C++ VERSIONS ==========
-    printf("--- C++ IMPLEMENTATIONS ---\n\n");
-
-    // 3. C++ Stack-based version (called from C)
-    printf("3. C++ Stack-based version:\n");
-    char cpp_name[100];
-    ask_name_cpp(cpp_name, sizeof(cpp_name));
-    printf("Stored in C++ stack: %s\n\n", cpp_name);
-
-    // 4. C++ Heap-based version (malloc, called from C)
-    printf("4. C++ Heap-based version (malloc):\n");
-    char *cpp_heap_name = ask_name_cpp_malloc(100);
-    if (cpp_heap_name != NULL) {
-        printf("Stored in C++ heap: %s\n", cpp_heap_name);
-        free_name_cpp(cpp_heap_name);
-    }
-    printf("\n");
-
-    // ========== RUST VERSION ==========
-    printf("--- RUST IMPLEMENTATION ---\n\n");
-
-    printf("5. Rust version:\n");
-    char rust_name[100];
-    ask_name_rust(rust_name, sizeof(rust_name));
-    printf("Rust returned: %s\n\n", rust_name);
-
-    // ========== FUTURE LANGUAGES ==========
-    // Uncomment sections as new languages are integrated:
-
-    /*
-    // ========== PYTHON VERSION ==========
-    printf("--- PYTHON IMPLEMENTATION ---\n\n");
-
-    printf("6. Python version:\n");
-    char python_name[100];
-    ask_name_python(python_name, sizeof(python_name));
-    printf("Python returned: %s\n\n", python_name);
-    */
-
-    /*
-    // ========== GO VERSION ==========
-    printf("--- GO IMPLEMENTATION ---\n\n");
-
-    printf("7. Go version:\n");
-    char go_name[100];
-    ask_name_go(go_name, sizeof(go_name));
-    printf("Go returned: %s\n\n", go_name);
-    */
-
-    /*
-    // ========== ZIG VERSION ==========
-    printf("--- ZIG IMPLEMENTATION ---\n\n");
-
-    printf("8. Zig version:\n");
-    char zig_name[100];
-    ask_name_zig(zig_name, sizeof(zig_name));
-    printf("Zig returned: %s\n\n", zig_name);
-    */
-
-    /*
-    // ========== ASSEMBLY VERSION ==========
-    printf("--- ASSEMBLY IMPLEMENTATION ---\n\n");
-
-    printf("9. Assembly version:\n");
-    char asm_name[100];
-    ask_name_asm(asm_name, sizeof(asm_name));
-    printf("Assembly returned: %s\n\n", asm_name);
-    */
-
-    /*
-    // ========== ADDITIONAL LANGUAGES ==========
-    // Add more language implementations here following the same pattern:
-    // 1. Include the header at the top
-    // 2. Add a section with clear labeling
-    // 3. Call the language-specific function
-    // 4. Display the result
-    // 5. Handle any language-specific cleanup
-    */
+    for (unsigned long i = 0; i < repeat; i++) {
+        if (!ask_recorded(impl, name, sizeof(name), record)) {
+            break;
+        }
+    }
+}
 
-    printf("=== All tests completed ===\n");
+/**
+ * Closes the --record file (if any)
+ *
+ * @return Process exit code: 1 if the recording could not be written
+ */
+static int finish_recording(ml_session_writer *record, const char *path) {
+    if (ml_session_writer_close(record) != 0) {
+        perror(path);
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * --replay: re-runs a recorded session and prints the latency report to stderr
+ *
+ * @return Process exit code
+ */
+static int replay_session(const char *path, ml_replay_speed speed, const ml_impl *only) {
+    ml_session *session = ml_session_load(path);
+    if (session == NULL) {
+        perror(path);
+        return 1;
+    }
+    size_t replayed = ml_session_replay(session, speed, only, stderr);
+    ml_session_free(session);
+    if (replayed == (size_t)-1) {
+        if (errno != EINVAL) {  // an unknown implementation has been reported already
+            perror("replay");
+        }
+        return 1;
+    }
     return 0;
+}
+
+int main(int argc, char **argv) {
+    ml_startup_mark(ML_STARTUP_MAIN);
+
+    cli_options opts;
+    if (parse_args(argc, argv, &opts) != 0) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    if (opts.startup_trace) {
+        ml_startup_trace_enable();
+    }
+    ml_mem_set_budget(opts.max_mem);
+    (void)ml_stats_enabled();  // registers the MULTILANG_STATS exit dump, so the streaming modes report memory too
+
+    if (opts.serve) {
+        return serve(&opts.server_opts);
+    }
+
+    // The streaming modes own stdout: buffer greetings and flush with writev,
+    // and whenever the input stalls (the pipeline flushes from its writer)
+    if (opts.pipeline || opts.batch != BATCH_OFF || opts.ring != RING_OFF || opts.lookup != NULL) {
+        ml_sink_set_mode(ml_stdout_sink(), ML_SINK_BUFFERED);
+        ml_input_set_idle_hook(flush_stdout_sink, NULL);
+        if (opts.compress != ML_CODEC_NONE && ml_sink_set_codec(ml_stdout_sink(), opts.compress) != 0) {
+            perror("--compress");
+            return 1;
+        }
+    }
+
+    if (opts.count) {
+        opts.freq_opts.reader_flags = opts.reader_flags | INDEX_READER_FLAGS;
+        return count_names(opts.input, &opts.freq_opts);
+    }
+
+    if (opts.write_index != NULL || opts.lookup != NULL) {
+        unsigned flags = opts.reader_flags | INDEX_READER_FLAGS;
+        ml_batch_reader *reader = opts.input != NULL ? ml_batch_reader_open(opts.input, flags)
+                                                     : ml_batch_reader_create(stdin, 0, flags);
+        if (reader == NULL) {
+            report_input_error(opts.input, NULL);
+            return 1;
+        }
+        size_t queries = 0;
+        size_t count = opts.write_index != NULL ? write_name_index(reader, opts.write_index)
+                                                : lookup_names(reader, opts.lookup, &queries);
+        int failed = input_failed(reader, opts.input);
+        ml_batch_reader_destroy(reader);
+        if (failed) {
+            return 1;
+        }
+        if (count == (size_t)-1) {
+            perror(opts.write_index != NULL ? opts.write_index : opts.lookup);
+            return 1;
+        }
+        if (opts.write_index != NULL) {
+            fprintf(stderr, "Indexed %zu names\n", count);
+        } else {
+            fprintf(stderr, "Found %zu of %zu names\n", count, queries);
+        }
+        return finish_output(0);
+    }
+
+    if (opts.ring != RING_OFF) {
+        ml_batch_reader *reader = opts.input != NULL ? ml_batch_reader_open(opts.input, opts.reader_flags)
+                                                     : ml_batch_reader_create(stdin, 0, opts.reader_flags);
+        if (reader == NULL) {
+            report_input_error(opts.input, NULL);
+            return 1;
+        }
+        size_t count = greet_ring(reader, opts.ring);
+        int failed = input_failed(reader, opts.input);
+        ml_batch_reader_destroy(reader);
+        if (failed) {
+            return 1;
+        }
+        if (count == (size_t)-1) {
+            perror("ring");
+            return 1;
+        }
+        fprintf(stderr, "Greeted %zu names\n", count);
+        return finish_output(0);
+    }
+
+    if (opts.threads != 0) {
+        ml_shard_options shard_opts;
+        ml_shard_default_options(&shard_opts);
+        if (opts.pipeline) {
+            shard_opts.backend = opts.pipeline_opts.backend == ML_PIPELINE_RUST ? ML_SHARD_RUST : ML_SHARD_CPP;
+        }
+        shard_opts.merge = opts.unordered ? ML_SHARD_UNORDERED : ML_SHARD_ORDERED;
+        shard_opts.threads = opts.threads;
+        shard_opts.reader_flags = opts.reader_flags;
+        size_t count = ml_run_sharded_file(opts.input, ml_stdout_sink(), &shard_opts);
+        if (count == (size_t)-1) {
+            report_input_error(opts.input, "--threads");
+            return 1;
+        }
+        fprintf(stderr, "Greeted %zu names\n", count);
+        return finish_output(0);
+    }
+
+    if (opts.pipeline) {
+        ml_batch_reader *reader = opts.input != NULL ? ml_batch_reader_open(opts.input, opts.reader_flags)
+                                                     : ml_batch_reader_create(stdin, 0, opts.reader_flags);
+        if (reader == NULL) {
+            report_input_error(opts.input, NULL);
+            return 1;
+        }
+        size_t count = ml_run_pipeline_reader(reader, ml_stdout_sink(), &opts.pipeline_opts);
+        int failed = input_failed(reader, opts.input);
+        ml_batch_reader_destroy(reader);
+        if (failed) {
+            return 1;
+        }
+        fprintf(stderr, "Greeted %zu names\n", count);
+        return finish_output(0);
+    }
+
+    if (opts.batch != BATCH_OFF) {
+        size_t count;
+        if (opts.batch == BATCH_RUST) {
+            count = greet_rust_batch(opts.reader_flags);
+        } else if (opts.async) {
+            count = greet_async_batch(opts.input, opts.reader_flags);
+            if (count == (size_t)-1) {
+                report_input_error(opts.input, "--async");
+                return 1;
+            }
+        } else {
+            ml_batch_reader *reader = opts.input != NULL ? ml_batch_reader_open(opts.input, opts.reader_flags)
+                                                         : ml_batch_reader_create(stdin, 0, opts.reader_flags);
+            if (reader == NULL) {
+                report_input_error(opts.input, NULL);
+                return 1;
+            }
+            count = greet_batch_reader(reader);
+            int failed = input_failed(reader, opts.input);
+            ml_batch_reader_destroy(reader);
+            if (failed) {
+                return 1;
+            }
+        }
+        fprintf(stderr, "Greeted %zu names\n", count);
+        return finish_output(0);
+    }
+
+    if (opts.replay != NULL) {
+        return replay_session(opts.replay, opts.replay_speed, opts.impl);
+    }
+
+    ml_session_writer *record = NULL;
+    if (opts.record != NULL && (record = ml_session_writer_open(opts.record)) == NULL) {
+        perror(opts.record);
+        return 1;
+    }
+
+    // Display banner at program start (skipped in quiet mode)
+    if (opts.show_banner) {
+        print_banner();
+        ml_startup_mark(ML_STARTUP_BANNER);
+    }
+
+    if (opts.impl != NULL) {
+        run_impl(opts.impl, opts.repeat, record);
+        return finish_recording(record, opts.record);
+    }
+
+    printf("=== Multi-Language Input Demo ===\n\n");
+
+    const char *language = NULL;
+    for (size_t i = 0; i < ml_impl_count(); i++) {
+        const ml_impl *impl = ml_impl_at(i);
+        if (language == NULL || strcmp(language, impl->language) != 0) {
+            language = impl->language;
+            print_section(language);
+        }
+
+        printf("%zu. %s:\n", i + 1, impl->title);
+        char name[100];
+        if (ask_recorded(impl, name, sizeof(name), record)) {
+            printf("%s: %s\n", impl->stored_as, name);
+        }
+        printf("\n");
+    }
+
+    printf("=== All tests completed ===\n");
+    return finish_recording(record, opts.record);
 }
\ No newline at end of file
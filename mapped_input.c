@@ -0,0 +1,113 @@
+#define _DEFAULT_SOURCE  // MADV_* names
+#include "mapped_input.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Read-only file mapping for the batch reader
+//
+// The file descriptor is closed as soon as the mapping exists; the mapping
+// keeps the file alive on its own.
+
+#define RELEASE_GRANULE (64u * 1024u * 1024u)  // drop pages in 64 MiB steps
+
+struct ml_mapped_file {
+    char *data;
+    size_t len;
+    size_t released;  // pages before this offset were already dropped
+};
+
+ml_mapped_file *ml_map_file(const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        int saved = errno;
+        close(fd);
+        errno = saved;
+        return NULL;
+    }
+    if (!S_ISREG(st.st_mode)) {
+        close(fd);
+        errno = ENODEV;  // what mmap() itself reports for unmappable files
+        return NULL;
+    }
+
+    ml_mapped_file *file = malloc(sizeof(*file));
+    if (file == NULL) {
+        close(fd);
+        return NULL;
+    }
+    file->data = NULL;
+    file->len = (size_t)st.st_size;
+    file->released = 0;
+
+    if (file->len > 0) {
+        void *map = mmap(NULL, file->len, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED) {
+            int saved = errno;
+            close(fd);
+            free(file);
+            errno = saved;
+            return NULL;
+        }
+        file->data = map;
+
+        // Hints only: ignore failures (e.g. no transparent huge pages for
+        // file mappings on this kernel)
+#ifdef MADV_SEQUENTIAL
+        madvise(map, file->len, MADV_SEQUENTIAL);
+#endif
+#ifdef MADV_HUGEPAGE
+        madvise(map, file->len, MADV_HUGEPAGE);
+#endif
+    }
+
+    close(fd);
+    return file;
+}
+
+const char *ml_mapped_data(const ml_mapped_file *file) {
+    return file != NULL ? file->data : NULL;
+}
+
+size_t ml_mapped_size(const ml_mapped_file *file) {
+    return file != NULL ? file->len : 0;
+}
+
+void ml_mapped_release_before(ml_mapped_file *file, size_t offset) {
+#ifdef MADV_DONTNEED
+    if (file == NULL || file->data == NULL || offset > file->len) {
+        return;
+    }
+    long page = sysconf(_SC_PAGESIZE);
+    size_t page_size = page > 0 ? (size_t)page : 4096u;
+    size_t end = offset / page_size * page_size;
+    if (end < file->released + RELEASE_GRANULE) {
+        return;  // not worth a syscall yet
+    }
+    // The mapping is read-only and private, so dropped pages are simply
+    // re-read from the page cache if they are touched again
+    madvise(file->data + file->released, end - file->released, MADV_DONTNEED);
+    file->released = end;
+#else
+    (void)file;
+    (void)offset;
+#endif
+}
+
+void ml_unmap_file(ml_mapped_file *file) {
+    if (file == NULL) {
+        return;
+    }
+    if (file->data != NULL) {
+        munmap(file->data, file->len);
+    }
+    free(file);
+}
@@ -0,0 +1,61 @@
+#ifndef MULTILANG_MAPPED_INPUT_H
+#define MULTILANG_MAPPED_INPUT_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ============================================================================
+// MEMORY-MAPPED INPUT FILES
+// ============================================================================
+// Reading a name dump through stdio copies every byte twice before any work
+// happens (kernel -> stdio buffer -> caller buffer). Mapping the file instead
+// lets the batch reader hand out views straight into the page cache.
+//
+// The mapping is advised MADV_SEQUENTIAL (aggressive read-ahead, early
+// reclaim behind the reader) and, where the kernel supports it,
+// MADV_HUGEPAGE to cut TLB misses on multi-GB files. Both are hints; mapping
+// succeeds without them.
+//
+// Only regular files can be mapped. For pipes, FIFOs and terminals use
+// ml_batch_reader_open() (name_batch.h), which falls back to chunked reads.
+
+typedef struct ml_mapped_file ml_mapped_file;
+
+/**
+ * Maps `path` read-only
+ *
+ * @return Mapping handle, or NULL if the file cannot be opened or is not a
+ *         regular file (errno is set)
+ */
+ml_mapped_file *ml_map_file(const char *path);
+
+/**
+ * @return First byte of the mapping (NULL for an empty file)
+ */
+const char *ml_mapped_data(const ml_mapped_file *file);
+
+/**
+ * @return Size of the file in bytes
+ */
+size_t ml_mapped_size(const ml_mapped_file *file);
+
+/**
+ * Tells the kernel the pages before `offset` will not be read again, so the
+ * resident size of a single pass stays bounded instead of growing to the
+ * whole file (the data stays in the page cache)
+ */
+void ml_mapped_release_before(ml_mapped_file *file, size_t offset);
+
+/**
+ * Unmaps the file; every view into it becomes invalid
+ */
+void ml_unmap_file(ml_mapped_file *file);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //MULTILANG_MAPPED_INPUT_H
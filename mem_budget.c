@@ -0,0 +1,104 @@
+#include "mem_budget.h"
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+// Process-wide memory budget
+//
+// Usage is one atomic counter, so charging and releasing never lock. Buffers
+// are charged when they are allocated or grown, not per name, so the counter
+// stays off the hot paths.
+
+static atomic_size_t budget;
+static atomic_size_t current;
+static atomic_size_t peak;
+
+static void raise_peak(size_t now) {
+    size_t seen = atomic_load_explicit(&peak, memory_order_relaxed);
+    while (now > seen &&
+           !atomic_compare_exchange_weak_explicit(&peak, &seen, now, memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+void ml_mem_set_budget(size_t bytes) {
+    atomic_store_explicit(&budget, bytes, memory_order_relaxed);
+}
+
+size_t ml_mem_budget(void) {
+    return atomic_load_explicit(&budget, memory_order_relaxed);
+}
+
+size_t ml_mem_available(void) {
+    size_t limit = ml_mem_budget();
+    size_t used = ml_mem_current();
+    if (limit == 0) {
+        return SIZE_MAX;
+    }
+    return used < limit ? limit - used : 0;
+}
+
+void ml_mem_charge(size_t bytes) {
+    raise_peak(atomic_fetch_add_explicit(&current, bytes, memory_order_relaxed) + bytes);
+}
+
+int ml_mem_try_charge(size_t bytes) {
+    size_t limit = ml_mem_budget();
+    size_t used = atomic_load_explicit(&current, memory_order_relaxed);
+    for (;;) {
+        if (limit != 0 && (used > limit || bytes > limit - used)) {
+            return -1;
+        }
+        if (atomic_compare_exchange_weak_explicit(&current, &used, used + bytes,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+            raise_peak(used + bytes);
+            return 0;
+        }
+    }
+}
+
+int ml_mem_try_grow(size_t old_cap, size_t new_cap) {
+    if (new_cap <= ML_MEM_LINE_FLOOR) {
+        ml_mem_charge(new_cap - old_cap);
+        return 0;
+    }
+    return ml_mem_try_charge(new_cap - old_cap);
+}
+
+void ml_mem_release(size_t bytes) {
+    atomic_fetch_sub_explicit(&current, bytes, memory_order_relaxed);
+}
+
+size_t ml_mem_current(void) {
+    return atomic_load_explicit(&current, memory_order_relaxed);
+}
+
+size_t ml_mem_peak(void) {
+    return atomic_load_explicit(&peak, memory_order_relaxed);
+}
+
+int ml_mem_parse_size(const char *text, size_t *bytes) {
+    char *end;
+    unsigned long long value = strtoull(text, &end, 10);
+    if (end == text || text[0] == '-') {
+        return -1;
+    }
+    unsigned shift = 0;
+    switch (*end) {
+        case 'k': case 'K': shift = 10; end++; break;
+        case 'm': case 'M': shift = 20; end++; break;
+        case 'g': case 'G': shift = 30; end++; break;
+        case 't': case 'T': shift = 40; end++; break;
+        default: break;
+    }
+    if (*end == 'i') {
+        end++;  // "MiB" spelling
+    }
+    if (*end == 'B' || *end == 'b') {
+        end++;
+    }
+    if (*end != '\0' || value == 0 || value > (SIZE_MAX >> shift)) {
+        return -1;
+    }
+    *bytes = (size_t)value << shift;
+    return 0;
+}
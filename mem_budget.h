@@ -0,0 +1,107 @@
+#ifndef MULTILANG_MEM_BUDGET_H
+#define MULTILANG_MEM_BUDGET_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ============================================================================
+// PROCESS-WIDE MEMORY BUDGET (--max-mem)
+// ============================================================================
+// Every buffer, queue and pool of the input/output layers (batch readers,
+// async input, line readers, output sinks, rings, pipeline batches, shard
+// blocks) is charged here while it is allocated, so current and peak usage
+// are known (MULTILANG_STATS reports them) and can be capped.
+//
+// Layers stay under the budget in three ways:
+//
+//   - fixed buffers are sized from ml_mem_available() when they are created
+//     (smaller read chunks, sink and rings, fewer pipeline batches) and are
+//     then charged with ml_mem_charge()
+//   - queues between threads are capped in bytes, so a producer waits for
+//     the consumer instead of growing (the pipeline's free-batch queue, the
+//     sharded block queues): backpressure
+//   - growing buffers go through ml_mem_try_grow(); a line longer than the
+//     budget allows is cut
+//
+// The --count tables (name_intern.h, name_freq.h) and the --write-index
+// staging buffers (name_index.h) are charged the same way and fail with
+// ENOMEM past the budget. The count-min sketch has a fixed size, so it is
+// charged but never refused.
+//
+// Not charged: memory the caller owns through a C++ type that frees itself
+// (ask_name_managed()'s std::string, ask_name_unique()'s buffer). Its
+// release cannot be seen here, so ask_name_managed() only cuts a name to
+// ml_mem_available().
+//
+// With no budget set (the default) nothing is refused; usage is still
+// accounted.
+
+// A line buffer may always grow to this size, so a budget taken up by the
+// fixed buffers still lets ordinary names through whole
+#define ML_MEM_LINE_FLOOR 4096u
+
+/**
+ * Sets the budget in bytes; 0 means unlimited
+ */
+void ml_mem_set_budget(size_t bytes);
+
+/**
+ * @return The budget in bytes, 0 if unlimited
+ */
+size_t ml_mem_budget(void);
+
+/**
+ * @return Bytes still available under the budget (SIZE_MAX if unlimited)
+ */
+size_t ml_mem_available(void);
+
+/**
+ * Charges `bytes` unconditionally (may exceed the budget)
+ */
+void ml_mem_charge(size_t bytes);
+
+/**
+ * Charges `bytes` if they fit under the budget
+ *
+ * @return 0 on success, -1 if they would exceed it (nothing is charged)
+ */
+int ml_mem_try_charge(size_t bytes);
+
+/**
+ * Charges the growth of a line buffer from `old_cap` to `new_cap` bytes:
+ * always within ML_MEM_LINE_FLOOR, otherwise only if it fits the budget
+ *
+ * @return 0 on success, -1 if the buffer must not grow (nothing is charged)
+ */
+int ml_mem_try_grow(size_t old_cap, size_t new_cap);
+
+/**
+ * Returns `bytes` charged by any of the functions above
+ */
+void ml_mem_release(size_t bytes);
+
+/**
+ * @return Bytes currently charged
+ */
+size_t ml_mem_current(void);
+
+/**
+ * @return Highest value ml_mem_current() has reached
+ */
+size_t ml_mem_peak(void);
+
+/**
+ * Parses a size such as "512M", "2G", "64k" or "1048576" (binary units)
+ *
+ * @return 0 on success, -1 if `text` is not a positive size
+ */
+int ml_mem_parse_size(const char *text, size_t *bytes);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //MULTILANG_MEM_BUDGET_H
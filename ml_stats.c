@@ -0,0 +1,253 @@
+#include "ml_stats.h"
+#include "perf_counters.h"
+#include "mem_budget.h"
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Per-implementation counters
+//
+// One cache-line-aligned block of relaxed atomics per entry point, so two
+// implementations running on different threads never share a line.
+
+typedef struct {
+    _Alignas(64) atomic_uint_fast64_t calls;
+    atomic_uint_fast64_t total_ns;
+    atomic_uint_fast64_t peak_ns;
+    atomic_uint_fast64_t bytes_read;
+    atomic_uint_fast64_t bytes_copied;
+    atomic_uint_fast64_t allocs;
+    atomic_uint_fast64_t alloc_bytes;
+    atomic_uint_fast64_t frees;
+} entry_counters;
+
+static entry_counters counters[ML_STATS_ENTRY_COUNT];
+
+static const char *const ENTRY_NAMES[ML_STATS_ENTRY_COUNT] = {
+    "ask_name",
+    "ask_name_malloc",
+    "ask_name_arena",
+    "ask_name_cpp",
+    "ask_name_cpp_malloc",
+    "ask_name_cpp_arena",
+    "ask_name_view",
+    "ask_name_unique",
+    "ask_name_managed",
+    "ask_name_rust",
+    "ask_name_fixed",
+    "ask_name_interned",
+    "ask_name_string",
+    "async_ask_name",
+};
+
+static const char *const ENTRY_LANGUAGES[ML_STATS_ENTRY_COUNT] = {
+    "C",
+    "C",
+    "C",
+    "C++",
+    "C++",
+    "C++",
+    "C++",
+    "C++",
+    "C++",
+    "Rust",
+    "C++",
+    "C++",
+    "C++",
+    "C++",
+};
+
+enum { STATS_UNKNOWN = -1, STATS_OFF = 0, STATS_TEXT = 1, STATS_JSON = 2 };
+
+static atomic_int stats_mode = STATS_UNKNOWN;
+
+static void dump_at_exit(void) {
+    ml_stats_dump(stderr, atomic_load_explicit(&stats_mode, memory_order_relaxed) == STATS_JSON);
+}
+
+/**
+ * Reads MULTILANG_STATS once; the first caller also registers the exit dump
+ */
+static int current_mode(void) {
+    int mode = atomic_load_explicit(&stats_mode, memory_order_relaxed);
+    if (mode != STATS_UNKNOWN) {
+        return mode;
+    }
+
+    const char *env = getenv("MULTILANG_STATS");
+    if (env == NULL || env[0] == '\0' || strcmp(env, "0") == 0) {
+        mode = STATS_OFF;
+    } else if (strcmp(env, "json") == 0) {
+        mode = STATS_JSON;
+    } else {
+        mode = STATS_TEXT;
+    }
+
+    int expected = STATS_UNKNOWN;
+    if (atomic_compare_exchange_strong(&stats_mode, &expected, mode) && mode != STATS_OFF) {
+        atexit(dump_at_exit);
+    }
+    return atomic_load_explicit(&stats_mode, memory_order_relaxed);
+}
+
+static int valid_entry(ml_stats_entry entry) {
+    return (unsigned)entry < ML_STATS_ENTRY_COUNT;
+}
+
+int ml_stats_enabled(void) {
+    return current_mode() != STATS_OFF;
+}
+
+uint64_t ml_stats_begin(void) {
+    if (current_mode() == STATS_OFF) {
+        return 0;
+    }
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    uint64_t start = (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+    ml_perf_begin(start);
+    return start;
+}
+
+void ml_stats_end(ml_stats_entry entry, uint64_t start, size_t bytes_read, size_t bytes_copied) {
+    if (start == 0 || !valid_entry(entry)) {
+        return;
+    }
+    ml_perf_end(entry, start);
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    uint64_t elapsed = (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec - start;
+
+    entry_counters *c = &counters[entry];
+    atomic_fetch_add_explicit(&c->calls, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&c->total_ns, elapsed, memory_order_relaxed);
+    atomic_fetch_add_explicit(&c->bytes_read, bytes_read, memory_order_relaxed);
+    atomic_fetch_add_explicit(&c->bytes_copied, bytes_copied, memory_order_relaxed);
+
+    uint_fast64_t peak = atomic_load_explicit(&c->peak_ns, memory_order_relaxed);
+    while (elapsed > peak &&
+           !atomic_compare_exchange_weak_explicit(&c->peak_ns, &peak, elapsed,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+void ml_stats_alloc(ml_stats_entry entry, size_t bytes) {
+    if (current_mode() == STATS_OFF || !valid_entry(entry)) {
+        return;
+    }
+    atomic_fetch_add_explicit(&counters[entry].allocs, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&counters[entry].alloc_bytes, bytes, memory_order_relaxed);
+}
+
+void ml_stats_free(ml_stats_entry entry) {
+    if (current_mode() == STATS_OFF || !valid_entry(entry)) {
+        return;
+    }
+    atomic_fetch_add_explicit(&counters[entry].frees, 1, memory_order_relaxed);
+}
+
+void ml_stats_snapshot(ml_stats_entry entry, ml_stats_counters *out) {
+    if (out == NULL) {
+        return;
+    }
+    memset(out, 0, sizeof(*out));
+    if (!valid_entry(entry)) {
+        return;
+    }
+    entry_counters *c = &counters[entry];
+    out->calls = atomic_load_explicit(&c->calls, memory_order_relaxed);
+    out->total_ns = atomic_load_explicit(&c->total_ns, memory_order_relaxed);
+    out->peak_ns = atomic_load_explicit(&c->peak_ns, memory_order_relaxed);
+    out->bytes_read = atomic_load_explicit(&c->bytes_read, memory_order_relaxed);
+    out->bytes_copied = atomic_load_explicit(&c->bytes_copied, memory_order_relaxed);
+    out->allocs = atomic_load_explicit(&c->allocs, memory_order_relaxed);
+    out->alloc_bytes = atomic_load_explicit(&c->alloc_bytes, memory_order_relaxed);
+    out->frees = atomic_load_explicit(&c->frees, memory_order_relaxed);
+}
+
+const char *ml_stats_entry_name(ml_stats_entry entry) {
+    return valid_entry(entry) ? ENTRY_NAMES[entry] : "unknown";
+}
+
+const char *ml_stats_entry_language(ml_stats_entry entry) {
+    return valid_entry(entry) ? ENTRY_LANGUAGES[entry] : "unknown";
+}
+
+void ml_stats_memory_snapshot(ml_stats_memory *out) {
+    out->current = ml_mem_current();
+    out->peak = ml_mem_peak();
+    out->budget = ml_mem_budget();
+}
+
+void ml_stats_dump(FILE *out, int json) {
+    if (json) {
+        fprintf(out, "{");
+    } else {
+        fprintf(out, "\n%-20s %8s %12s %10s %10s %12s %12s %8s %8s\n",
+                "entry point", "calls", "avg ns", "peak ns", "total ms",
+                "bytes read", "bytes copied", "allocs", "frees");
+    }
+
+    int first = 1;
+    for (int i = 0; i < ML_STATS_ENTRY_COUNT; i++) {
+        ml_stats_counters c;
+        ml_stats_snapshot((ml_stats_entry)i, &c);
+        if (c.calls == 0 && c.allocs == 0 && c.frees == 0) {
+            continue;
+        }
+
+        if (json) {
+            fprintf(out,
+                    "%s\"%s\":{\"calls\":%llu,\"total_ns\":%llu,\"peak_ns\":%llu,"
+                    "\"bytes_read\":%llu,\"bytes_copied\":%llu,\"allocs\":%llu,"
+                    "\"alloc_bytes\":%llu,\"frees\":%llu",
+                    first ? "" : ",", ENTRY_NAMES[i],
+                    (unsigned long long)c.calls, (unsigned long long)c.total_ns,
+                    (unsigned long long)c.peak_ns, (unsigned long long)c.bytes_read,
+                    (unsigned long long)c.bytes_copied, (unsigned long long)c.allocs,
+                    (unsigned long long)c.alloc_bytes, (unsigned long long)c.frees);
+            ml_perf_dump_entry_json(out, (ml_stats_entry)i);
+            fprintf(out, "}");
+        } else {
+            fprintf(out, "%-20s %8llu %12.0f %10llu %10.3f %12llu %12llu %8llu %8llu\n",
+                    ENTRY_NAMES[i], (unsigned long long)c.calls,
+                    c.calls ? (double)c.total_ns / (double)c.calls : 0.0,
+                    (unsigned long long)c.peak_ns, (double)c.total_ns / 1e6,
+                    (unsigned long long)c.bytes_read, (unsigned long long)c.bytes_copied,
+                    (unsigned long long)c.allocs, (unsigned long long)c.frees);
+        }
+        first = 0;
+    }
+
+    ml_stats_memory mem;
+    ml_stats_memory_snapshot(&mem);
+    if (json) {
+        fprintf(out, "%s\"memory\":{\"current\":%llu,\"peak\":%llu,\"budget\":%llu}}\n", first ? "" : ",",
+                (unsigned long long)mem.current, (unsigned long long)mem.peak, (unsigned long long)mem.budget);
+    } else {
+        fprintf(out, "\nmemory: %llu bytes now, %llu peak", (unsigned long long)mem.current,
+                (unsigned long long)mem.peak);
+        if (mem.budget != 0) {
+            fprintf(out, " (budget %llu)", (unsigned long long)mem.budget);
+        }
+        fprintf(out, "\n");
+        ml_perf_dump(out);
+    }
+    fflush(out);
+}
+
+void ml_stats_reset(void) {
+    for (int i = 0; i < ML_STATS_ENTRY_COUNT; i++) {
+        entry_counters *c = &counters[i];
+        atomic_store_explicit(&c->calls, 0, memory_order_relaxed);
+        atomic_store_explicit(&c->total_ns, 0, memory_order_relaxed);
+        atomic_store_explicit(&c->peak_ns, 0, memory_order_relaxed);
+        atomic_store_explicit(&c->bytes_read, 0, memory_order_relaxed);
+        atomic_store_explicit(&c->bytes_copied, 0, memory_order_relaxed);
+        atomic_store_explicit(&c->allocs, 0, memory_order_relaxed);
+        atomic_store_explicit(&c->alloc_bytes, 0, memory_order_relaxed);
+        atomic_store_explicit(&c->frees, 0, memory_order_relaxed);
+    }
+    ml_perf_reset();
+}
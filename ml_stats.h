@@ -0,0 +1,172 @@
+#ifndef MULTILANG_ML_STATS_H
+#define MULTILANG_ML_STATS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ============================================================================
+// PER-IMPLEMENTATION STATISTICS (C ABI, used by C, C++ and Rust)
+// ============================================================================
+// Every ask_name_* entry point records its call count, cumulative and peak
+// latency, bytes read and copied, and heap allocations. Counters are atomic,
+// so entry points may be called from any thread.
+//
+// Recording is off unless MULTILANG_STATS is set in the environment:
+//
+//   MULTILANG_STATS=text   human-readable table on stderr at exit
+//   MULTILANG_STATS=json   one JSON object on stderr at exit
+//
+// When it is off, ml_stats_begin() returns 0 and every other call returns
+// immediately, so the entry points only pay for one predictable branch.
+//
+// Builds configured with -DMULTILANG_PERF_COUNTERS=ON also count CPU events
+// per call while recording (perf_counters.h).
+//
+// Frees are recorded where the caller hands a result back through a free
+// function (free_name(), free_name_cpp(), ...). Results that free themselves
+// (a std::unique_ptr or std::string returned by a C++ entry point) only count
+// their allocations, so `frees` stays 0 for those entry points.
+//
+// The dump also reports the current and peak bytes charged to the --max-mem
+// budget by the input/output layers (mem_budget.h).
+
+// Keep in sync with ML_STATS_ASK_NAME_RUST in src/greet_lib.rs
+typedef enum {
+    ML_STATS_ASK_NAME = 0,
+    ML_STATS_ASK_NAME_MALLOC,
+    ML_STATS_ASK_NAME_ARENA,
+    ML_STATS_ASK_NAME_CPP,
+    ML_STATS_ASK_NAME_CPP_MALLOC,
+    ML_STATS_ASK_NAME_CPP_ARENA,
+    ML_STATS_ASK_NAME_VIEW,
+    ML_STATS_ASK_NAME_UNIQUE,
+    ML_STATS_ASK_NAME_MANAGED,
+    ML_STATS_ASK_NAME_RUST,
+    ML_STATS_ASK_NAME_FIXED,   // new entries go last so the Rust value stays put
+    ML_STATS_ASK_NAME_INTERNED,
+    ML_STATS_ASK_NAME_STRING,
+    ML_STATS_ASK_NAME_ASYNC,
+    ML_STATS_ENTRY_COUNT
+} ml_stats_entry;
+
+typedef struct ml_stats_counters {
+    uint64_t calls;
+    uint64_t total_ns;
+    uint64_t peak_ns;
+    uint64_t bytes_read;
+    uint64_t bytes_copied;
+    uint64_t allocs;
+    uint64_t alloc_bytes;
+    uint64_t frees;
+} ml_stats_counters;
+
+typedef struct ml_stats_memory {
+    uint64_t current;  // bytes charged to the memory budget now
+    uint64_t peak;     // most bytes ever charged at once
+    uint64_t budget;   // --max-mem limit, 0 if unlimited
+} ml_stats_memory;
+
+/**
+ * @return Non-zero when MULTILANG_STATS enabled recording
+ */
+int ml_stats_enabled(void);
+
+/**
+ * Starts timing one call
+ *
+ * @return Start timestamp to pass to ml_stats_end(), or 0 when disabled
+ */
+uint64_t ml_stats_begin(void);
+
+/**
+ * Finishes a call started with ml_stats_begin()
+ *
+ * @param bytes_read Bytes consumed from the input (including the newline)
+ * @param bytes_copied Bytes copied into the caller-visible result
+ */
+void ml_stats_end(ml_stats_entry entry, uint64_t start, size_t bytes_read, size_t bytes_copied);
+
+/**
+ * Records one heap allocation of `bytes` made on behalf of `entry`
+ */
+void ml_stats_alloc(ml_stats_entry entry, size_t bytes);
+
+/**
+ * Records that a result allocated by `entry` was freed
+ */
+void ml_stats_free(ml_stats_entry entry);
+
+/**
+ * Copies the current counters of one entry point
+ */
+void ml_stats_snapshot(ml_stats_entry entry, ml_stats_counters *out);
+
+/**
+ * Copies the memory budget usage (recorded whether or not stats are enabled)
+ */
+void ml_stats_memory_snapshot(ml_stats_memory *out);
+
+/**
+ * @return Entry point name, e.g. "ask_name_cpp_malloc"
+ */
+const char *ml_stats_entry_name(ml_stats_entry entry);
+
+/**
+ * @return Language of the entry point: "C", "C++" or "Rust"
+ */
+const char *ml_stats_entry_language(ml_stats_entry entry);
+
+/**
+ * Writes all entry points that were called and the memory usage, as a
+ * table or as JSON
+ */
+void ml_stats_dump(FILE *out, int json);
+
+/**
+ * Zeroes every counter
+ */
+void ml_stats_reset(void);
+
+#ifdef __cplusplus
+}
+
+// C++-only interface: records one call for the lifetime of the scope
+#include <string>
+namespace MlStats {
+    class Scope {
+    public:
+        explicit Scope(ml_stats_entry entry) : entry_(entry), start_(ml_stats_begin()) {}
+        ~Scope() {
+            if (start_ != 0) {
+                ml_stats_end(entry_, start_, bytes_read, bytes_copied);
+            }
+        }
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+        void alloc(size_t bytes) const { ml_stats_alloc(entry_, bytes); }
+
+        // Records the heap buffer of `s`, if it outgrew the small-string buffer
+        void alloc_string(const std::string &s) const {
+            if (s.capacity() > std::string().capacity()) {
+                alloc(s.capacity() + 1);
+            }
+        }
+
+        size_t bytes_read = 0;
+        size_t bytes_copied = 0;
+
+    private:
+        ml_stats_entry entry_;
+        uint64_t start_;
+    };
+}
+#endif
+
+#endif //MULTILANG_ML_STATS_H
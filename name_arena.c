@@ -0,0 +1,184 @@
+#include "name_arena.h"
+#include "output_sink.h"
+#include "greeting_format.h"
+#include "ml_stats.h"
+#include "mem_budget.h"
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <stdlib.h>
+
+// Bump allocator for names
+//
+// Blocks form a singly linked list with the active block at the head.
+// Allocation only moves the `used` offset forward; nothing is freed
+// individually.
+
+typedef struct arena_block {
+    struct arena_block *next;
+    size_t cap;
+    size_t used;
+    char data[];
+} arena_block;
+
+struct name_arena {
+    arena_block *head;
+    size_t block_size;
+    size_t bytes_used;
+    size_t bytes_reserved;
+};
+
+static arena_block *new_block(name_arena *arena, size_t min_size) {
+    size_t cap = arena->block_size > min_size ? arena->block_size : min_size;
+    // The first block is what the arena needs to exist; later ones are
+    // refused once they would exceed the --max-mem budget
+    if (arena->head == NULL) {
+        ml_mem_charge(sizeof(arena_block) + cap);
+    } else if (ml_mem_try_charge(sizeof(arena_block) + cap) != 0) {
+        return NULL;
+    }
+    arena_block *block = malloc(sizeof(arena_block) + cap);
+    if (block == NULL) {
+        ml_mem_release(sizeof(arena_block) + cap);
+        return NULL;
+    }
+    block->next = arena->head;
+    block->cap = cap;
+    block->used = 0;
+    arena->head = block;
+    arena->bytes_reserved += cap;
+    return block;
+}
+
+/**
+ * Returns a block with at least `size` free bytes, adding one if needed
+ */
+static arena_block *block_with_room(name_arena *arena, size_t size) {
+    arena_block *block = arena->head;
+    if (block != NULL && block->cap - block->used >= size) {
+        return block;
+    }
+    return new_block(arena, size);
+}
+
+name_arena *name_arena_create(size_t block_size) {
+    name_arena *arena = malloc(sizeof(*arena));
+    if (arena == NULL) {
+        return NULL;
+    }
+    arena->head = NULL;
+    arena->block_size = block_size != 0 ? block_size : NAME_ARENA_DEFAULT_BLOCK;
+    arena->bytes_used = 0;
+    arena->bytes_reserved = 0;
+
+    if (new_block(arena, 0) == NULL) {
+        free(arena);
+        return NULL;
+    }
+    return arena;
+}
+
+void *name_arena_alloc(name_arena *arena, size_t size) {
+    if (arena == NULL) {
+        return NULL;
+    }
+    arena_block *block = block_with_room(arena, size);
+    if (block == NULL) {
+        return NULL;
+    }
+    void *ptr = block->data + block->used;
+    block->used += size;
+    arena->bytes_used += size;
+    return ptr;
+}
+
+char *name_arena_strndup(name_arena *arena, const char *text, size_t len) {
+    char *copy = name_arena_alloc(arena, len + 1);
+    if (copy != NULL) {
+        memcpy(copy, text, len);
+        copy[len] = '\0';
+    }
+    return copy;
+}
+
+char *ask_name_arena(name_arena *arena, size_t size) {
+    if (arena == NULL || size == 0) {
+        return NULL;
+    }
+    if (size > INT_MAX) {
+        size = INT_MAX;
+    }
+    uint64_t stats_start = ml_stats_begin();
+
+    // Reserve room for the longest possible line, read directly into the
+    // block, then keep only what the name actually uses
+    size_t reserved = arena->bytes_reserved;
+    arena_block *block = block_with_room(arena, size);
+    if (block == NULL) {
+        fprintf(stderr, "Failed to allocate memory\n");
+        ml_stats_end(ML_STATS_ASK_NAME_ARENA, stats_start, 0, 0);
+        return NULL;
+    }
+    if (arena->bytes_reserved != reserved) {
+        // A new block is the only heap traffic an arena causes
+        ml_stats_alloc(ML_STATS_ASK_NAME_ARENA, arena->bytes_reserved - reserved);
+    }
+    char *name = block->data + block->used;
+
+    printf("Enter your name: ");
+    if (fgets(name, (int) size, stdin) == NULL) {
+        ml_stats_end(ML_STATS_ASK_NAME_ARENA, stats_start, 0, 0);
+        return NULL;  // nothing was committed, so nothing to undo
+    }
+
+    size_t len = strcspn(name, "\n");
+    size_t bytes_read = len + (name[len] == '\n');
+    name[len] = '\0'; // remove newline character
+    block->used += len + 1;
+    arena->bytes_used += len + 1;
+
+    ml_greeting_write(ml_stdout_sink(), ML_GREETING_C, name, len);
+    ml_stats_end(ML_STATS_ASK_NAME_ARENA, stats_start, bytes_read, len + 1);
+    return name;
+}
+
+void name_arena_reset(name_arena *arena) {
+    if (arena == NULL || arena->head == NULL) {
+        return;
+    }
+
+    // Keep the oldest block (the tail of the list), release the rest
+    arena_block *block = arena->head;
+    while (block->next != NULL) {
+        arena_block *next = block->next;
+        arena->bytes_reserved -= block->cap;
+        ml_mem_release(sizeof(arena_block) + block->cap);
+        free(block);
+        block = next;
+    }
+    block->used = 0;
+    arena->head = block;
+    arena->bytes_used = 0;
+}
+
+void name_arena_destroy(name_arena *arena) {
+    if (arena == NULL) {
+        return;
+    }
+    arena_block *block = arena->head;
+    while (block != NULL) {
+        arena_block *next = block->next;
+        ml_mem_release(sizeof(arena_block) + block->cap);
+        free(block);
+        block = next;
+    }
+    free(arena);
+}
+
+size_t name_arena_bytes_used(const name_arena *arena) {
+    return arena != NULL ? arena->bytes_used : 0;
+}
+
+size_t name_arena_bytes_reserved(const name_arena *arena) {
+    return arena != NULL ? arena->bytes_reserved : 0;
+}
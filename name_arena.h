@@ -0,0 +1,76 @@
+#ifndef MULTILANG_NAME_ARENA_H
+#define MULTILANG_NAME_ARENA_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ============================================================================
+// NAME ARENA (bump allocator)
+// ============================================================================
+// ask_name_malloc() allocates a full `size`-byte buffer per name and every
+// name is freed on its own. An arena instead packs names back to back into
+// large blocks (each name takes strlen + 1 bytes) and releases all of them in
+// a single name_arena_reset() or name_arena_destroy() call.
+//
+// Names returned from an arena must NOT be passed to free() or free_name().
+
+#define NAME_ARENA_DEFAULT_BLOCK (64u * 1024u)
+
+typedef struct name_arena name_arena;
+
+/**
+ * Creates an arena whose blocks hold `block_size` bytes
+ * (0 selects NAME_ARENA_DEFAULT_BLOCK)
+ *
+ * @return Arena handle, or NULL if allocation failed
+ */
+name_arena *name_arena_create(size_t block_size);
+
+/**
+ * Allocates `size` bytes (not zeroed) from the arena
+ *
+ * @return Pointer valid until the next reset/destroy, or NULL on failure
+ */
+void *name_arena_alloc(name_arena *arena, size_t size);
+
+/**
+ * Copies `len` bytes of `text` into the arena and null-terminates the copy
+ */
+char *name_arena_strndup(name_arena *arena, const char *text, size_t len);
+
+/**
+ * C arena version of ask_name_malloc(): reads one line (at most size - 1
+ * characters) from stdin straight into the arena
+ *
+ * @return Pointer to the name inside the arena, or NULL on failure
+ */
+char *ask_name_arena(name_arena *arena, size_t size);
+
+/**
+ * Releases every name at once. The first block is kept for reuse.
+ */
+void name_arena_reset(name_arena *arena);
+
+/**
+ * Releases the arena and all of its blocks (safe with NULL)
+ */
+void name_arena_destroy(name_arena *arena);
+
+/**
+ * @return Bytes handed out since the last reset (including terminators)
+ */
+size_t name_arena_bytes_used(const name_arena *arena);
+
+/**
+ * @return Bytes currently reserved from the heap for blocks
+ */
+size_t name_arena_bytes_reserved(const name_arena *arena);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //MULTILANG_NAME_ARENA_H
@@ -0,0 +1,512 @@
+#include "name_batch.h"
+#include "line_scan.h"
+#include "utf8_scan.h"
+#include "mem_budget.h"
+#include "compressed_io.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+// Streaming name ingestion
+//
+// One reader owns a single buffer that is refilled in large fread() calls.
+// Complete lines are handed out as views into that buffer; a partial line at
+// the end of a chunk is moved to the front before the next refill. Newlines
+// are located a whole batch at a time with the SIMD kernel in line_scan.c.
+//
+// A memory reader (ml_batch_reader_create_mem / a mapped file) has the whole
+// input in `buf` from the start: it never refills, and views point straight
+// into the caller's memory.
+//
+// The stream buffer and the newline positions are charged to the --max-mem
+// budget (mem_budget.h). A line that would need the buffer to grow past the
+// budget is cut: what is buffered is handed out as the line and the rest of
+// it, up to the next '\n', is skipped.
+//
+// ML_BATCH_NORMALIZE needs writable lines: stream readers normalize in `buf`,
+// memory readers copy each line into `scratch` first. The scratch buffer is
+// sized for a whole batch before any view of it is handed out, so growing it
+// never moves a view the caller still holds.
+//
+// A stream that starts with a zstd or lz4 frame is decoded by a helper
+// thread (compressed_io.h) and refills read decoded bytes from it; a
+// compressed file is read that way too instead of being mapped.
+//
+// fread() only returns once the whole chunk is filled, so on a pipe or
+// terminal a refill makes the descriptor non-blocking for its duration:
+// fread() then stops at what is ready, and when nothing is, the thread's
+// idle hook runs before the reader waits in poll(). Names that trickle in
+// are handed out at once, and their output is flushed before the wait.
+
+#define ML_BATCH_MIN_CHUNK 4096u
+
+struct ml_batch_reader {
+    FILE *stream;
+    FILE *owned_stream;     // opened by ml_batch_reader_open(), closed on destroy
+    ml_zreader *zin;        // decoder of a compressed stream, or NULL
+    ml_mapped_file *mapping;  // owned file mapping, or NULL
+    int owns_buf;           // 0 for memory readers: buf belongs to the caller
+    char *buf;
+    size_t cap;      // allocated size of buf
+    size_t start;    // first byte not yet handed out
+    size_t end;      // one past the last valid byte
+    size_t *positions;      // newline offsets of the batch being split
+    size_t positions_cap;
+    char *scratch;          // normalized lines of memory readers (ML_BATCH_NORMALIZE)
+    size_t scratch_cap;
+    size_t scratch_used;
+    unsigned flags;
+    int eof;
+    int skip_line;   // the current line was cut: drop input up to its '\n'
+    int may_block;   // pipe, FIFO or terminal: refills take what is ready
+};
+
+static _Thread_local ml_input_idle_fn idle_hook;
+static _Thread_local void *idle_ctx;
+
+void ml_input_set_idle_hook(ml_input_idle_fn hook, void *ctx) {
+    idle_hook = hook;
+    idle_ctx = ctx;
+}
+
+void ml_input_idle(void) {
+    if (idle_hook != NULL) {
+        idle_hook(idle_ctx);
+    }
+}
+
+ml_batch_reader *ml_batch_reader_create(FILE *stream, size_t chunk_size, unsigned flags) {
+    if (stream == NULL) {
+        return NULL;
+    }
+    if (chunk_size == 0) {
+        chunk_size = ML_BATCH_DEFAULT_CHUNK;
+        while (chunk_size > ML_BATCH_MIN_CHUNK && chunk_size > ml_mem_available()) {
+            chunk_size /= 2;  // leave the rest of a small --max-mem budget to the other stages
+        }
+    }
+
+    ml_batch_reader *reader = malloc(sizeof(*reader));
+    if (reader == NULL) {
+        return NULL;
+    }
+    reader->buf = malloc(chunk_size);
+    if (reader->buf == NULL) {
+        free(reader);
+        return NULL;
+    }
+    ml_mem_charge(chunk_size);
+
+    reader->stream = stream;
+    reader->owned_stream = NULL;
+    reader->zin = NULL;
+    reader->mapping = NULL;
+    reader->owns_buf = 1;
+    reader->cap = chunk_size;
+    reader->start = 0;
+    reader->end = 0;
+    reader->positions = NULL;
+    reader->positions_cap = 0;
+    reader->scratch = NULL;
+    reader->scratch_cap = 0;
+    reader->scratch_used = 0;
+    reader->flags = flags;
+    reader->eof = 0;
+    reader->skip_line = 0;
+    struct stat st;
+    reader->may_block = fstat(fileno(stream), &st) == 0 && !S_ISREG(st.st_mode);
+
+    // The bytes that tell text from a compressed frame go to the decoder or
+    // stay buffered as the start of the first line
+    size_t head = fread(reader->buf, 1, ML_CODEC_MAGIC_LEN, stream);
+    ml_codec codec = ml_codec_detect(reader->buf, head);
+    if (codec != ML_CODEC_NONE) {
+        reader->zin = ml_zreader_create(stream, codec, reader->buf, head);
+        if (reader->zin == NULL) {
+            int saved_errno = errno;
+            ml_batch_reader_destroy(reader);
+            errno = saved_errno;
+            return NULL;
+        }
+    } else {
+        reader->end = head;
+    }
+    return reader;
+}
+
+ml_batch_reader *ml_batch_reader_create_mem(const char *data, size_t len, unsigned flags) {
+    if (data == NULL && len != 0) {
+        return NULL;
+    }
+    ml_batch_reader *reader = malloc(sizeof(*reader));
+    if (reader == NULL) {
+        return NULL;
+    }
+
+    reader->stream = NULL;
+    reader->owned_stream = NULL;
+    reader->zin = NULL;
+    reader->mapping = NULL;
+    reader->owns_buf = 0;
+    reader->buf = (char *)data;  // never written through: views are const
+    reader->cap = len;
+    reader->start = 0;
+    reader->end = len;
+    reader->positions = NULL;
+    reader->positions_cap = 0;
+    reader->scratch = NULL;
+    reader->scratch_cap = 0;
+    reader->scratch_used = 0;
+    reader->flags = flags;
+    reader->eof = 1;             // everything is already "buffered"
+    reader->skip_line = 0;
+    reader->may_block = 0;
+    return reader;
+}
+
+ml_batch_reader *ml_batch_reader_open(const char *path, unsigned flags) {
+    if (path == NULL) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (strcmp(path, "-") == 0) {
+        return ml_batch_reader_create(stdin, 0, flags);
+    }
+
+    ml_mapped_file *mapping = ml_map_file(path);
+    if (mapping != NULL) {
+        if (ml_codec_detect(ml_mapped_data(mapping), ml_mapped_size(mapping)) == ML_CODEC_NONE) {
+            ml_batch_reader *reader = ml_batch_reader_create_mem(ml_mapped_data(mapping),
+                                                                 ml_mapped_size(mapping), flags);
+            if (reader == NULL) {
+                ml_unmap_file(mapping);
+                return NULL;
+            }
+            reader->mapping = mapping;
+            return reader;
+        }
+        ml_unmap_file(mapping);  // compressed: decoded from a stream below
+    } else if (errno != ENODEV) {
+        return NULL;  // missing file, no permission, ...
+    }
+
+    // Compressed file, pipe, FIFO or device: chunked fallback
+    FILE *stream = fopen(path, "r");
+    if (stream == NULL) {
+        return NULL;
+    }
+    ml_batch_reader *reader = ml_batch_reader_create(stream, 0, flags);
+    if (reader == NULL) {
+        fclose(stream);
+        return NULL;
+    }
+    reader->owned_stream = stream;
+    return reader;
+}
+
+int ml_batch_reader_is_mapped(const ml_batch_reader *reader) {
+    return reader != NULL && reader->mapping != NULL;
+}
+
+int ml_batch_reader_failed(const ml_batch_reader *reader) {
+    return reader != NULL && reader->zin != NULL && ml_zreader_failed(reader->zin);
+}
+
+void ml_batch_reader_destroy(ml_batch_reader *reader) {
+    if (reader != NULL) {
+        ml_mem_release(reader->positions_cap * sizeof(size_t));
+        free(reader->positions);
+        ml_mem_release(reader->scratch_cap);
+        free(reader->scratch);
+        ml_zreader_destroy(reader->zin);
+        if (reader->owns_buf) {
+            ml_mem_release(reader->cap);
+            free(reader->buf);
+        }
+        ml_unmap_file(reader->mapping);
+        if (reader->owned_stream != NULL) {
+            fclose(reader->owned_stream);
+        }
+        free(reader);
+    }
+}
+
+/**
+ * Reads up to `len` bytes of what `stream` has ready (stdio's buffer, then
+ * the descriptor until it would block); while nothing is, runs the idle
+ * hook and waits
+ *
+ * @return Bytes read; 0 at EOF or on a read error
+ */
+static size_t read_ready(FILE *stream, char *dst, size_t len) {
+    int fd = fileno(stream);
+    int fl = fcntl(fd, F_GETFL);
+    for (;;) {
+        if (fl >= 0 && !(fl & O_NONBLOCK)) {
+            fcntl(fd, F_SETFL, fl | O_NONBLOCK);
+        }
+        size_t got = fread(dst, 1, len, stream);
+        int again = ferror(stream) && (errno == EAGAIN || errno == EWOULDBLOCK);
+        if (fl >= 0 && !(fl & O_NONBLOCK)) {
+            fcntl(fd, F_SETFL, fl);  // the descriptor may be shared: restore it right away
+        }
+        if (!again) {
+            return got;
+        }
+        clearerr(stream);
+        if (got > 0) {
+            return got;
+        }
+        ml_input_idle();
+        struct pollfd p = {.fd = fd, .events = POLLIN};
+        while (poll(&p, 1, -1) < 0 && errno == EINTR) {
+        }
+    }
+}
+
+/**
+ * Moves the unconsumed tail to the front of the buffer and reads more data.
+ * Grows the buffer when a single line does not fit into it.
+ *
+ * @return 0 on success, 1 if the buffer is full and may not grow within the
+ *         memory budget, -1 on allocation failure
+ */
+static int refill(ml_batch_reader *reader) {
+    size_t pending = reader->end - reader->start;
+    if (reader->start > 0 && pending > 0) {
+        memmove(reader->buf, reader->buf + reader->start, pending);
+    }
+    reader->start = 0;
+    reader->end = pending;
+
+    if (reader->end == reader->cap) {
+        size_t new_cap = reader->cap * 2;
+        if (ml_mem_try_grow(reader->cap, new_cap) != 0) {
+            return 1;
+        }
+        char *grown = realloc(reader->buf, new_cap);
+        if (grown == NULL) {
+            ml_mem_release(new_cap - reader->cap);
+            return -1;
+        }
+        reader->buf = grown;
+        reader->cap = new_cap;
+    }
+
+    size_t got;
+    if (reader->zin != NULL) {
+        // The decoder thread owns the stream now; only ask the decoder
+        got = ml_zreader_read(reader->zin, reader->buf + reader->end, reader->cap - reader->end);
+        reader->eof = got == 0;
+    } else {
+        got = reader->may_block ? read_ready(reader->stream, reader->buf + reader->end, reader->cap - reader->end)
+                                : fread(reader->buf + reader->end, 1, reader->cap - reader->end, reader->stream);
+        if (got == 0 || feof(reader->stream) || ferror(reader->stream)) {
+            reader->eof = 1;
+        }
+    }
+    reader->end += got;
+    return 0;
+}
+
+/**
+ * Empties the scratch buffer and makes room for `need` bytes of lines
+ * (ML_BATCH_NORMALIZE on a memory reader; a no-op otherwise). Only called
+ * while no view of the scratch buffer is out.
+ *
+ * @return 0 on success, -1 on allocation failure
+ */
+static int reserve_scratch(ml_batch_reader *reader, size_t need) {
+    reader->scratch_used = 0;
+    if (!(reader->flags & ML_BATCH_NORMALIZE) || reader->owns_buf) {
+        return 0;
+    }
+    need = need > ML_BATCH_MIN_CHUNK ? need : ML_BATCH_MIN_CHUNK;
+    if (need <= reader->scratch_cap) {
+        return 0;
+    }
+    char *grown = realloc(reader->scratch, need);
+    if (grown == NULL) {
+        return -1;
+    }
+    ml_mem_charge(need - reader->scratch_cap);
+    reader->scratch = grown;
+    reader->scratch_cap = need;
+    return 0;
+}
+
+/**
+ * Applies the reader flags to one raw line (without its '\n')
+ *
+ * @param valid Whether the line is well-formed UTF-8 (only consulted with
+ *              ML_BATCH_VALID_UTF8)
+ * @return 1 if the line should be reported, 0 if it is skipped
+ */
+static int finish_view(ml_batch_reader *reader, const char *data, size_t len, int valid,
+                       ml_name_view *view) {
+    if ((reader->flags & ML_BATCH_VALID_UTF8) && !valid) {
+        return 0;
+    }
+    if (reader->flags & ML_BATCH_NORMALIZE) {
+        char *line = (char *)data;  // stream readers own `buf`
+        if (!reader->owns_buf) {
+            line = reader->scratch + reader->scratch_used;
+            memcpy(line, data, len);
+        }
+        len = ml_normalize(line, len);
+        reader->scratch_used += reader->owns_buf ? 0 : len;
+        data = line;
+    } else if (reader->flags & ML_BATCH_TRIM) {
+        ml_trim(&data, &len);
+    }
+    if ((reader->flags & ML_BATCH_SKIP_EMPTY) && len == 0) {
+        return 0;
+    }
+    view->data = data;
+    view->len = len;
+    return 1;
+}
+
+size_t ml_batch_reader_next(ml_batch_reader *reader, ml_name_view *views, size_t max_views) {
+    if (reader == NULL || views == NULL || max_views == 0) {
+        return 0;
+    }
+    if (reader->positions_cap < max_views) {
+        size_t *grown = realloc(reader->positions, max_views * sizeof(size_t));
+        if (grown == NULL) {
+            return 0;
+        }
+        ml_mem_charge((max_views - reader->positions_cap) * sizeof(size_t));
+        reader->positions = grown;
+        reader->positions_cap = max_views;
+    }
+
+    size_t count = 0;
+    while (count == 0) {
+        if (reader->skip_line) {
+            size_t rest = reader->end - reader->start;
+            size_t newline = ml_find_newline(reader->buf + reader->start, rest);
+            reader->skip_line = newline == rest;
+            reader->start += newline < rest ? newline + 1 : rest;
+            if (reader->skip_line) {
+                if (reader->eof || refill(reader) < 0) {
+                    break;
+                }
+                continue;
+            }
+        }
+
+        // Split every complete line currently buffered in one kernel call
+        const char *base = reader->buf + reader->start;
+        size_t avail = reader->end - reader->start;
+        size_t found = ml_index_newlines(base, avail, reader->positions, max_views);
+
+        // Validate the whole batch in one pass; only a line containing an
+        // error restarts validation after it. The newlines are ASCII, so a
+        // valid run of lines means every line in it is valid.
+        size_t batch_end = found > 0 ? reader->positions[found - 1] : 0;
+        size_t batch_bytes = found < max_views && reader->eof ? avail : batch_end;  // incl. a last line
+        if (reserve_scratch(reader, batch_bytes) != 0) {
+            break;
+        }
+        size_t valid_end = (reader->flags & ML_BATCH_VALID_UTF8) ? ml_utf8_valid_prefix(base, batch_end)
+                                                                 : batch_end;
+
+        size_t line_start = 0;
+        for (size_t i = 0; i < found; i++) {
+            size_t newline = reader->positions[i];
+            int valid = valid_end >= newline;
+            count += (size_t)finish_view(reader, base + line_start, newline - line_start, valid,
+                                         &views[count]);
+            line_start = newline + 1;
+            if (!valid && line_start < batch_end) {
+                valid_end = line_start + ml_utf8_valid_prefix(base + line_start, batch_end - line_start);
+            }
+        }
+        reader->start += line_start;
+        if (reader->mapping != NULL) {
+            ml_mapped_release_before(reader->mapping, reader->start);
+        }
+
+        if (found == max_views) {
+            continue;  // more lines may be buffered (only loops if all were skipped)
+        }
+        if (reader->eof) {
+            if (reader->start < reader->end) {
+                // last line without a trailing newline
+                const char *last = reader->buf + reader->start;
+                size_t last_len = reader->end - reader->start;
+                int valid = !(reader->flags & ML_BATCH_VALID_UTF8) || ml_utf8_validate(last, last_len);
+                count += (size_t)finish_view(reader, last, last_len, valid, &views[count]);
+                reader->start = reader->end;
+            }
+            break;
+        }
+        if (count == 0) {
+            int rc = refill(reader);
+            if (rc < 0) {
+                break;
+            }
+            if (rc > 0) {
+                // Over budget: the whole buffer is one unfinished line; cut it
+                size_t cut = (unsigned char)reader->buf[reader->end - 1] < 0x80
+                                 ? reader->end
+                                 : ml_utf8_truncate(reader->buf, reader->end, reader->end - 1);
+                int valid = !(reader->flags & ML_BATCH_VALID_UTF8) || ml_utf8_validate(reader->buf, cut);
+                count += (size_t)finish_view(reader, reader->buf, cut, valid, &views[count]);
+                reader->start = reader->end;
+                reader->skip_line = 1;
+            }
+        }
+    }
+    return count;
+}
+
+/**
+ * Delivers every line of `reader` to `callback`, then destroys the reader
+ */
+static size_t drain_reader(ml_batch_reader *reader, ml_name_callback callback, void *ctx) {
+    if (reader == NULL || callback == NULL) {
+        ml_batch_reader_destroy(reader);
+        return 0;
+    }
+
+    ml_name_view views[1024];
+    size_t total = 0;
+    size_t count;
+    while ((count = ml_batch_reader_next(reader, views, 1024)) > 0) {
+        for (size_t i = 0; i < count; i++) {
+            total++;
+            if (callback(views[i].data, views[i].len, ctx) != 0) {
+                ml_batch_reader_destroy(reader);
+                return total;
+            }
+        }
+    }
+
+    ml_batch_reader_destroy(reader);
+    return total;
+}
+
+size_t ask_names_batch_stream(FILE *stream, unsigned flags, ml_name_callback callback, void *ctx) {
+    ml_batch_reader *reader = ml_batch_reader_create(stream, 0, flags);
+    if (reader == NULL) {
+        return (size_t)-1;
+    }
+    return drain_reader(reader, callback, ctx);
+}
+
+size_t ask_names_batch_file(const char *path, unsigned flags, ml_name_callback callback, void *ctx) {
+    ml_batch_reader *reader = ml_batch_reader_open(path, flags);
+    if (reader == NULL) {
+        return (size_t)-1;
+    }
+    return drain_reader(reader, callback, ctx);
+}
+
+size_t ask_names_batch(ml_name_callback callback, void *ctx) {
+    return ask_names_batch_stream(stdin, 0, callback, ctx);
+}
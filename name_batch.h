@@ -0,0 +1,231 @@
+
+#ifndef MULTILANG_NAME_BATCH_H
+#define MULTILANG_NAME_BATCH_H
+
+#include <stddef.h>  // for size_t
+#include <stdio.h>   // for FILE
+#include "mapped_input.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ============================================================================
+// STREAMING (BATCH) NAME INGESTION
+// ============================================================================
+// The ask_name_* functions handle one line per call and print a prompt each
+// time. The batch API instead reads the whole input stream in large chunks
+// and hands out views of each line: no prompts, no per-line flushes and no
+// per-line copies.
+//
+// Views point into the reader's internal buffer. They are NOT null-terminated
+// and stay valid only until the next call into the same reader.
+//
+// ML_BATCH_NORMALIZE rewrites each line right after it is split, while it is
+// still in cache. Stream readers normalize their own buffer in place; memory
+// readers never write to the caller's data and normalize into a scratch
+// buffer instead (one copy per line).
+
+#define ML_BATCH_DEFAULT_CHUNK (1u << 20)  // 1 MiB per read
+
+// Reader flags
+#define ML_BATCH_TRIM       0x1u  // strip leading/trailing whitespace (like Rust's trim())
+#define ML_BATCH_SKIP_EMPTY 0x2u  // do not report empty lines
+#define ML_BATCH_VALID_UTF8 0x4u  // drop lines that are not well-formed UTF-8 (utf8_scan.h)
+#define ML_BATCH_NORMALIZE  0x8u  // trim, collapse whitespace, lowercase ASCII (ml_normalize())
+
+typedef struct ml_name_view {
+    const char *data;
+    size_t len;
+} ml_name_view;
+
+/**
+ * Called once per name. Return 0 to continue, non-zero to stop the batch.
+ */
+typedef int (*ml_name_callback)(const char *name, size_t len, void *ctx);
+
+/**
+ * Called right before a stream reader blocks waiting for input
+ */
+typedef void (*ml_input_idle_fn)(void *ctx);
+
+/**
+ * Sets the calling thread's idle hook (NULL clears it). Batch and async
+ * readers running on this thread call it before they block on a pipe or
+ * terminal that has nothing ready, so output that is waiting for more
+ * input can be flushed there instead of being held back.
+ */
+void ml_input_set_idle_hook(ml_input_idle_fn hook, void *ctx);
+
+/**
+ * Runs the calling thread's idle hook, if one is set
+ */
+void ml_input_idle(void);
+
+typedef struct ml_batch_reader ml_batch_reader;
+
+/**
+ * Creates a reader over `stream` that reads `chunk_size` bytes at a time
+ * (0 selects ML_BATCH_DEFAULT_CHUNK, or less under a --max-mem budget, see
+ * mem_budget.h). Reading goes through stdio, so it is safe to use after
+ * earlier fgets()/std::getline() calls on the same stream.
+ *
+ * On a pipe, FIFO or terminal a refill takes what is ready instead of
+ * waiting for the chunk to fill, and runs the idle hook before it waits.
+ *
+ * The first bytes are read right away: a stream that starts with a zstd or
+ * lz4 frame is decoded on a helper thread (compressed_io.h), which then
+ * owns the stream until the reader is destroyed.
+ *
+ * @return Reader handle, or NULL if allocation failed or the stream is
+ *         compressed with a codec that was not built in (errno = ENOTSUP)
+ */
+ml_batch_reader *ml_batch_reader_create(FILE *stream, size_t chunk_size, unsigned flags);
+
+/**
+ * Creates a reader over `len` bytes at `data`, e.g. a file mapping.
+ * Views point straight into `data` (no copy); it must outlive the reader.
+ *
+ * @return Reader handle, or NULL if allocation failed
+ */
+ml_batch_reader *ml_batch_reader_create_mem(const char *data, size_t len, unsigned flags);
+
+/**
+ * Opens `path` for batch reading: regular files are memory-mapped (see
+ * mapped_input.h) and read without any copy; compressed files, pipes, FIFOs
+ * and devices fall back to chunked reads through stdio. "-" reads stdin.
+ *
+ * The reader owns the mapping or stream and releases it on destroy.
+ *
+ * @return Reader handle, or NULL if the file cannot be opened (errno is set)
+ */
+ml_batch_reader *ml_batch_reader_open(const char *path, unsigned flags);
+
+/**
+ * @return Non-zero if `reader` hands out views straight from a file mapping
+ */
+int ml_batch_reader_is_mapped(const ml_batch_reader *reader);
+
+/**
+ * Fills `views` with up to `max_views` lines.
+ * Lines longer than the chunk size are handled by growing the buffer.
+ *
+ * @return Number of views filled; 0 means end of input (or a read error)
+ */
+size_t ml_batch_reader_next(ml_batch_reader *reader, ml_name_view *views, size_t max_views);
+
+/**
+ * @return Non-zero if the input ended early because it was corrupt or
+ *         truncated compressed data. The names decoded before that point
+ *         were still handed out; callers should report the error and fail.
+ */
+int ml_batch_reader_failed(const ml_batch_reader *reader);
+
+/**
+ * Releases the reader and its buffer. Streams passed to
+ * ml_batch_reader_create() are not closed; anything ml_batch_reader_open()
+ * opened is.
+ */
+void ml_batch_reader_destroy(ml_batch_reader *reader);
+
+/**
+ * Streams every line of stdin to `callback`
+ *
+ * @return Number of names delivered, or (size_t)-1 as for
+ *         ask_names_batch_stream()
+ */
+size_t ask_names_batch(ml_name_callback callback, void *ctx);
+
+/**
+ * Streams every line of `stream` to `callback` using the given reader flags
+ *
+ * @return Number of names delivered, or (size_t)-1 if no reader could be
+ *         created (see ml_batch_reader_create())
+ */
+size_t ask_names_batch_stream(FILE *stream, unsigned flags, ml_name_callback callback, void *ctx);
+
+/**
+ * Streams every line of the file at `path` (mapped when possible, see
+ * ml_batch_reader_open()) to `callback`
+ *
+ * @return Number of names delivered, or (size_t)-1 if the file cannot be opened
+ */
+size_t ask_names_batch_file(const char *path, unsigned flags, ml_name_callback callback, void *ctx);
+
+#ifdef __cplusplus
+}
+
+// C++-only interface: batches of std::string_view exposed as std::span
+#include <span>
+#include <string_view>
+#include <vector>
+namespace InputCpp {
+
+    /**
+     * @brief RAII wrapper around ml_batch_reader
+     *
+     * Example usage (C++ only):
+     *   InputCpp::NameBatchReader reader;
+     *   for (auto batch = reader.next(); !batch.empty(); batch = reader.next()) {
+     *       for (std::string_view name : batch) { ... }
+     *   }
+     */
+    class NameBatchReader {
+    public:
+        static constexpr size_t kViewsPerBatch = 4096;
+
+        explicit NameBatchReader(FILE *stream = stdin,
+                                 size_t chunk_size = ML_BATCH_DEFAULT_CHUNK,
+                                 unsigned flags = 0)
+            : reader_(ml_batch_reader_create(stream, chunk_size, flags)),
+              raw_(kViewsPerBatch) {
+            views_.reserve(kViewsPerBatch);
+        }
+
+        ~NameBatchReader() { ml_batch_reader_destroy(reader_); }
+
+        NameBatchReader(const NameBatchReader &) = delete;
+        NameBatchReader &operator=(const NameBatchReader &) = delete;
+
+        /**
+         * @return The next batch of names; an empty span at end of input.
+         *         The views are valid until the next call to next().
+         */
+        std::span<const std::string_view> next() {
+            views_.clear();
+            if (reader_ == nullptr) {
+                return {};
+            }
+            size_t count = ml_batch_reader_next(reader_, raw_.data(), raw_.size());
+            for (size_t i = 0; i < count; i++) {
+                views_.emplace_back(raw_[i].data, raw_[i].len);
+            }
+            return views_;
+        }
+
+        /**
+         * Calls `f(std::string_view)` for every remaining name
+         *
+         * @return Number of names visited
+         */
+        template <typename F>
+        size_t for_each(F &&f) {
+            size_t total = 0;
+            for (auto batch = next(); !batch.empty(); batch = next()) {
+                for (std::string_view name : batch) {
+                    f(name);
+                }
+                total += batch.size();
+            }
+            return total;
+        }
+
+    private:
+        ml_batch_reader *reader_;
+        std::vector<ml_name_view> raw_;
+        std::vector<std::string_view> views_;
+    };
+}
+#endif
+
+#endif // MULTILANG_NAME_BATCH_H
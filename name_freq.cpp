@@ -0,0 +1,530 @@
+// Name frequency counter: per-shard exact tables or bounded sketches, merged at the end
+#include "name_freq.h"
+#include "name_intern.h"
+#include "mapped_input.h"
+#include "compressed_io.h"
+#include "sharded_input.h"
+#include "mem_budget.h"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <new>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+struct ml_freq_report {
+    uint64_t total = 0;
+    uint64_t distinct = 0;
+    bool estimate = false;
+    std::vector<std::string> names;
+    std::vector<ml_freq_entry> entries;
+};
+
+namespace NameFreq {
+    namespace {
+
+        constexpr size_t kViews = 1024;
+
+        // 64-bit FNV-1a with a murmur3 finalizer: the sketches need every bit
+        // of the hash to be usable, which plain FNV's high bits are not
+        uint64_t hash_name(const char *name, size_t len) {
+            uint64_t h = 0xcbf29ce484222325ull;
+            for (size_t i = 0; i < len; i++) {
+                h ^= static_cast<unsigned char>(name[i]);
+                h *= 0x100000001b3ull;
+            }
+            h ^= h >> 33;
+            h *= 0xff51afd7ed558ccdull;
+            h ^= h >> 33;
+            h *= 0xc4ceb9fe1a85ec53ull;
+            h ^= h >> 33;
+            return h;
+        }
+
+        // Highest count first, then byte order of the name
+        bool ranks_before(uint64_t a_count, std::string_view a, uint64_t b_count, std::string_view b) {
+            return a_count != b_count ? a_count > b_count : a < b;
+        }
+
+        // ====================================================================
+        // EXACT: interning table + one count per id
+        // ====================================================================
+
+        // The table and the counts are charged to the --max-mem budget
+        // (mem_budget.h); past it, add() throws std::bad_alloc
+        class ExactCounter {
+        public:
+            ExactCounter() : table_(name_intern_create(0)) {
+                if (table_ == nullptr) {
+                    throw std::bad_alloc();
+                }
+            }
+            ~ExactCounter() {
+                name_intern_destroy(table_);
+                ml_mem_release(charged_);
+            }
+
+            ExactCounter(const ExactCounter &) = delete;
+            ExactCounter &operator=(const ExactCounter &) = delete;
+
+            void add(const char *name, size_t len, uint64_t times = 1) {
+                uint32_t id = NAME_INTERN_INVALID_ID;
+                if (name_intern_add(table_, name, len, &id) == nullptr) {
+                    throw std::bad_alloc();
+                }
+                if (id >= counts_.capacity()) {
+                    grow_counts(std::max<size_t>(counts_.capacity() * 2, id + 1));
+                }
+                if (id >= counts_.size()) {
+                    counts_.resize(id + 1, 0);
+                }
+                counts_[id] += times;
+                total_ += times;
+            }
+
+            void merge(const ExactCounter &other) {
+                for (uint32_t id = 0; id < other.counts_.size(); id++) {
+                    size_t len = 0;
+                    const char *name = name_intern_get(other.table_, id, &len);
+                    add(name, len, other.counts_[id]);
+                }
+            }
+
+            uint64_t total() const { return total_; }
+            uint64_t distinct() const { return name_intern_count(table_); }
+
+            template <typename Emit>
+            void top(size_t k, Emit emit) const {
+                std::vector<uint32_t> ids(counts_.size());
+                for (uint32_t id = 0; id < ids.size(); id++) {
+                    ids[id] = id;
+                }
+                k = std::min(k, ids.size());
+                std::partial_sort(ids.begin(), ids.begin() + k, ids.end(), [this](uint32_t a, uint32_t b) {
+                    return ranks_before(counts_[a], name(a), counts_[b], name(b));
+                });
+                for (size_t i = 0; i < k; i++) {
+                    emit(name(ids[i]), counts_[ids[i]]);
+                }
+            }
+
+        private:
+            void grow_counts(size_t cap) {
+                size_t grown = (cap - counts_.capacity()) * sizeof(uint64_t);
+                if (ml_mem_try_charge(grown) != 0) {
+                    throw std::bad_alloc();
+                }
+                try {
+                    counts_.reserve(cap);
+                } catch (const std::bad_alloc &) {
+                    ml_mem_release(grown);
+                    throw;
+                }
+                charged_ += grown;
+            }
+
+            std::string_view name(uint32_t id) const {
+                size_t len = 0;
+                const char *text = name_intern_get(table_, id, &len);
+                return std::string_view(text, len);
+            }
+
+            name_intern *table_;
+            std::vector<uint64_t> counts_;  // indexed by interning id
+            size_t charged_ = 0;            // bytes of counts_ charged to the budget
+            uint64_t total_ = 0;
+        };
+
+        // ====================================================================
+        // SKETCH: HyperLogLog + count-min + heavy-hitter candidates
+        // ====================================================================
+
+        constexpr unsigned kHllBits = 14;                 // 16 Ki registers: ~0.8% standard error
+        constexpr size_t kHllRegisters = size_t{1} << kHllBits;
+        constexpr size_t kCmsDepth = 4;
+        constexpr size_t kCmsWidth = size_t{1} << 15;     // 4 x 32 Ki x 8 bytes = 1 MiB
+        constexpr size_t kMinCandidates = 256;
+        constexpr size_t kCandidatesPerRank = 8;          // candidates kept per reported name
+        constexpr size_t kCandidateBytes = 128;           // map node, bucket, heap entry and a short name
+
+        // Its size does not depend on the input, so the sketch is charged to
+        // the --max-mem budget (mem_budget.h) in full but never refused
+        class SketchCounter {
+        public:
+            explicit SketchCounter(size_t top)
+                : registers_(kHllRegisters, 0), cms_(kCmsDepth * kCmsWidth, 0),
+                  capacity_(std::max(kMinCandidates, top * kCandidatesPerRank)) {
+                candidates_.reserve(capacity_);
+                heap_.reserve(capacity_);
+                charge(registers_.size() * sizeof(uint8_t) + cms_.size() * sizeof(uint64_t) +
+                       capacity_ * kCandidateBytes);
+            }
+            ~SketchCounter() { ml_mem_release(charged_); }
+
+            SketchCounter(const SketchCounter &) = delete;
+            SketchCounter &operator=(const SketchCounter &) = delete;
+
+            void add(const char *name, size_t len) {
+                uint64_t h = hash_name(name, len);
+                total_++;
+
+                // HyperLogLog: the first kHllBits pick a register, which
+                // keeps the longest run of leading zeros seen in the rest
+                size_t reg = h >> (64 - kHllBits);
+                uint64_t rest = (h << kHllBits) | (uint64_t{1} << (kHllBits - 1));
+                uint8_t rank = static_cast<uint8_t>(__builtin_clzll(rest) + 1);
+                registers_[reg] = std::max(registers_[reg], rank);
+
+                // Count-min with conservative update: only the counters
+                // that are at the minimum grow, which cuts the overestimate
+                uint64_t est = estimate(h) + 1;
+                for (size_t row = 0; row < kCmsDepth; row++) {
+                    uint64_t &cell = cms_[cell_index(h, row)];
+                    cell = std::max(cell, est);
+                }
+
+                // A candidate's estimate only grows, so a name whose
+                // estimate does not beat the weakest candidate is not one
+                if (heap_.size() == capacity_ && est <= heap_[0].est) {
+                    return;
+                }
+                auto found = candidates_.find(std::string(name, len));
+                if (found != candidates_.end()) {
+                    heap_[found->second].est = est;
+                    sift_down(found->second);
+                } else if (heap_.size() < capacity_) {
+                    auto node = candidates_.emplace(std::string(name, len), heap_.size()).first;
+                    heap_.push_back(Candidate{est, &*node});
+                    sift_up(heap_.size() - 1);
+                } else {
+                    candidates_.erase(candidates_.find(heap_[0].node->first));  // evict the weakest
+                    auto node = candidates_.emplace(std::string(name, len), 0).first;
+                    heap_[0] = Candidate{est, &*node};
+                    sift_down(0);
+                }
+            }
+
+            void merge(const SketchCounter &other) {
+                total_ += other.total_;
+                for (size_t i = 0; i < kHllRegisters; i++) {
+                    registers_[i] = std::max(registers_[i], other.registers_[i]);
+                }
+                for (size_t i = 0; i < cms_.size(); i++) {
+                    cms_[i] += other.cms_[i];
+                }
+                for (const auto &candidate : other.candidates_) {
+                    if (merged_names_.insert(candidate.first).second) {
+                        charge(kCandidateBytes);
+                    }
+                }
+            }
+
+            uint64_t total() const { return total_; }
+
+            uint64_t distinct() const {
+                double m = static_cast<double>(kHllRegisters);
+                double sum = 0.0;
+                size_t zeros = 0;
+                for (uint8_t r : registers_) {
+                    sum += std::ldexp(1.0, -static_cast<int>(r));
+                    zeros += r == 0;
+                }
+                double alpha = 0.7213 / (1.0 + 1.079 / m);
+                double e = alpha * m * m / sum;
+                if (e <= 2.5 * m && zeros != 0) {
+                    e = m * std::log(m / static_cast<double>(zeros));  // linear counting for small sets
+                }
+                return static_cast<uint64_t>(e + 0.5);
+            }
+
+            // Re-ranks every candidate of every merged shard by the merged sketch
+            template <typename Emit>
+            void top(size_t k, Emit emit) const {
+                std::vector<std::pair<uint64_t, std::string_view>> ranked;
+                auto consider = [&](const std::string &name) {
+                    ranked.emplace_back(estimate(hash_name(name.data(), name.size())), name);
+                };
+                for (const auto &candidate : candidates_) {
+                    consider(candidate.first);
+                }
+                for (const std::string &name : merged_names_) {
+                    if (candidates_.find(name) == candidates_.end()) {
+                        consider(name);
+                    }
+                }
+                k = std::min(k, ranked.size());
+                std::partial_sort(ranked.begin(), ranked.begin() + k, ranked.end(), [](const auto &a, const auto &b) {
+                    return ranks_before(a.first, a.second, b.first, b.second);
+                });
+                for (size_t i = 0; i < k; i++) {
+                    emit(ranked[i].second, ranked[i].first);
+                }
+            }
+
+        private:
+            using Node = std::pair<const std::string, size_t>;  // name -> position in heap_
+
+            struct Candidate {
+                uint64_t est;
+                Node *node;  // map nodes never move, even on rehash
+            };
+
+            void charge(size_t bytes) {
+                ml_mem_charge(bytes);
+                charged_ += bytes;
+            }
+
+            static size_t cell_index(uint64_t h, size_t row) {
+                // Kirsch-Mitzenmacher: row hashes derived from two halves
+                uint64_t h1 = h & 0xffffffffu;
+                uint64_t h2 = (h >> 32) | 1u;
+                return row * kCmsWidth + ((h1 + row * h2) & (kCmsWidth - 1));
+            }
+
+            uint64_t estimate(uint64_t h) const {
+                uint64_t est = UINT64_MAX;
+                for (size_t row = 0; row < kCmsDepth; row++) {
+                    est = std::min(est, cms_[cell_index(h, row)]);
+                }
+                return est;
+            }
+
+            void place(size_t pos, Candidate c) {
+                heap_[pos] = c;
+                c.node->second = pos;
+            }
+
+            void sift_up(size_t pos) {
+                Candidate c = heap_[pos];
+                while (pos > 0 && c.est < heap_[(pos - 1) / 2].est) {
+                    place(pos, heap_[(pos - 1) / 2]);
+                    pos = (pos - 1) / 2;
+                }
+                place(pos, c);
+            }
+
+            void sift_down(size_t pos) {
+                Candidate c = heap_[pos];
+                for (;;) {
+                    size_t child = pos * 2 + 1;
+                    if (child >= heap_.size()) {
+                        break;
+                    }
+                    if (child + 1 < heap_.size() && heap_[child + 1].est < heap_[child].est) {
+                        child++;
+                    }
+                    if (heap_[child].est >= c.est) {
+                        break;
+                    }
+                    place(pos, heap_[child]);
+                    pos = child;
+                }
+                place(pos, c);
+            }
+
+            std::vector<uint8_t> registers_;
+            std::vector<uint64_t> cms_;
+            size_t capacity_;
+            std::unordered_map<std::string, size_t> candidates_;
+            std::vector<Candidate> heap_;                    // min-heap on est
+            std::unordered_set<std::string> merged_names_;   // candidates of merged shards
+            size_t charged_ = 0;                             // bytes charged to the budget
+            uint64_t total_ = 0;
+        };
+
+        // ====================================================================
+        // DRIVER
+        // ====================================================================
+
+        // Returns false if the input ended early (corrupt compressed data)
+        template <typename Counter>
+        bool count_reader(ml_batch_reader *reader, Counter &counter) {
+            std::vector<ml_name_view> views(kViews);
+            size_t count;
+            while ((count = ml_batch_reader_next(reader, views.data(), views.size())) > 0) {
+                for (size_t i = 0; i < count; i++) {
+                    counter.add(views[i].data, views[i].len);
+                }
+            }
+            return !ml_batch_reader_failed(reader);
+        }
+
+        ml_freq_options resolve(const ml_freq_options *opts) {
+            ml_freq_options config;
+            ml_freq_default_options(&config);
+            if (opts != nullptr) {
+                config = *opts;
+            }
+            if (config.top == 0) {
+                config.top = ML_FREQ_DEFAULT_TOP;
+            }
+            return config;
+        }
+
+        template <typename Counter>
+        ml_freq_report *make_report(const Counter &counter, const ml_freq_options &config) {
+            auto report = std::make_unique<ml_freq_report>();
+            report->total = counter.total();
+            report->distinct = counter.distinct();
+            report->estimate = config.mode == ML_FREQ_SKETCH;
+            counter.top(config.top, [&](std::string_view name, uint64_t count) {
+                report->names.emplace_back(name);
+                report->entries.push_back(ml_freq_entry{nullptr, name.size(), count});
+            });
+            for (size_t i = 0; i < report->entries.size(); i++) {
+                report->entries[i].name = report->names[i].c_str();  // `names` is complete now
+            }
+            return report.release();
+        }
+
+        template <typename Counter, typename... Args>
+        ml_freq_report *count_shards(const char *data, size_t len, const ml_freq_options &config, Args... args) {
+            unsigned threads = config.threads != 0 ? config.threads : std::thread::hardware_concurrency();
+            threads = std::max(threads, 1u);
+            std::vector<size_t> bounds(threads + 1);
+            ml_shard_bounds(data, len, threads, bounds.data());
+
+            std::vector<std::unique_ptr<Counter>> counters;
+            for (unsigned i = 0; i < threads; i++) {
+                counters.push_back(std::make_unique<Counter>(args...));
+            }
+            std::vector<std::exception_ptr> errors(threads);
+            std::vector<std::thread> shard_threads;
+            auto join_all = [&] {
+                for (std::thread &t : shard_threads) {
+                    t.join();
+                }
+            };
+            try {
+                for (unsigned i = 0; i < threads; i++) {
+                    shard_threads.emplace_back([&, i] {
+                        ml_batch_reader *reader = bounds[i + 1] > bounds[i]
+                            ? ml_batch_reader_create_mem(data + bounds[i], bounds[i + 1] - bounds[i], config.reader_flags)
+                            : nullptr;
+                        try {
+                            if (reader != nullptr) {
+                                count_reader(reader, *counters[i]);
+                            }
+                        } catch (...) {
+                            errors[i] = std::current_exception();
+                        }
+                        ml_batch_reader_destroy(reader);
+                    });
+                }
+            } catch (const std::system_error &) {
+                join_all();  // the shards already started still use `counters`
+                throw;
+            }
+            join_all();
+            for (const std::exception_ptr &error : errors) {
+                if (error) {
+                    std::rethrow_exception(error);
+                }
+            }
+
+            for (unsigned i = 1; i < threads; i++) {
+                counters[0]->merge(*counters[i]);
+                counters[i].reset();  // release each shard as soon as it is merged
+            }
+            return make_report(*counters[0], config);
+        }
+    }
+}
+
+extern "C" void ml_freq_default_options(ml_freq_options *opts) {
+    opts->mode = ML_FREQ_EXACT;
+    opts->threads = 0;
+    opts->top = ML_FREQ_DEFAULT_TOP;
+    opts->reader_flags = 0;
+}
+
+extern "C" ml_freq_report *ml_freq_count_mem(const char *data, size_t len, const ml_freq_options *opts) {
+    using namespace NameFreq;
+    ml_freq_options config = resolve(opts);
+    try {
+        if (config.mode == ML_FREQ_SKETCH) {
+            return count_shards<SketchCounter>(data, len, config, config.top);
+        }
+        return count_shards<ExactCounter>(data, len, config);
+    } catch (const std::bad_alloc &) {
+        errno = ENOMEM;
+        return nullptr;
+    } catch (const std::system_error &e) {
+        errno = e.code().value();  // a shard thread could not be started
+        return nullptr;
+    }
+}
+
+extern "C" ml_freq_report *ml_freq_count_file(const char *path, const ml_freq_options *opts) {
+    ml_mapped_file *file = ml_map_file(path);
+    if (file == nullptr) {
+        return nullptr;
+    }
+    if (ml_codec_detect(ml_mapped_data(file), ml_mapped_size(file)) != ML_CODEC_NONE) {
+        // A compressed file cannot be split into shards: count it from one decoding reader
+        ml_unmap_file(file);
+        ml_batch_reader *reader = ml_batch_reader_open(path, NameFreq::resolve(opts).reader_flags);
+        if (reader == nullptr) {
+            return nullptr;
+        }
+        ml_freq_report *report = ml_freq_count_reader(reader, opts);
+        ml_batch_reader_destroy(reader);
+        return report;
+    }
+    ml_freq_report *report = ml_freq_count_mem(ml_mapped_data(file), ml_mapped_size(file), opts);
+    ml_unmap_file(file);  // the report owns copies of its names
+    return report;
+}
+
+extern "C" ml_freq_report *ml_freq_count_reader(ml_batch_reader *reader, const ml_freq_options *opts) {
+    using namespace NameFreq;
+    ml_freq_options config = resolve(opts);
+    try {
+        if (config.mode == ML_FREQ_SKETCH) {
+            SketchCounter counter(config.top);
+            if (!count_reader(reader, counter)) {
+                errno = EBADMSG;
+                return nullptr;
+            }
+            return make_report(counter, config);
+        }
+        ExactCounter counter;
+        if (!count_reader(reader, counter)) {
+            errno = EBADMSG;
+            return nullptr;
+        }
+        return make_report(counter, config);
+    } catch (const std::bad_alloc &) {
+        errno = ENOMEM;
+        return nullptr;
+    }
+}
+
+extern "C" uint64_t ml_freq_total(const ml_freq_report *report) {
+    return report->total;
+}
+
+extern "C" uint64_t ml_freq_distinct(const ml_freq_report *report) {
+    return report->distinct;
+}
+
+extern "C" size_t ml_freq_top(const ml_freq_report *report, const ml_freq_entry **entries) {
+    *entries = report->entries.data();
+    return report->entries.size();
+}
+
+extern "C" int ml_freq_is_estimate(const ml_freq_report *report) {
+    return report->estimate ? 1 : 0;
+}
+
+extern "C" void ml_freq_destroy(ml_freq_report *report) {
+    delete report;
+}
@@ -0,0 +1,109 @@
+#ifndef MULTILANG_NAME_FREQ_H
+#define MULTILANG_NAME_FREQ_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "name_batch.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ============================================================================
+// NAME FREQUENCY COUNTER (top-K and distinct count)
+// ============================================================================
+// Counts how often each name occurs in one pass over the batch API, in
+// process, instead of `sort | uniq -c | sort -rn | head`.
+//
+// Files are counted with one thread per newline-aligned shard
+// (ml_shard_bounds() in sharded_input.h); each thread owns its counter, so
+// nothing is shared until the per-shard results are merged at the end.
+//
+//   ML_FREQ_EXACT   per-shard interning table (name_intern.h) with a count
+//                   per id; memory grows with the distinct names
+//   ML_FREQ_SKETCH  bounded memory (about 1 MiB per thread, whatever the
+//                   input): HyperLogLog for the distinct count (~0.8% error),
+//                   a count-min sketch for frequencies and a fixed set of
+//                   heavy-hitter candidates for the top K. Counts of the
+//                   reported names may overestimate, never underestimate.
+
+#define ML_FREQ_DEFAULT_TOP 10
+
+typedef enum {
+    ML_FREQ_EXACT = 0,
+    ML_FREQ_SKETCH = 1,
+} ml_freq_mode;
+
+typedef struct {
+    ml_freq_mode mode;
+    unsigned threads;       // shards for files; 0 = one per hardware thread
+    size_t top;             // names to report; 0 = ML_FREQ_DEFAULT_TOP
+    unsigned reader_flags;  // ML_BATCH_* flags (name_batch.h)
+} ml_freq_options;
+
+typedef struct ml_freq_entry {
+    const char *name;  // NUL-terminated, owned by the report
+    size_t len;
+    uint64_t count;
+} ml_freq_entry;
+
+typedef struct ml_freq_report ml_freq_report;
+
+/**
+ * Puts the defaults (exact, one thread per core, top 10) into `opts`
+ */
+void ml_freq_default_options(ml_freq_options *opts);
+
+/**
+ * Counts the lines of data[0, len) on `opts->threads` threads
+ *
+ * @return Report, or NULL if allocation failed (errno = ENOMEM, also past
+ *         the --max-mem budget) or a thread could not be started
+ */
+ml_freq_report *ml_freq_count_mem(const char *data, size_t len, const ml_freq_options *opts);
+
+/**
+ * Maps `path` and counts it like ml_freq_count_mem(). A compressed file
+ * (compressed_io.h) is counted from one decoding reader instead.
+ *
+ * @return Report, or NULL if the file cannot be read (errno is set)
+ */
+ml_freq_report *ml_freq_count_file(const char *path, const ml_freq_options *opts);
+
+/**
+ * Counts every name of `reader` on the calling thread (for streams)
+ *
+ * @return Report, or NULL if allocation failed (errno = ENOMEM) or the
+ *         input was corrupt or truncated compressed data (errno = EBADMSG)
+ */
+ml_freq_report *ml_freq_count_reader(ml_batch_reader *reader, const ml_freq_options *opts);
+
+/**
+ * @return Number of names counted
+ */
+uint64_t ml_freq_total(const ml_freq_report *report);
+
+/**
+ * @return Number of distinct names (an estimate in ML_FREQ_SKETCH mode)
+ */
+uint64_t ml_freq_distinct(const ml_freq_report *report);
+
+/**
+ * @param entries Set to the most frequent names, highest count first (ties
+ *                in byte order of the name)
+ * @return Number of entries (<= the requested top K)
+ */
+size_t ml_freq_top(const ml_freq_report *report, const ml_freq_entry **entries);
+
+/**
+ * @return Non-zero if the counts are ML_FREQ_SKETCH estimates
+ */
+int ml_freq_is_estimate(const ml_freq_report *report);
+
+void ml_freq_destroy(ml_freq_report *report);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //MULTILANG_NAME_FREQ_H
@@ -0,0 +1,497 @@
+#define _DEFAULT_SOURCE  // MADV_* names
+#include "name_index.h"
+#include "mapped_input.h"
+#include "mem_budget.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+// Binary name index: writer (in-memory staging, one sequential write) and
+// mmap-backed reader. Section layout is documented in name_index.h.
+//
+// The writer's staging buffers and the sections built on save are charged
+// to the --max-mem budget (mem_budget.h); past it they fail with ENOMEM.
+
+#define INDEX_MAGIC "MLNIDX01"
+#define INDEX_VERSION 1u
+#define MIN_SLOTS 64u
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t flags;
+    uint64_t count;
+    uint64_t offsets_off;
+    uint64_t blob_off;
+    uint64_t blob_size;
+    uint64_t sorted_off;  // 0 without ML_INDEX_SORTED
+    uint64_t hash_off;    // 0 without ML_INDEX_HASHED
+    uint64_t hash_slots;
+} index_header;
+
+typedef struct {
+    uint32_t hash;
+    uint32_t id_plus_one;  // 0 = empty
+} index_slot;
+
+_Static_assert(sizeof(index_header) % 8 == 0, "sections after the header must stay 8-byte aligned");
+
+// FNV-1a, folded to 32 bits like name_intern.cpp; part of the file format
+static uint32_t hash_name(const char *name, size_t len) {
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)name[i];
+        h *= 0x100000001b3ull;
+    }
+    return (uint32_t)(h ^ (h >> 32));
+}
+
+static uint64_t align8(uint64_t n) {
+    return (n + 7u) & ~(uint64_t)7u;
+}
+
+// Three-way byte order of two names (a shorter prefix sorts first)
+static int compare_names(const char *a, size_t a_len, const char *b, size_t b_len) {
+    int cmp = memcmp(a, b, a_len < b_len ? a_len : b_len);
+    if (cmp != 0) {
+        return cmp;
+    }
+    return (a_len > b_len) - (a_len < b_len);
+}
+
+// ============================================================================
+// WRITER
+// ============================================================================
+
+struct ml_index_writer {
+    unsigned flags;
+    char *blob;
+    size_t blob_size;
+    size_t blob_cap;
+    uint64_t *offsets;  // count + 1 entries once count > 0
+    size_t count;
+    size_t offsets_cap;
+};
+
+/**
+ * Grows a staging buffer from `old_size` to `new_size` bytes, charging the
+ * difference
+ *
+ * @return The grown buffer, or NULL (errno = ENOMEM; `buffer` is unchanged)
+ */
+static void *grow_charged(void *buffer, size_t old_size, size_t new_size) {
+    if (ml_mem_try_charge(new_size - old_size) != 0) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    void *grown = realloc(buffer, new_size);
+    if (grown == NULL) {
+        ml_mem_release(new_size - old_size);
+        errno = ENOMEM;
+    }
+    return grown;
+}
+
+ml_index_writer *ml_index_writer_create(unsigned flags) {
+    ml_index_writer *writer = calloc(1, sizeof(*writer));
+    if (writer == NULL) {
+        return NULL;
+    }
+    writer->flags = flags & (ML_INDEX_SORTED | ML_INDEX_HASHED);
+    writer->offsets = grow_charged(NULL, 0, 1024 * sizeof(uint64_t));
+    if (writer->offsets == NULL) {
+        free(writer);
+        return NULL;
+    }
+    writer->offsets_cap = 1024;
+    writer->offsets[0] = 0;
+    return writer;
+}
+
+int ml_index_writer_add(ml_index_writer *writer, const char *name, size_t len) {
+    if (writer->count >= UINT32_MAX - 1) {
+        return -1;  // ids and hash slots are 32-bit
+    }
+    if (writer->blob_size + len + 1 > writer->blob_cap) {
+        size_t cap = writer->blob_cap != 0 ? writer->blob_cap : 64 * 1024;
+        while (cap < writer->blob_size + len + 1) {
+            cap *= 2;
+        }
+        char *grown = grow_charged(writer->blob, writer->blob_cap, cap);
+        if (grown == NULL) {
+            return -1;
+        }
+        writer->blob = grown;
+        writer->blob_cap = cap;
+    }
+    if (writer->count + 2 > writer->offsets_cap) {
+        uint64_t *grown = grow_charged(writer->offsets, writer->offsets_cap * sizeof(uint64_t),
+                                       writer->offsets_cap * 2 * sizeof(uint64_t));
+        if (grown == NULL) {
+            return -1;
+        }
+        writer->offsets = grown;
+        writer->offsets_cap *= 2;
+    }
+
+    memcpy(writer->blob + writer->blob_size, name, len);
+    writer->blob[writer->blob_size + len] = '\0';
+    writer->blob_size += len + 1;
+    writer->count++;
+    writer->offsets[writer->count] = writer->blob_size;
+    return 0;
+}
+
+size_t ml_index_writer_count(const ml_index_writer *writer) {
+    return writer->count;
+}
+
+typedef struct {
+    const char *data;
+    uint32_t len;
+    uint32_t id;
+} sort_entry;
+
+static int compare_entries(const void *a, const void *b) {
+    const sort_entry *x = a;
+    const sort_entry *y = b;
+    int cmp = compare_names(x->data, x->len, y->data, y->len);
+    if (cmp != 0) {
+        return cmp;
+    }
+    return (x->id > y->id) - (x->id < y->id);  // stable: the first occurrence sorts first
+}
+
+// Both builders charge their result until ml_index_writer_save() frees it
+static size_t sorted_bytes(const ml_index_writer *writer) {
+    return (writer->count != 0 ? writer->count : 1) * sizeof(uint32_t);
+}
+
+static uint32_t *build_sorted(const ml_index_writer *writer) {
+    size_t entries_bytes = (writer->count != 0 ? writer->count : 1) * sizeof(sort_entry);
+    if (ml_mem_try_charge(entries_bytes + sorted_bytes(writer)) != 0) {
+        return NULL;
+    }
+    sort_entry *entries = malloc(entries_bytes);
+    uint32_t *ids = malloc(sorted_bytes(writer));
+    if (entries == NULL || ids == NULL) {
+        free(entries);
+        free(ids);
+        ml_mem_release(entries_bytes + sorted_bytes(writer));
+        return NULL;
+    }
+    for (size_t i = 0; i < writer->count; i++) {
+        entries[i].data = writer->blob + writer->offsets[i];
+        entries[i].len = (uint32_t)(writer->offsets[i + 1] - writer->offsets[i] - 1);
+        entries[i].id = (uint32_t)i;
+    }
+    qsort(entries, writer->count, sizeof(*entries), compare_entries);
+    for (size_t i = 0; i < writer->count; i++) {
+        ids[i] = entries[i].id;
+    }
+    free(entries);
+    ml_mem_release(entries_bytes);
+    return ids;
+}
+
+static index_slot *build_hash(const ml_index_writer *writer, size_t *slot_count) {
+    // Load factor at or below 1/2, as in name_intern.cpp
+    size_t slots = MIN_SLOTS;
+    while (slots < writer->count * 2) {
+        slots *= 2;
+    }
+    if (ml_mem_try_charge(slots * sizeof(index_slot)) != 0) {
+        return NULL;
+    }
+    index_slot *table = calloc(slots, sizeof(*table));
+    if (table == NULL) {
+        ml_mem_release(slots * sizeof(index_slot));
+        return NULL;
+    }
+    size_t mask = slots - 1;
+    for (size_t id = 0; id < writer->count; id++) {
+        const char *name = writer->blob + writer->offsets[id];
+        size_t len = writer->offsets[id + 1] - writer->offsets[id] - 1;
+        uint32_t hash = hash_name(name, len);
+        size_t i = hash & mask;
+        int duplicate = 0;
+        while (table[i].id_plus_one != 0) {
+            if (table[i].hash == hash) {
+                uint32_t other = table[i].id_plus_one - 1;
+                size_t other_len = writer->offsets[other + 1] - writer->offsets[other] - 1;
+                if (other_len == len && memcmp(writer->blob + writer->offsets[other], name, len) == 0) {
+                    duplicate = 1;  // keep the first id
+                    break;
+                }
+            }
+            i = (i + 1) & mask;
+        }
+        if (!duplicate) {
+            table[i].hash = hash;
+            table[i].id_plus_one = (uint32_t)id + 1;
+        }
+    }
+    *slot_count = slots;
+    return table;
+}
+
+static void free_sections(const ml_index_writer *writer, uint32_t *sorted, index_slot *hash, size_t hash_slots) {
+    if (sorted != NULL) {
+        free(sorted);
+        ml_mem_release(sorted_bytes(writer));
+    }
+    if (hash != NULL) {
+        free(hash);
+        ml_mem_release(hash_slots * sizeof(index_slot));
+    }
+}
+
+static int write_padded(FILE *out, const void *data, size_t len) {
+    static const char zeros[8] = {0};
+    if (len != 0 && fwrite(data, 1, len, out) != len) {
+        return -1;
+    }
+    size_t pad = (size_t)(align8(len) - len);
+    return pad != 0 && fwrite(zeros, 1, pad, out) != pad ? -1 : 0;
+}
+
+int ml_index_writer_save(ml_index_writer *writer, const char *path) {
+    uint32_t *sorted = NULL;
+    index_slot *hash = NULL;
+    size_t hash_slots = 0;
+    if ((writer->flags & ML_INDEX_SORTED) && (sorted = build_sorted(writer)) == NULL) {
+        errno = ENOMEM;
+        return -1;
+    }
+    if ((writer->flags & ML_INDEX_HASHED) && (hash = build_hash(writer, &hash_slots)) == NULL) {
+        free_sections(writer, sorted, NULL, 0);
+        errno = ENOMEM;
+        return -1;
+    }
+
+    index_header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, INDEX_MAGIC, sizeof(header.magic));
+    header.version = INDEX_VERSION;
+    header.flags = writer->flags;
+    header.count = writer->count;
+    header.offsets_off = sizeof(header);
+    header.blob_off = header.offsets_off + (writer->count + 1) * sizeof(uint64_t);
+    header.blob_size = writer->blob_size;
+    uint64_t next = align8(header.blob_off + header.blob_size);
+    if (sorted != NULL) {
+        header.sorted_off = next;
+        next = align8(next + writer->count * sizeof(uint32_t));
+    }
+    if (hash != NULL) {
+        header.hash_off = next;
+        header.hash_slots = hash_slots;
+    }
+
+    size_t tmp_len = strlen(path) + sizeof(".tmp");
+    char *tmp = malloc(tmp_len);
+    if (tmp == NULL) {
+        free_sections(writer, sorted, hash, hash_slots);
+        errno = ENOMEM;
+        return -1;
+    }
+    snprintf(tmp, tmp_len, "%s.tmp", path);
+
+    int rc = -1;
+    FILE *out = fopen(tmp, "wb");
+    if (out != NULL) {
+        rc = write_padded(out, &header, sizeof(header));
+        if (rc == 0) {
+            rc = write_padded(out, writer->offsets, (writer->count + 1) * sizeof(uint64_t));
+        }
+        if (rc == 0) {
+            rc = write_padded(out, writer->blob, writer->blob_size);
+        }
+        if (rc == 0 && sorted != NULL) {
+            rc = write_padded(out, sorted, writer->count * sizeof(uint32_t));
+        }
+        if (rc == 0 && hash != NULL) {
+            rc = write_padded(out, hash, hash_slots * sizeof(index_slot));
+        }
+        if (fclose(out) != 0) {
+            rc = -1;
+        }
+        if (rc == 0 && rename(tmp, path) != 0) {
+            rc = -1;
+        }
+        if (rc != 0) {
+            int saved = errno;
+            remove(tmp);
+            errno = saved;
+        }
+    }
+
+    free(tmp);
+    free_sections(writer, sorted, hash, hash_slots);
+    return rc;
+}
+
+void ml_index_writer_destroy(ml_index_writer *writer) {
+    if (writer != NULL) {
+        ml_mem_release(writer->blob_cap + writer->offsets_cap * sizeof(uint64_t));
+        free(writer->blob);
+        free(writer->offsets);
+        free(writer);
+    }
+}
+
+// ============================================================================
+// READER
+// ============================================================================
+
+struct ml_name_index {
+    ml_mapped_file *file;
+    const index_header *header;
+    const uint64_t *offsets;
+    const char *blob;
+    const uint32_t *sorted;    // NULL without ML_INDEX_SORTED
+    const index_slot *hash;    // NULL without ML_INDEX_HASHED
+    size_t hash_mask;
+};
+
+// Non-zero if [off, off + len) lies inside a file of `size` bytes
+static int in_bounds(uint64_t off, uint64_t len, uint64_t size) {
+    return off <= size && len <= size - off;
+}
+
+ml_name_index *ml_index_open(const char *path) {
+    ml_mapped_file *file = ml_map_file(path);
+    if (file == NULL) {
+        return NULL;
+    }
+    const char *data = ml_mapped_data(file);
+    uint64_t size = ml_mapped_size(file);
+
+    const index_header *h = (const index_header *)data;
+    int valid = size >= sizeof(*h)
+        && memcmp(h->magic, INDEX_MAGIC, sizeof(h->magic)) == 0
+        && h->version == INDEX_VERSION
+        && h->count < UINT32_MAX
+        && h->offsets_off % 8 == 0 && h->sorted_off % 8 == 0 && h->hash_off % 8 == 0
+        && in_bounds(h->offsets_off, (h->count + 1) * sizeof(uint64_t), size)
+        && in_bounds(h->blob_off, h->blob_size, size)
+        && (h->sorted_off == 0 || in_bounds(h->sorted_off, h->count * sizeof(uint32_t), size))
+        && (h->hash_off == 0 || (h->hash_slots != 0 && (h->hash_slots & (h->hash_slots - 1)) == 0
+                                 && h->hash_slots < UINT64_MAX / sizeof(index_slot)
+                                 && in_bounds(h->hash_off, h->hash_slots * sizeof(index_slot), size)));
+    ml_name_index *index = valid ? malloc(sizeof(*index)) : NULL;
+    if (index == NULL) {
+        ml_unmap_file(file);
+        errno = valid ? ENOMEM : EINVAL;
+        return NULL;
+    }
+
+    // ml_map_file() advises sequential access; lookups jump around
+#ifdef MADV_RANDOM
+    madvise((void *)data, (size_t)size, MADV_RANDOM);
+#endif
+    index->file = file;
+    index->header = h;
+    index->offsets = (const uint64_t *)(data + h->offsets_off);
+    index->blob = data + h->blob_off;
+    index->sorted = h->sorted_off != 0 ? (const uint32_t *)(data + h->sorted_off) : NULL;
+    index->hash = h->hash_off != 0 ? (const index_slot *)(data + h->hash_off) : NULL;
+    index->hash_mask = h->hash_off != 0 ? (size_t)h->hash_slots - 1 : 0;
+    return index;
+}
+
+void ml_index_close(ml_name_index *index) {
+    if (index != NULL) {
+        ml_unmap_file(index->file);
+        free(index);
+    }
+}
+
+size_t ml_index_count(const ml_name_index *index) {
+    return (size_t)index->header->count;
+}
+
+unsigned ml_index_flags(const ml_name_index *index) {
+    return (index->sorted != NULL ? ML_INDEX_SORTED : 0) | (index->hash != NULL ? ML_INDEX_HASHED : 0);
+}
+
+const char *ml_index_name(const ml_name_index *index, size_t id, size_t *len) {
+    if (id >= index->header->count) {
+        return NULL;
+    }
+    // Checked per access instead of at open, which keeps open O(1)
+    uint64_t start = index->offsets[id];
+    uint64_t end = index->offsets[id + 1];
+    if (start >= end || end > index->header->blob_size || index->blob[end - 1] != '\0') {
+        return NULL;
+    }
+    if (len != NULL) {
+        *len = (size_t)(end - start - 1);
+    }
+    return index->blob + start;
+}
+
+// Non-zero if entry `id` is exactly name[0, len)
+static int name_equals(const ml_name_index *index, size_t id, const char *name, size_t len) {
+    size_t entry_len;
+    const char *entry = ml_index_name(index, id, &entry_len);
+    return entry != NULL && entry_len == len && memcmp(entry, name, len) == 0;
+}
+
+size_t ml_index_lower_bound(const ml_name_index *index, const char *name, size_t len) {
+    if (index->sorted == NULL) {
+        return ML_INDEX_NOT_FOUND;
+    }
+    size_t lo = 0;
+    size_t hi = (size_t)index->header->count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        size_t entry_len = 0;
+        const char *entry = ml_index_name(index, index->sorted[mid], &entry_len);
+        if (entry != NULL && compare_names(entry, entry_len, name, len) < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+size_t ml_index_sorted_id(const ml_name_index *index, size_t rank) {
+    if (index->sorted == NULL || rank >= index->header->count) {
+        return ML_INDEX_NOT_FOUND;
+    }
+    return index->sorted[rank];
+}
+
+size_t ml_index_find(const ml_name_index *index, const char *name, size_t len) {
+    size_t count = (size_t)index->header->count;
+    if (index->hash != NULL) {
+        uint32_t hash = hash_name(name, len);
+        size_t i = hash & index->hash_mask;
+        // Every probe ends at an empty slot (load <= 1/2); the bound guards corrupt files
+        for (size_t probes = 0; probes <= index->hash_mask && index->hash[i].id_plus_one != 0; probes++) {
+            size_t id = index->hash[i].id_plus_one - 1;
+            if (index->hash[i].hash == hash && id < count && name_equals(index, id, name, len)) {
+                return id;
+            }
+            i = (i + 1) & index->hash_mask;
+        }
+        return ML_INDEX_NOT_FOUND;
+    }
+    if (index->sorted != NULL) {
+        size_t rank = ml_index_lower_bound(index, name, len);
+        if (rank < count && index->sorted[rank] < count && name_equals(index, index->sorted[rank], name, len)) {
+            return index->sorted[rank];
+        }
+        return ML_INDEX_NOT_FOUND;
+    }
+    for (size_t id = 0; id < count; id++) {
+        if (name_equals(index, id, name, len)) {
+            return id;
+        }
+    }
+    return ML_INDEX_NOT_FOUND;
+}
@@ -0,0 +1,130 @@
+#ifndef MULTILANG_NAME_INDEX_H
+#define MULTILANG_NAME_INDEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ============================================================================
+// BINARY NAME INDEX FILES
+// ============================================================================
+// A persisted, mmap-able list of names: downstream jobs open it and look
+// names up straight out of the page cache, with nothing to parse first.
+//
+// File layout (native byte order; every section 8-byte aligned):
+//
+//   header    magic "MLNIDX01", version, flags, name count, section offsets
+//   offsets   uint64_t[count + 1]: name i is blob[offsets[i], offsets[i + 1] - 1)
+//   blob      the names back to back, each followed by a NUL
+//   sorted    uint32_t[count]: ids in byte order (ties in input order)   ML_INDEX_SORTED
+//   hash      (hash, id + 1) uint32_t pairs, power-of-two open-addressing
+//             table over FNV-1a hashes, 0 marking an empty slot          ML_INDEX_HASHED
+//
+// Ids are positions in input order; a name added twice keeps both ids and
+// lookups return the first. ml_index_open() checks the header and section
+// bounds only, so opening costs the same for ten names as for ten million.
+
+#define ML_INDEX_SORTED 0x1u  // write the sorted section: prefix and range queries, O(log n) lookup
+#define ML_INDEX_HASHED 0x2u  // write the hash section: O(1) lookup
+
+#define ML_INDEX_NOT_FOUND SIZE_MAX
+
+typedef struct ml_index_writer ml_index_writer;
+typedef struct ml_name_index ml_name_index;
+
+// ---------------------------------------------------------------- writer
+
+/**
+ * Creates an empty index in memory
+ *
+ * @param flags ML_INDEX_* sections to write in addition to offsets and blob
+ * @return Writer handle, or NULL if allocation failed
+ */
+ml_index_writer *ml_index_writer_create(unsigned flags);
+
+/**
+ * Appends name[0, len) (it must not contain a NUL byte); its id is the
+ * number of names added before it
+ *
+ * @return 0 on success, -1 on allocation failure (errno = ENOMEM, also once
+ *         the --max-mem budget is used up) or a full index
+ */
+int ml_index_writer_add(ml_index_writer *writer, const char *name, size_t len);
+
+/**
+ * @return Number of names added so far
+ */
+size_t ml_index_writer_count(const ml_index_writer *writer);
+
+/**
+ * Builds the index sections and writes the file; it is written under a
+ * temporary name and renamed, so readers never see a partial index
+ *
+ * @return 0 on success, -1 on error (errno is set)
+ */
+int ml_index_writer_save(ml_index_writer *writer, const char *path);
+
+void ml_index_writer_destroy(ml_index_writer *writer);
+
+// ---------------------------------------------------------------- reader
+
+/**
+ * Maps an index file read-only
+ *
+ * @return Index handle, or NULL if the file cannot be mapped or is not a
+ *         valid index (errno is set)
+ */
+ml_name_index *ml_index_open(const char *path);
+
+/**
+ * Unmaps the index; every name pointer into it becomes invalid
+ */
+void ml_index_close(ml_name_index *index);
+
+/**
+ * @return Number of names in the index
+ */
+size_t ml_index_count(const ml_name_index *index);
+
+/**
+ * @return ML_INDEX_* sections present in the file
+ */
+unsigned ml_index_flags(const ml_name_index *index);
+
+/**
+ * @param len Set to the name's length (may be NULL)
+ * @return Name `id` (NUL-terminated, inside the mapping), or NULL if `id` is
+ *         out of range or the file is corrupt
+ */
+const char *ml_index_name(const ml_name_index *index, size_t id, size_t *len);
+
+/**
+ * Looks up name[0, len): O(1) with the hash section, O(log n) with the
+ * sorted one, a linear scan without either
+ *
+ * @return Id of the first occurrence, or ML_INDEX_NOT_FOUND
+ */
+size_t ml_index_find(const ml_name_index *index, const char *name, size_t len);
+
+/**
+ * Position in byte order of the first name >= name[0, len) (requires
+ * ML_INDEX_SORTED); walk on with ml_index_sorted_id() for prefix or range
+ * queries
+ *
+ * @return Rank in [0, count], or ML_INDEX_NOT_FOUND without a sorted section
+ */
+size_t ml_index_lower_bound(const ml_name_index *index, const char *name, size_t len);
+
+/**
+ * @return Id of the name at `rank` in byte order, or ML_INDEX_NOT_FOUND
+ */
+size_t ml_index_sorted_id(const ml_name_index *index, size_t rank);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //MULTILANG_NAME_INDEX_H
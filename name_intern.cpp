@@ -0,0 +1,248 @@
+// Name interning table (C ABI, implemented in C++)
+//
+// `slots` is a power-of-two open-addressing table of (hash, id + 1) pairs,
+// 0 marking an empty slot; `entries` maps an id to its string in the arena.
+// Keeping the full 32-bit hash in the slot means a probe only compares
+// strings on a real hash match, and growing never rehashes a string.
+//
+// The arena charges the strings to the --max-mem budget (mem_budget.h) and
+// the table charges both vectors, so a table refuses to grow past the budget.
+
+#include "name_intern.h"
+#include "name_arena.h"
+#include "mem_budget.h"
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <vector>
+
+namespace {
+    struct Slot {
+        uint32_t hash;
+        uint32_t id_plus_one;  // 0 = empty
+    };
+
+    struct Entry {
+        const char *text;
+        uint32_t len;
+    };
+
+    constexpr size_t kMinSlots = 64;
+
+    // FNV-1a: names are short, so a byte loop beats a block hash's setup
+    uint32_t hash_name(const char *name, size_t len) {
+        uint64_t h = 0xcbf29ce484222325ull;
+        for (size_t i = 0; i < len; i++) {
+            h ^= static_cast<unsigned char>(name[i]);
+            h *= 0x100000001b3ull;
+        }
+        return static_cast<uint32_t>(h ^ (h >> 32));
+    }
+
+    size_t slots_for(size_t names) {
+        // Keep the load factor at or below 1/2
+        size_t slots = kMinSlots;
+        while (slots < names * 2) {
+            slots *= 2;
+        }
+        return slots;
+    }
+}
+
+struct name_intern {
+    name_arena *arena = nullptr;
+    std::vector<Slot> slots;
+    std::vector<Entry> entries;
+    size_t charged = 0;  // capacity of both vectors, in bytes
+
+    /**
+     * Returns the slot holding name[0, len), or the empty slot where it belongs
+     */
+    size_t probe(const char *name, size_t len, uint32_t hash) const {
+        size_t mask = slots.size() - 1;
+        size_t i = hash & mask;
+        while (slots[i].id_plus_one != 0) {
+            if (slots[i].hash == hash) {
+                const Entry &e = entries[slots[i].id_plus_one - 1];
+                if (e.len == len && std::memcmp(e.text, name, len) == 0) {
+                    return i;
+                }
+            }
+            i = (i + 1) & mask;
+        }
+        return i;
+    }
+
+    /**
+     * Makes room for one more entry, charging the growth
+     *
+     * @return false if the budget or the heap is exhausted
+     */
+    bool reserve_entry() {
+        if (entries.size() < entries.capacity()) {
+            return true;
+        }
+        size_t cap = std::max<size_t>(entries.capacity() * 2, kMinSlots / 2);
+        size_t grown = (cap - entries.capacity()) * sizeof(Entry);
+        if (ml_mem_try_charge(grown) != 0) {
+            return false;
+        }
+        try {
+            entries.reserve(cap);
+        } catch (const std::bad_alloc &) {
+            ml_mem_release(grown);
+            return false;
+        }
+        charged += grown;
+        return true;
+    }
+
+    /**
+     * Doubles the slot table; both tables exist while the slots are moved,
+     * so the new one is charged in full before the old one is released
+     *
+     * @return false if the budget or the heap is exhausted
+     */
+    bool grow() {
+        size_t bytes = slots.size() * 2 * sizeof(Slot);
+        if (ml_mem_try_charge(bytes) != 0) {
+            return false;
+        }
+        std::vector<Slot> bigger;
+        try {
+            bigger.assign(slots.size() * 2, Slot{0, 0});
+        } catch (const std::bad_alloc &) {
+            ml_mem_release(bytes);
+            return false;
+        }
+        size_t mask = bigger.size() - 1;
+        for (const Slot &s : slots) {
+            if (s.id_plus_one != 0) {
+                size_t i = s.hash & mask;
+                while (bigger[i].id_plus_one != 0) {
+                    i = (i + 1) & mask;
+                }
+                bigger[i] = s;
+            }
+        }
+        slots.swap(bigger);
+        ml_mem_release(bigger.size() * sizeof(Slot));
+        charged += bytes - bigger.size() * sizeof(Slot);
+        return true;
+    }
+};
+
+extern "C" name_intern *name_intern_create(size_t expected) {
+    name_intern *table = new (std::nothrow) name_intern;
+    if (table == nullptr) {
+        return nullptr;
+    }
+    size_t slots = slots_for(expected);
+    size_t bytes = slots * sizeof(Slot) + expected * sizeof(Entry);
+    if (ml_mem_try_grow(0, bytes) != 0) {
+        delete table;
+        return nullptr;
+    }
+    table->charged = bytes;
+    try {
+        table->slots.assign(slots, Slot{0, 0});
+        table->entries.reserve(expected);
+    } catch (const std::bad_alloc &) {
+        name_intern_destroy(table);
+        return nullptr;
+    }
+    table->arena = name_arena_create(0);
+    if (table->arena == nullptr) {
+        name_intern_destroy(table);
+        return nullptr;
+    }
+    return table;
+}
+
+extern "C" const char *name_intern_add(name_intern *table, const char *name, size_t len, uint32_t *id) {
+    if (table == nullptr || (name == nullptr && len != 0) || len >= UINT32_MAX) {
+        return nullptr;
+    }
+    if (name == nullptr) {
+        name = "";
+    }
+
+    uint32_t hash = hash_name(name, len);
+    size_t slot = table->probe(name, len, hash);
+    if (table->slots[slot].id_plus_one != 0) {
+        uint32_t found = table->slots[slot].id_plus_one - 1;
+        if (id != nullptr) {
+            *id = found;
+        }
+        return table->entries[found].text;
+    }
+
+    // New name: copy it once into the arena
+    if (table->entries.size() >= NAME_INTERN_INVALID_ID - 1) {
+        return nullptr;
+    }
+    // Grow first, so a failure leaves the table unchanged
+    if ((table->entries.size() + 1) * 2 > table->slots.size()) {
+        if (!table->grow()) {
+            return nullptr;
+        }
+        slot = table->probe(name, len, hash);
+    }
+    if (!table->reserve_entry()) {
+        return nullptr;
+    }
+    char *copy = name_arena_strndup(table->arena, name, len);
+    if (copy == nullptr) {
+        return nullptr;
+    }
+    uint32_t new_id = static_cast<uint32_t>(table->entries.size());
+    table->entries.push_back(Entry{copy, static_cast<uint32_t>(len)});  // capacity is reserved
+    table->slots[slot] = Slot{hash, new_id + 1};
+
+    if (id != nullptr) {
+        *id = new_id;
+    }
+    return copy;
+}
+
+extern "C" uint32_t name_intern_find(const name_intern *table, const char *name, size_t len) {
+    if (table == nullptr || (name == nullptr && len != 0)) {
+        return NAME_INTERN_INVALID_ID;
+    }
+    size_t slot = table->probe(name, len, hash_name(name, len));
+    uint32_t id_plus_one = table->slots[slot].id_plus_one;
+    return id_plus_one != 0 ? id_plus_one - 1 : NAME_INTERN_INVALID_ID;
+}
+
+extern "C" const char *name_intern_get(const name_intern *table, uint32_t id, size_t *len) {
+    if (table == nullptr || id >= table->entries.size()) {
+        return nullptr;
+    }
+    const Entry &e = table->entries[id];
+    if (len != nullptr) {
+        *len = e.len;
+    }
+    return e.text;
+}
+
+extern "C" size_t name_intern_count(const name_intern *table) {
+    return table != nullptr ? table->entries.size() : 0;
+}
+
+extern "C" size_t name_intern_memory(const name_intern *table) {
+    if (table == nullptr) {
+        return 0;
+    }
+    return name_arena_bytes_reserved(table->arena) +
+           table->slots.capacity() * sizeof(Slot) +
+           table->entries.capacity() * sizeof(Entry);
+}
+
+extern "C" void name_intern_destroy(name_intern *table) {
+    if (table == nullptr) {
+        return;
+    }
+    name_arena_destroy(table->arena);
+    ml_mem_release(table->charged);
+    delete table;
+}
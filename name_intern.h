@@ -0,0 +1,121 @@
+#ifndef MULTILANG_NAME_INTERN_H
+#define MULTILANG_NAME_INTERN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ============================================================================
+// NAME INTERNING TABLE
+// ============================================================================
+// Input streams repeat the same names over and over. An interning table keeps
+// exactly one copy of each distinct name (packed into a name arena) and hands
+// back the same stable pointer and the same 32-bit id every time that name is
+// seen again, so retained names cost one copy per *distinct* name and two
+// interned names are equal exactly when their pointers (or ids) are.
+//
+// Lookup is an open-addressing hash table with linear probing over
+// (hash, id) slots; the strings themselves are only touched on a hash match.
+// A table is not thread-safe: use one per thread or lock around it.
+
+#define NAME_INTERN_INVALID_ID UINT32_MAX
+
+typedef struct name_intern name_intern;
+
+/**
+ * Creates an empty table sized for about `expected` distinct names
+ * (0 selects a small default; the table grows as needed)
+ *
+ * @return Table handle, or NULL if allocation failed
+ */
+name_intern *name_intern_create(size_t expected);
+
+/**
+ * Returns the canonical copy of name[0, len), adding it if it is new
+ *
+ * @param id Receives the name's id (0, 1, 2, ... in first-seen order); may be NULL
+ * @return Null-terminated pointer, stable until name_intern_destroy(), or NULL on failure
+ */
+const char *name_intern_add(name_intern *table, const char *name, size_t len, uint32_t *id);
+
+/**
+ * Looks a name up without adding it
+ *
+ * @return Its id, or NAME_INTERN_INVALID_ID if it was never interned
+ */
+uint32_t name_intern_find(const name_intern *table, const char *name, size_t len);
+
+/**
+ * Returns the name with the given id
+ *
+ * @param len Receives the name's length; may be NULL
+ * @return Null-terminated pointer, or NULL for an unknown id
+ */
+const char *name_intern_get(const name_intern *table, uint32_t id, size_t *len);
+
+/**
+ * @return Number of distinct names in the table
+ */
+size_t name_intern_count(const name_intern *table);
+
+/**
+ * @return Bytes held by the table: string storage plus the hash and id arrays
+ */
+size_t name_intern_memory(const name_intern *table);
+
+/**
+ * Releases the table and every name it returned
+ */
+void name_intern_destroy(name_intern *table);
+
+#ifdef __cplusplus
+}
+
+// C++-only interface: RAII owner of a table
+#include <string_view>
+namespace InputCppMem {
+    class NameInterner {
+    public:
+        explicit NameInterner(size_t expected = 0) : table_(name_intern_create(expected)) {}
+        ~NameInterner() { name_intern_destroy(table_); }
+
+        NameInterner(const NameInterner &) = delete;
+        NameInterner &operator=(const NameInterner &) = delete;
+
+        /**
+         * @brief Canonical view of `name`; views of equal names have equal data()
+         */
+        std::string_view intern(std::string_view name) {
+            const char *canonical = name_intern_add(table_, name.data(), name.size(), nullptr);
+            return canonical != nullptr ? std::string_view(canonical, name.size()) : std::string_view();
+        }
+
+        /**
+         * @brief Id of `name`, adding it if it is new
+         */
+        uint32_t id(std::string_view name) {
+            uint32_t result = NAME_INTERN_INVALID_ID;
+            name_intern_add(table_, name.data(), name.size(), &result);
+            return result;
+        }
+
+        std::string_view name(uint32_t id) const {
+            size_t len = 0;
+            const char *text = name_intern_get(table_, id, &len);
+            return text != nullptr ? std::string_view(text, len) : std::string_view();
+        }
+
+        size_t size() const { return name_intern_count(table_); }
+        size_t memory() const { return name_intern_memory(table_); }
+        name_intern *get() const { return table_; }
+
+    private:
+        name_intern *table_;
+    };
+}
+#endif
+
+#endif //MULTILANG_NAME_INTERN_H
@@ -0,0 +1,322 @@
+#include "output_sink.h"
+#include "mem_budget.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <time.h>
+#include <unistd.h>
+
+// Buffered output sink
+//
+// Buffered mode copies small writes into one large buffer. When a write does
+// not fit, the buffer and the new parts leave together in a single writev(),
+// so a flush is always exactly one syscall (barring partial writes).
+//
+// With a codec set, the same iovecs go to a compressing writer instead
+// (compressed_io.h), whose helper thread makes the syscalls.
+//
+// A failed write is sticky: the descriptor is assumed broken, what could not
+// be sent is discarded, and every later write or flush fails with the same
+// errno so the caller finds out even if it only checks the final flush.
+
+#define MAX_PARTS 16
+#define ML_SINK_MIN_CAPACITY 4096u  // smallest default buffer a --max-mem budget shrinks to
+
+struct ml_sink {
+    int fd;
+    FILE *stream;          // stdio stream for ML_SINK_STDIO (stdout sink only)
+    ml_sink_mode mode;
+    char *buf;
+    size_t cap;
+    size_t used;
+    uint64_t max_delay_ns;
+    uint64_t oldest_ns;    // when the first unflushed byte was buffered
+    int error;             // errno of the first failed write, or 0
+    ml_zwriter *zwriter;   // compressor of buffered output, or NULL
+};
+
+static ml_sink stdout_sink = {
+    .fd = STDOUT_FILENO,
+    .stream = NULL,        // set on first use (stdout is not a constant expression)
+    .mode = ML_SINK_STDIO,
+    .buf = NULL,
+    .cap = 0,
+    .used = 0,
+    .max_delay_ns = (uint64_t)ML_SINK_DEFAULT_MAX_DELAY_MS * 1000000u,
+    .oldest_ns = 0,
+    .error = 0,
+    .zwriter = NULL,
+};
+
+static pthread_once_t stdout_sink_once = PTHREAD_ONCE_INIT;
+
+// The deadline is checked on every buffered write: the coarse clock is read
+// from the vDSO in a few ns, and its millisecond resolution is plenty for it
+#ifdef CLOCK_MONOTONIC_COARSE
+#define SINK_CLOCK CLOCK_MONOTONIC_COARSE
+#else
+#define SINK_CLOCK CLOCK_MONOTONIC
+#endif
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(SINK_CLOCK, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static void flush_stdout_sink_at_exit(void) {
+    ml_sink_flush(&stdout_sink);
+    ml_sink_set_codec(&stdout_sink, ML_CODEC_NONE);  // ends a compressed frame
+}
+
+static void init_stdout_sink(void) {
+    stdout_sink.stream = stdout;
+    atexit(flush_stdout_sink_at_exit);
+}
+
+ml_sink *ml_stdout_sink(void) {
+    pthread_once(&stdout_sink_once, init_stdout_sink);
+    return &stdout_sink;
+}
+
+/**
+ * Halves the default buffer until it takes at most a quarter of what is left
+ * of a --max-mem budget
+ */
+static size_t budget_capacity(size_t cap) {
+    while (cap > ML_SINK_MIN_CAPACITY && cap > ml_mem_available() / 4) {
+        cap /= 2;
+    }
+    return cap;
+}
+
+ml_sink *ml_sink_create(int fd, size_t capacity) {
+    ml_sink *sink = calloc(1, sizeof(*sink));
+    if (sink == NULL) {
+        return NULL;
+    }
+    sink->fd = fd;
+    sink->stream = NULL;
+    sink->cap = capacity != 0 ? capacity : budget_capacity(ML_SINK_DEFAULT_CAPACITY);
+    sink->buf = malloc(sink->cap);
+    if (sink->buf == NULL) {
+        free(sink);
+        return NULL;
+    }
+    ml_mem_charge(sink->cap);
+    sink->mode = ML_SINK_BUFFERED;
+    sink->max_delay_ns = (uint64_t)ML_SINK_DEFAULT_MAX_DELAY_MS * 1000000u;
+    return sink;
+}
+
+void ml_sink_destroy(ml_sink *sink) {
+    if (sink == NULL || sink == &stdout_sink) {
+        return;
+    }
+    ml_sink_flush(sink);
+    ml_sink_set_codec(sink, ML_CODEC_NONE);
+    ml_mem_release(sink->cap);
+    free(sink->buf);
+    free(sink);
+}
+
+int ml_sink_set_mode(ml_sink *sink, ml_sink_mode mode) {
+    if (sink == NULL) {
+        return -1;
+    }
+    if (mode == sink->mode) {
+        return 0;
+    }
+
+    if (mode == ML_SINK_BUFFERED) {
+        if (sink->buf == NULL) {
+            sink->cap = budget_capacity(ML_SINK_DEFAULT_CAPACITY);
+            sink->buf = malloc(sink->cap);
+            if (sink->buf == NULL) {
+                sink->cap = 0;
+                return -1;
+            }
+            ml_mem_charge(sink->cap);  // kept until exit, like the stdout sink itself
+        }
+        if (sink->stream != NULL) {
+            fflush(sink->stream);  // keep everything printed so far in front
+        }
+    } else {
+        if (sink->stream == NULL) {
+            return -1;  // only the stdout sink has a stdio stream
+        }
+        ml_sink_flush(sink);
+    }
+    sink->mode = mode;
+    return 0;
+}
+
+void ml_sink_set_max_delay(ml_sink *sink, unsigned max_delay_ms) {
+    if (sink != NULL) {
+        sink->max_delay_ns = (uint64_t)max_delay_ms * 1000000u;
+    }
+}
+
+/**
+ * Writes all iovecs, retrying on partial writes and EINTR
+ */
+static int write_all(int fd, struct iovec *iov, int count) {
+    while (count > 0) {
+        ssize_t n = writev(fd, iov, count);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        size_t left = (size_t)n;
+        while (count > 0 && left >= iov->iov_len) {
+            left -= iov->iov_len;
+            iov++;
+            count--;
+        }
+        if (count > 0) {
+            iov->iov_base = (char *)iov->iov_base + left;
+            iov->iov_len -= left;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Sends the buffer followed by `parts` with one writev(), or hands them to
+ * the compressor (`sync` also flushes it)
+ *
+ * @return 0 on success, -1 on a write error (recorded in sink->error)
+ */
+static int flush_with_parts(ml_sink *sink, const ml_sink_part *parts, size_t count, int sync) {
+    if (sink->error != 0) {
+        sink->used = 0;  // nothing more can reach a broken descriptor
+        errno = sink->error;
+        return -1;
+    }
+    struct iovec iov[MAX_PARTS + 1];
+    int n = 0;
+    if (sink->used > 0) {
+        iov[n].iov_base = sink->buf;
+        iov[n].iov_len = sink->used;
+        n++;
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (parts[i].len > 0) {
+            iov[n].iov_base = (void *)parts[i].data;
+            iov[n].iov_len = parts[i].len;
+            n++;
+        }
+    }
+    sink->used = 0;
+    int rc;
+    if (sink->zwriter != NULL) {
+        rc = ml_zwriter_write(sink->zwriter, iov, n, sync);
+        if (rc != 0) {
+            errno = EIO;  // the failing syscall was made on the compressor's thread
+        }
+    } else {
+        rc = write_all(sink->fd, iov, n);
+    }
+    if (rc != 0) {
+        sink->error = errno;
+    }
+    return rc;
+}
+
+static int write_parts_stdio(ml_sink *sink, const ml_sink_part *parts, size_t count) {
+    int rc = 0;
+    flockfile(sink->stream);
+    for (size_t i = 0; i < count; i++) {
+        if (parts[i].len > 0 && fwrite(parts[i].data, 1, parts[i].len, sink->stream) != parts[i].len) {
+            rc = -1;
+        }
+    }
+    funlockfile(sink->stream);
+    return rc;
+}
+
+int ml_sink_write_parts(ml_sink *sink, const ml_sink_part *parts, size_t count) {
+    if (sink == NULL || count > MAX_PARTS) {
+        return -1;
+    }
+    if (sink->mode == ML_SINK_STDIO) {
+        return write_parts_stdio(sink, parts, count);
+    }
+
+    size_t total = 0;
+    for (size_t i = 0; i < count; i++) {
+        total += parts[i].len;
+    }
+
+    if (sink->error != 0 || sink->cap - sink->used < total) {
+        return flush_with_parts(sink, parts, count, 0);
+    }
+
+    uint64_t now = sink->max_delay_ns != 0 ? now_ns() : 0;
+    if (sink->used == 0) {
+        sink->oldest_ns = now;
+    }
+    for (size_t i = 0; i < count; i++) {
+        memcpy(sink->buf + sink->used, parts[i].data, parts[i].len);
+        sink->used += parts[i].len;
+    }
+
+    // Time threshold, so a slow trickle of names still reaches the reader
+    if (sink->max_delay_ns != 0 && now - sink->oldest_ns >= sink->max_delay_ns) {
+        return flush_with_parts(sink, NULL, 0, 1);
+    }
+    return 0;
+}
+
+int ml_sink_write(ml_sink *sink, const void *data, size_t len) {
+    ml_sink_part part = {data, len};
+    return ml_sink_write_parts(sink, &part, 1);
+}
+
+int ml_sink_greet(ml_sink *sink, const char *prefix, const char *name, size_t len, const char *suffix) {
+    ml_sink_part parts[3] = {
+        {prefix, strlen(prefix)},
+        {name, len},
+        {suffix, strlen(suffix)},
+    };
+    return ml_sink_write_parts(sink, parts, 3);
+}
+
+int ml_sink_flush(ml_sink *sink) {
+    if (sink == NULL) {
+        return -1;
+    }
+    if (sink->mode == ML_SINK_STDIO) {
+        return fflush(sink->stream) == 0 ? 0 : -1;
+    }
+    if (sink->used == 0 && sink->error == 0) {
+        return 0;
+    }
+    return flush_with_parts(sink, NULL, 0, 1);
+}
+
+int ml_sink_set_codec(ml_sink *sink, ml_codec codec) {
+    if (sink == NULL) {
+        return -1;
+    }
+    int rc = ml_sink_flush(sink);  // what is buffered belongs to the current stream
+    if (sink->zwriter != NULL) {
+        if (ml_zwriter_finish(sink->zwriter) != 0) {
+            rc = -1;
+        }
+        sink->zwriter = NULL;
+    }
+    if (codec != ML_CODEC_NONE) {
+        sink->zwriter = ml_zwriter_create(sink->fd, codec);
+        if (sink->zwriter == NULL) {
+            return -1;
+        }
+    }
+    return rc;
+}
@@ -0,0 +1,137 @@
+#ifndef MULTILANG_OUTPUT_SINK_H
+#define MULTILANG_OUTPUT_SINK_H
+
+#include <stddef.h>
+#include "compressed_io.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ============================================================================
+// SHARED GREETING OUTPUT SINK (C ABI, used by C, C++ and Rust)
+// ============================================================================
+// Every implementation writes its greeting through a sink instead of its own
+// printf()/std::endl/println!, so all languages share one buffer and one
+// flush policy.
+//
+// A sink works in one of two modes:
+//
+//   ML_SINK_STDIO     Writes go into the C stdio stream (stdout for the
+//                     process-wide sink), so greetings stay in order with
+//                     printf() output and prompts. No extra syscalls, no
+//                     per-line flush (stdio decides, e.g. line-buffered TTY).
+//
+//   ML_SINK_BUFFERED  The sink owns the descriptor: greetings accumulate in
+//                     a large buffer and go out with writev() once it fills,
+//                     once `max_delay_ms` has passed since the oldest
+//                     unflushed byte (checked on every write), or at exit.
+//                     Used by the streaming modes, where nothing else
+//                     writes to stdout; they also flush whenever their
+//                     reader is about to wait for input (the idle hook in
+//                     name_batch.h), which the time threshold cannot see.
+//
+// Buffered output can also be compressed (zstd or lz4, see compressed_io.h
+// and ml_sink_set_codec()): each flush then hands the data to a helper
+// thread that compresses and writes it while the next buffer fills.
+//
+// In buffered mode a write error is sticky: the unsent data is dropped and
+// every later write and flush fails with the same errno, so checking the
+// final ml_sink_flush() is enough to notice it.
+//
+// A sink is not thread-safe: use one writer thread per sink.
+
+#define ML_SINK_DEFAULT_CAPACITY (256u * 1024u)
+#define ML_SINK_DEFAULT_MAX_DELAY_MS 100u
+
+typedef enum {
+    ML_SINK_STDIO = 0,
+    ML_SINK_BUFFERED = 1,
+} ml_sink_mode;
+
+typedef struct ml_sink ml_sink;
+
+// One piece of a multi-part write
+typedef struct ml_sink_part {
+    const void *data;
+    size_t len;
+} ml_sink_part;
+
+/**
+ * @return The process-wide stdout sink (starts in ML_SINK_STDIO mode and is
+ *         flushed automatically at exit)
+ */
+ml_sink *ml_stdout_sink(void);
+
+/**
+ * Creates a buffered sink that owns `fd` for writing (the fd is not closed)
+ *
+ * @param capacity Buffer size in bytes (0 selects ML_SINK_DEFAULT_CAPACITY, or
+ *                 less under a --max-mem budget, see mem_budget.h)
+ * @return Sink handle, or NULL if allocation failed
+ */
+ml_sink *ml_sink_create(int fd, size_t capacity);
+
+/**
+ * Flushes and releases a sink created with ml_sink_create()
+ */
+void ml_sink_destroy(ml_sink *sink);
+
+/**
+ * Switches modes. Switching the stdout sink to ML_SINK_BUFFERED first
+ * flushes stdio, so nothing already printed is reordered.
+ *
+ * @return 0 on success, -1 if the buffer could not be allocated
+ */
+int ml_sink_set_mode(ml_sink *sink, ml_sink_mode mode);
+
+/**
+ * Compresses everything the sink sends from now on with `codec`. Only
+ * buffered mode output is compressed; what is already buffered is sent
+ * first, as it was. ML_CODEC_NONE ends the compressed frame and goes back to
+ * plain writes; the stdout sink does that at exit, ml_sink_destroy() too.
+ *
+ * @return 0 on success, -1 if the codec is not built in (errno = ENOTSUP),
+ *         allocation failed or the previous frame could not be written
+ */
+int ml_sink_set_codec(ml_sink *sink, ml_codec codec);
+
+/**
+ * Sets the time threshold of buffered mode (0 disables it)
+ */
+void ml_sink_set_max_delay(ml_sink *sink, unsigned max_delay_ms);
+
+/**
+ * @return 0 on success, -1 on a write error
+ */
+int ml_sink_write(ml_sink *sink, const void *data, size_t len);
+
+/**
+ * Writes `count` parts back to back (the parts are copied, or sent with one
+ * writev() together with the buffer when they do not fit)
+ *
+ * @return 0 on success, -1 on a write error
+ */
+int ml_sink_write_parts(ml_sink *sink, const ml_sink_part *parts, size_t count);
+
+/**
+ * Writes prefix + name[0, len) + suffix, e.g. ("Hello, ", name, len, "!\n")
+ *
+ * @return 0 on success, -1 on a write error
+ */
+int ml_sink_greet(ml_sink *sink, const char *prefix, const char *name, size_t len, const char *suffix);
+
+/**
+ * Sends everything buffered to the descriptor (or fflush()es stdio). With a
+ * codec, the compressor is flushed too, so a reader can decode everything
+ * written so far.
+ *
+ * @return 0 on success, -1 on a write error
+ */
+int ml_sink_flush(ml_sink *sink);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //MULTILANG_OUTPUT_SINK_H
@@ -0,0 +1,305 @@
+#define _GNU_SOURCE
+
+#include "perf_counters.h"
+#include <errno.h>
+#include <linux/perf_event.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// perf_event_open counters (built with -DMULTILANG_PERF_COUNTERS=ON)
+//
+// Each thread opens one event group; the leader is read with
+// PERF_FORMAT_GROUP, so a snapshot of every event is a single read().
+// ml_stats_begin() keys its snapshot with the call's start timestamp, and
+// ml_stats_end() looks that key up again, so nested calls (an entry point
+// built on another one) each get their own deltas.
+
+#define SNAPSHOT_DEPTH 8  // calls that may be in progress on one thread at once
+
+typedef struct {
+    uint32_t type;
+    uint64_t config;
+    const char *name;    // JSON member
+    const char *column;  // table heading
+} event_spec;
+
+static const event_spec EVENTS[ML_PERF_EVENT_COUNT] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, "cycles", "cycles"},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, "instructions", "instr"},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, "cache_misses", "cache miss"},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, "branch_misses", "branch miss"},
+    {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES, "context_switches", "ctx switch"},
+};
+
+static const char *const LANGUAGES[] = {"C", "C++", "Rust"};
+
+typedef struct {
+    uint64_t start;  // ml_stats_begin() timestamp, 0 once consumed
+    uint64_t values[ML_PERF_EVENT_COUNT];
+} snapshot;
+
+typedef struct {
+    int opened;
+    int leader;                     // group fd, -1 if no event could be opened
+    int members;
+    int slot[ML_PERF_EVENT_COUNT];  // position in a group read, -1 if unavailable
+    snapshot snapshots[SNAPSHOT_DEPTH];
+    unsigned next;
+} thread_counters;
+
+typedef struct {
+    _Alignas(64) atomic_uint_fast64_t calls;
+    atomic_uint_fast64_t totals[ML_PERF_EVENT_COUNT];
+} entry_perf;
+
+static _Thread_local thread_counters tls;
+static entry_perf perf[ML_STATS_ENTRY_COUNT];
+static atomic_uint available;        // bit per event any thread could open
+static atomic_int kernel_excluded;
+
+static int open_event(const event_spec *spec, int group_fd, int exclude_kernel) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = spec->type;
+    attr.config = spec->config;
+    attr.read_format = PERF_FORMAT_GROUP;
+    attr.exclude_kernel = (unsigned)exclude_kernel;
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, PERF_FLAG_FD_CLOEXEC);
+}
+
+static void close_group(thread_counters *t) {
+    for (int i = 0; i < ML_PERF_EVENT_COUNT; i++) {
+        t->slot[i] = -1;
+    }
+    if (t->leader >= 0) {
+        close(t->leader);
+    }
+    t->leader = -1;
+    t->members = 0;
+}
+
+/**
+ * Opens every available event into one group
+ *
+ * @return 0 on success, -1 if the kernel refused to count kernel time
+ */
+static int open_group(thread_counters *t, int exclude_kernel, int *member_fds) {
+    t->leader = -1;
+    t->members = 0;
+    for (int i = 0; i < ML_PERF_EVENT_COUNT; i++) {
+        t->slot[i] = -1;
+        int fd = open_event(&EVENTS[i], t->leader, exclude_kernel);
+        if (fd < 0) {
+            if (!exclude_kernel && (errno == EACCES || errno == EPERM)) {
+                return -1;
+            }
+            continue;  // not provided here (ENOENT, EOPNOTSUPP, ...)
+        }
+        if (t->leader < 0) {
+            t->leader = fd;
+        }
+        member_fds[t->members] = fd;
+        t->slot[i] = t->members++;
+    }
+    return 0;
+}
+
+static void open_counters(thread_counters *t) {
+    int member_fds[ML_PERF_EVENT_COUNT];
+    t->opened = 1;
+    int exclude_kernel = 0;
+    if (open_group(t, 0, member_fds) != 0) {
+        for (int i = t->members - 1; i > 0; i--) {
+            close(member_fds[i]);
+        }
+        close_group(t);
+        exclude_kernel = 1;
+        open_group(t, 1, member_fds);
+    }
+    // The events stay open for the thread's lifetime (closing a member
+    // would drop it from the group); only the leader is ever read
+    unsigned mask = 0;
+    for (int i = 0; i < ML_PERF_EVENT_COUNT; i++) {
+        mask |= t->slot[i] >= 0 ? 1u << i : 0;
+    }
+    atomic_fetch_or_explicit(&available, mask, memory_order_relaxed);
+    if (exclude_kernel) {
+        atomic_store_explicit(&kernel_excluded, 1, memory_order_relaxed);
+    }
+}
+
+/**
+ * Reads every event of the thread's group into values[ML_PERF_EVENT_COUNT]
+ */
+static int read_counters(thread_counters *t, uint64_t *values) {
+    uint64_t buf[1 + ML_PERF_EVENT_COUNT];
+    ssize_t want = (ssize_t)((1 + (size_t)t->members) * sizeof(uint64_t));
+    if (read(t->leader, buf, sizeof(buf)) != want) {
+        return -1;
+    }
+    for (int i = 0; i < ML_PERF_EVENT_COUNT; i++) {
+        values[i] = t->slot[i] >= 0 ? buf[1 + t->slot[i]] : 0;
+    }
+    return 0;
+}
+
+void ml_perf_begin(uint64_t start) {
+    thread_counters *t = &tls;
+    if (!t->opened) {
+        open_counters(t);
+    }
+    if (t->leader < 0) {
+        return;
+    }
+    snapshot *s = &t->snapshots[t->next++ % SNAPSHOT_DEPTH];
+    s->start = read_counters(t, s->values) == 0 ? start : 0;
+}
+
+void ml_perf_end(ml_stats_entry entry, uint64_t start) {
+    thread_counters *t = &tls;
+    if (!t->opened || t->leader < 0 || (unsigned)entry >= ML_STATS_ENTRY_COUNT) {
+        return;
+    }
+    uint64_t now[ML_PERF_EVENT_COUNT];
+    if (read_counters(t, now) != 0) {
+        return;
+    }
+    // Most recent first: an inner call finishes before the one around it
+    for (unsigned back = 1; back <= SNAPSHOT_DEPTH; back++) {
+        snapshot *s = &t->snapshots[(t->next - back) % SNAPSHOT_DEPTH];
+        if (s->start != start) {
+            continue;
+        }
+        entry_perf *p = &perf[entry];
+        atomic_fetch_add_explicit(&p->calls, 1, memory_order_relaxed);
+        for (int i = 0; i < ML_PERF_EVENT_COUNT; i++) {
+            atomic_fetch_add_explicit(&p->totals[i], now[i] - s->values[i], memory_order_relaxed);
+        }
+        s->start = 0;
+        return;
+    }
+}
+
+// ============================================================================
+// REPORTS
+// ============================================================================
+
+typedef struct {
+    uint64_t calls;
+    uint64_t totals[ML_PERF_EVENT_COUNT];
+} perf_sum;
+
+static void add_entry(perf_sum *sum, int entry) {
+    sum->calls += atomic_load_explicit(&perf[entry].calls, memory_order_relaxed);
+    for (int i = 0; i < ML_PERF_EVENT_COUNT; i++) {
+        sum->totals[i] += atomic_load_explicit(&perf[entry].totals[i], memory_order_relaxed);
+    }
+}
+
+/**
+ * Prints one table row; `per_call` divides every counter by the call count
+ */
+static void print_row(FILE *out, const char *label, const perf_sum *sum, int per_call) {
+    unsigned mask = atomic_load_explicit(&available, memory_order_relaxed);
+    double div = per_call && sum->calls != 0 ? (double)sum->calls : 1.0;
+    fprintf(out, "  %-20s %8llu", label, (unsigned long long)sum->calls);
+    for (int i = 0; i < ML_PERF_EVENT_COUNT; i++) {
+        if (!(mask & (1u << i))) {
+            fprintf(out, " %12s", "-");
+        } else if (i == ML_PERF_CONTEXT_SWITCHES && per_call) {
+            fprintf(out, " %12.2f", (double)sum->totals[i] / div);
+        } else {
+            fprintf(out, " %12.0f", (double)sum->totals[i] / div);
+        }
+    }
+    unsigned ipc_mask = (1u << ML_PERF_CYCLES) | (1u << ML_PERF_INSTRUCTIONS);
+    if ((mask & ipc_mask) == ipc_mask && sum->totals[ML_PERF_CYCLES] != 0) {
+        fprintf(out, " %6.2f\n", (double)sum->totals[ML_PERF_INSTRUCTIONS] / (double)sum->totals[ML_PERF_CYCLES]);
+    } else {
+        fprintf(out, " %6s\n", "-");
+    }
+}
+
+static void print_heading(FILE *out, const char *title) {
+    fprintf(out, "\n%-22s %8s", title, "calls");
+    for (int i = 0; i < ML_PERF_EVENT_COUNT; i++) {
+        fprintf(out, " %12s", EVENTS[i].column);
+    }
+    fprintf(out, " %6s\n", "IPC");
+}
+
+void ml_perf_dump(FILE *out) {
+    perf_sum languages[sizeof(LANGUAGES) / sizeof(LANGUAGES[0])];
+    perf_sum all;
+    memset(languages, 0, sizeof(languages));
+    memset(&all, 0, sizeof(all));
+    for (int e = 0; e < ML_STATS_ENTRY_COUNT; e++) {
+        for (size_t l = 0; l < sizeof(LANGUAGES) / sizeof(LANGUAGES[0]); l++) {
+            if (strcmp(ml_stats_entry_language((ml_stats_entry)e), LANGUAGES[l]) == 0) {
+                add_entry(&languages[l], e);
+            }
+        }
+        add_entry(&all, e);
+    }
+    if (all.calls == 0) {
+        return;
+    }
+
+    int kernel = !atomic_load_explicit(&kernel_excluded, memory_order_relaxed);
+    print_heading(out, kernel ? "per call" : "per call (user only)");
+    for (size_t l = 0; l < sizeof(LANGUAGES) / sizeof(LANGUAGES[0]); l++) {
+        if (languages[l].calls == 0) {
+            continue;
+        }
+        fprintf(out, "%s\n", LANGUAGES[l]);
+        for (int e = 0; e < ML_STATS_ENTRY_COUNT; e++) {
+            perf_sum sum;
+            memset(&sum, 0, sizeof(sum));
+            add_entry(&sum, e);
+            if (sum.calls != 0 && strcmp(ml_stats_entry_language((ml_stats_entry)e), LANGUAGES[l]) == 0) {
+                print_row(out, ml_stats_entry_name((ml_stats_entry)e), &sum, 1);
+            }
+        }
+        print_row(out, "(all)", &languages[l], 1);
+    }
+
+    print_heading(out, "total");
+    for (size_t l = 0; l < sizeof(LANGUAGES) / sizeof(LANGUAGES[0]); l++) {
+        if (languages[l].calls != 0) {
+            print_row(out, LANGUAGES[l], &languages[l], 0);
+        }
+    }
+    print_row(out, "(all)", &all, 0);
+}
+
+void ml_perf_dump_entry_json(FILE *out, ml_stats_entry entry) {
+    if ((unsigned)entry >= ML_STATS_ENTRY_COUNT) {
+        return;
+    }
+    perf_sum sum;
+    memset(&sum, 0, sizeof(sum));
+    add_entry(&sum, entry);
+    unsigned mask = atomic_load_explicit(&available, memory_order_relaxed);
+    fprintf(out, ",\"language\":\"%s\",\"perf\":{\"calls\":%llu,\"kernel\":%s", ml_stats_entry_language(entry),
+            (unsigned long long)sum.calls,
+            atomic_load_explicit(&kernel_excluded, memory_order_relaxed) ? "false" : "true");
+    for (int i = 0; i < ML_PERF_EVENT_COUNT; i++) {
+        if (mask & (1u << i)) {
+            fprintf(out, ",\"%s\":%llu", EVENTS[i].name, (unsigned long long)sum.totals[i]);
+        }
+    }
+    fprintf(out, "}");
+}
+
+void ml_perf_reset(void) {
+    for (int e = 0; e < ML_STATS_ENTRY_COUNT; e++) {
+        atomic_store_explicit(&perf[e].calls, 0, memory_order_relaxed);
+        for (int i = 0; i < ML_PERF_EVENT_COUNT; i++) {
+            atomic_store_explicit(&perf[e].totals[i], 0, memory_order_relaxed);
+        }
+    }
+}
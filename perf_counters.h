@@ -0,0 +1,77 @@
+#ifndef MULTILANG_PERF_COUNTERS_H
+#define MULTILANG_PERF_COUNTERS_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "ml_stats.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ============================================================================
+// HARDWARE PERFORMANCE COUNTERS (perf_event_open, -DMULTILANG_PERF_COUNTERS=ON)
+// ============================================================================
+// Extends the MULTILANG_STATS counters (ml_stats.h) with what the CPU saw
+// during each ask_name_* call: cycles, instructions, cache misses, branch
+// misses and context switches. Counters follow the calling thread (one
+// perf event group per thread, opened on its first call) and are read with
+// one read() at ml_stats_begin() and one at ml_stats_end().
+//
+// Events the kernel or the machine does not provide (no PMU in a VM,
+// perf_event_paranoid) are reported as "-"; kernel time is excluded only
+// if the kernel refuses to count it.
+//
+// Without the CMake option the functions below are empty inline stubs, so
+// the stats hooks compile to exactly what they were before.
+
+typedef enum {
+    ML_PERF_CYCLES = 0,
+    ML_PERF_INSTRUCTIONS,
+    ML_PERF_CACHE_MISSES,
+    ML_PERF_BRANCH_MISSES,
+    ML_PERF_CONTEXT_SWITCHES,
+    ML_PERF_EVENT_COUNT
+} ml_perf_event;
+
+#ifdef MULTILANG_PERF_COUNTERS
+
+/**
+ * Snapshots the calling thread's counters for the call started at `start`
+ * (the ml_stats_begin() timestamp)
+ */
+void ml_perf_begin(uint64_t start);
+
+/**
+ * Adds the counter deltas since the matching ml_perf_begin() to `entry`
+ */
+void ml_perf_end(ml_stats_entry entry, uint64_t start);
+
+/**
+ * Writes the per-call averages and totals per entry point, grouped by
+ * language, as a table
+ */
+void ml_perf_dump(FILE *out);
+
+/**
+ * Writes the counters of `entry` as JSON members (",\"cycles\":N,...")
+ */
+void ml_perf_dump_entry_json(FILE *out, ml_stats_entry entry);
+
+void ml_perf_reset(void);
+
+#else
+
+static inline void ml_perf_begin(uint64_t start) { (void)start; }
+static inline void ml_perf_end(ml_stats_entry entry, uint64_t start) { (void)entry; (void)start; }
+static inline void ml_perf_dump(FILE *out) { (void)out; }
+static inline void ml_perf_dump_entry_json(FILE *out, ml_stats_entry entry) { (void)out; (void)entry; }
+static inline void ml_perf_reset(void) {}
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //MULTILANG_PERF_COUNTERS_H
@@ -0,0 +1,216 @@
+// Multi-threaded reader/worker/writer greeting pipeline
+#include "pipeline.h"
+#include "bounded_queue.h"
+#include "name_batch.h"
+#include "get_input_cpp.h"
+#include "greet_rust.h"
+#include "mem_budget.h"
+#include "utf8_scan.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Pipeline {
+    namespace {
+
+        constexpr size_t kDefaultBatchSize = 4096;
+        constexpr size_t kDefaultBatchesPerWorker = 4;
+        constexpr size_t kMaxNameLen = 99;    // same limit as the 100-byte buffers in main.c
+        constexpr size_t kGreetingScratch = kMaxNameLen + 64;
+        // Most one name can occupy in a batch: the name, its length and its greeting
+        // (plus the reader's view of it)
+        constexpr size_t kBytesPerName = kMaxNameLen + sizeof(uint32_t) + kGreetingScratch + sizeof(ml_name_view);
+
+        using GreetFn = size_t (*)(const char *name, size_t len, char *out, size_t cap);
+
+        // One unit of work; recycled through the free queue
+        struct Batch {
+            uint64_t seq = 0;
+            std::string names;               // names stored back to back
+            std::vector<uint32_t> lengths;   // length of each name in `names`
+            std::string output;              // greetings produced by a worker
+        };
+
+        struct Shared {
+            explicit Shared(size_t batches, unsigned workers)
+                : free_batches(batches), work(batches + workers), done(batches) {}
+
+            BoundedQueue<Batch*> free_batches;
+            BoundedQueue<Batch*> work;       // nullptr = "no more input" for one worker
+            BoundedQueue<Batch*> done;
+            std::atomic<uint64_t> total_batches{UINT64_MAX};  // known once the reader hits EOF
+            std::atomic<bool> input_idle{false};              // the reader waits for input
+            size_t names = 0;                                 // written by the reader only
+        };
+
+        // Idle hook of the reader thread (name_batch.h). The sink belongs to
+        // the writer, so the reader only tells it that no more input is ready.
+        void mark_input_idle(void *ctx) {
+            static_cast<Shared *>(ctx)->input_idle.store(true, std::memory_order_release);
+        }
+
+        void reader_loop(ml_batch_reader *reader, size_t batch_size, unsigned workers, Shared &shared) {
+            std::vector<ml_name_view> views(batch_size);
+            uint64_t seq = 0;
+
+            ml_input_set_idle_hook(mark_input_idle, &shared);
+            size_t count;
+            while (reader != nullptr && (count = ml_batch_reader_next(reader, views.data(), views.size())) > 0) {
+                shared.input_idle.store(false, std::memory_order_relaxed);
+                // Blocks while every batch is in flight (backpressure)
+                Batch *batch = shared.free_batches.pop();
+                batch->seq = seq++;
+                batch->names.clear();
+                batch->lengths.clear();
+                for (size_t i = 0; i < count; i++) {
+                    size_t len = ml_utf8_truncate(views[i].data, views[i].len, kMaxNameLen);
+                    batch->names.append(views[i].data, len);
+                    batch->lengths.push_back(static_cast<uint32_t>(len));
+                }
+                shared.names += count;
+                shared.work.push(batch);
+            }
+
+            ml_input_set_idle_hook(nullptr, nullptr);
+            shared.total_batches.store(seq, std::memory_order_release);
+            for (unsigned i = 0; i < workers; i++) {
+                shared.work.push(nullptr);
+            }
+        }
+
+        void worker_loop(GreetFn greet, Shared &shared) {
+            char scratch[kGreetingScratch];
+            for (;;) {
+                Batch *batch = shared.work.pop();
+                if (batch == nullptr) {
+                    return;
+                }
+
+                batch->output.clear();
+                const char *name = batch->names.data();
+                for (uint32_t len : batch->lengths) {
+                    size_t n = greet(name, len, scratch, sizeof(scratch));
+                    batch->output.append(scratch, n);
+                    name += len;
+                }
+                shared.done.push(batch);
+            }
+        }
+
+        void writer_loop(ml_sink *out, size_t batches, Shared &shared) {
+            // Batches finish out of order; park them by sequence number. At
+            // most `batches` are in flight, so seq % batches never collides.
+            std::vector<Batch*> parked(batches, nullptr);
+            uint64_t next = 0;
+            unsigned spins = 0;
+
+            while (next != shared.total_batches.load(std::memory_order_acquire)) {
+                Batch *batch;
+                if (!shared.done.try_pop(batch)) {
+                    // Nothing to write and the reader is waiting for input:
+                    // send what is buffered now, not when more names arrive
+                    if (shared.input_idle.load(std::memory_order_acquire)) {
+                        ml_sink_flush(out);
+                    }
+                    backoff(spins++);
+                    continue;
+                }
+                spins = 0;
+                parked[batch->seq % batches] = batch;
+
+                while (parked[next % batches] != nullptr) {
+                    Batch *ready = parked[next % batches];
+                    parked[next % batches] = nullptr;
+                    ml_sink_write(out, ready->output.data(), ready->output.size());
+                    shared.free_batches.push(ready);
+                    next++;
+                }
+            }
+            ml_sink_flush(out);
+        }
+    }
+}
+
+extern "C" void ml_pipeline_default_options(ml_pipeline_options *opts) {
+    opts->backend = ML_PIPELINE_CPP;
+    opts->workers = 0;
+    opts->batch_size = 0;
+    opts->batches = 0;
+}
+
+extern "C" size_t ml_run_pipeline(FILE *in, ml_sink *out, const ml_pipeline_options *opts) {
+    ml_batch_reader *reader = ml_batch_reader_create(in, 0, 0);
+    size_t names = ml_run_pipeline_reader(reader, out, opts);
+    if (ml_batch_reader_failed(reader)) {
+        names = static_cast<size_t>(-1);
+    }
+    ml_batch_reader_destroy(reader);
+    return names;
+}
+
+extern "C" size_t ml_run_pipeline_reader(ml_batch_reader *reader, ml_sink *out, const ml_pipeline_options *opts) {
+    using namespace Pipeline;
+
+    ml_pipeline_options config;
+    ml_pipeline_default_options(&config);
+    if (opts != nullptr) {
+        config = *opts;
+    }
+
+    unsigned workers = config.workers != 0 ? config.workers : std::thread::hardware_concurrency();
+    workers = std::max(workers, 1u);
+    size_t batch_size = config.batch_size != 0 ? config.batch_size : kDefaultBatchSize;
+    size_t batches = config.batches != 0 ? config.batches : kDefaultBatchesPerWorker * workers;
+    GreetFn greet = config.backend == ML_PIPELINE_RUST ? greet_name_rust : greet_name_cpp;
+
+    // The pool is the pipeline's memory: shrink it to what is left of the
+    // --max-mem budget. Fewer batches in flight only means the reader waits
+    // for the writer sooner (the free queue is the backpressure).
+    // The reader charges one newline position per name of a batch itself.
+    size_t available = ml_mem_available();
+    size_t per_batch = batch_size * kBytesPerName;
+    size_t positions = batch_size * sizeof(size_t);
+    if (available < positions || (available - positions) / per_batch < batches) {
+        if (available < per_batch + positions) {
+            batch_size = std::max<size_t>(available / (kBytesPerName + sizeof(size_t)), 1);
+            per_batch = batch_size * kBytesPerName;
+            positions = batch_size * sizeof(size_t);
+        }
+        batches = std::max<size_t>((available - std::min(available, positions)) / per_batch, 1);
+    }
+    size_t pool_bytes = batches * per_batch;
+    ml_mem_charge(pool_bytes);  // the most the batches can grow to
+
+    Shared shared(batches, workers);
+    std::vector<std::unique_ptr<Batch>> pool;
+    for (size_t i = 0; i < batches; i++) {
+        pool.push_back(std::make_unique<Batch>());
+        if (ml_mem_budget() != 0) {
+            // Full size up front, so the batches never grow past what was charged
+            pool.back()->names.reserve(batch_size * kMaxNameLen);
+            pool.back()->lengths.reserve(batch_size);
+            pool.back()->output.reserve(batch_size * kGreetingScratch);
+        }
+        shared.free_batches.push(pool.back().get());
+    }
+
+    std::thread writer(writer_loop, out, batches, std::ref(shared));
+    std::vector<std::thread> worker_threads;
+    for (unsigned i = 0; i < workers; i++) {
+        worker_threads.emplace_back(worker_loop, greet, std::ref(shared));
+    }
+
+    reader_loop(reader, batch_size, workers, shared);  // the calling thread is the reader
+
+    for (auto &t : worker_threads) {
+        t.join();
+    }
+    writer.join();
+    ml_mem_release(pool_bytes);
+    return shared.names;
+}
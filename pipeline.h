@@ -0,0 +1,71 @@
+
+#ifndef MULTILANG_PIPELINE_H
+#define MULTILANG_PIPELINE_H
+
+#include <stddef.h>
+#include <stdio.h>
+#include "output_sink.h"
+#include "name_batch.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ============================================================================
+// MULTI-THREADED GREETING PIPELINE
+// ============================================================================
+//
+//   reader thread ──► work queue ──► N worker threads ──► done queue ──► writer thread
+//   (batch API)                      (greet_name_cpp /                  (input order)
+//                                     greet_name_rust)
+//
+// The reader slices the input into batches of names, the workers run the
+// greeting logic of the selected implementation on whole batches, and the
+// writer emits each batch's greetings strictly in input order into an
+// output sink. The stages are connected by bounded lock-free queues; a fixed
+// pool of batches bounds the memory in flight, so a slow writer stalls the
+// reader instead of growing. Under a --max-mem budget (mem_budget.h) the
+// pool shrinks to fit what the reader and the sink leave of it.
+
+typedef enum {
+    ML_PIPELINE_CPP = 0,   // "Hello from C++, ..." (greet_name_cpp)
+    ML_PIPELINE_RUST = 1,  // "Hello from Rust, ..." (greet_name_rust)
+} ml_pipeline_backend;
+
+typedef struct {
+    ml_pipeline_backend backend;
+    unsigned workers;       // worker threads; 0 = one per hardware thread
+    size_t batch_size;      // names per batch; 0 = 4096
+    size_t batches;         // batches in flight; 0 = 4 per worker
+} ml_pipeline_options;
+
+/**
+ * Puts the defaults described above into `opts`
+ */
+void ml_pipeline_default_options(ml_pipeline_options *opts);
+
+/**
+ * Greets every line of `in`, writing the greetings to `out` in input order
+ * (`out` is only touched by the writer thread and flushed before returning)
+ *
+ * @param opts NULL selects the defaults
+ * @return Number of names processed, or (size_t)-1 if `in` was corrupt or
+ *         truncated compressed input (what decoded is still greeted)
+ */
+size_t ml_run_pipeline(FILE *in, ml_sink *out, const ml_pipeline_options *opts);
+
+/**
+ * Same as ml_run_pipeline(), reading names from an existing batch reader
+ * (e.g. a mapped file from ml_batch_reader_open()); the reader is not destroyed.
+ * Check ml_batch_reader_failed() afterwards for corrupt compressed input.
+ * The calling thread is the reader: its idle hook (name_batch.h) is
+ * replaced while the pipeline runs, and the writer flushes `out` whenever
+ * the reader waits for input.
+ */
+size_t ml_run_pipeline_reader(ml_batch_reader *reader, ml_sink *out, const ml_pipeline_options *opts);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //MULTILANG_PIPELINE_H
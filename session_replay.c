@@ -0,0 +1,321 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "session_replay.h"
+#include "latency_histogram.h"
+#include "utf8_scan.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SESSION_HEADER "# multilang-session 1\n"
+#define REPLAY_NAME_SIZE 100  // the name buffer main.c hands to every implementation
+
+struct ml_session_writer {
+    FILE *file;
+    uint64_t origin_ns;
+    int failed;
+};
+
+struct ml_session {
+    ml_session_call *calls;
+    size_t count;
+};
+
+uint64_t ml_session_clock(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+// ============================================================================
+// RECORDING
+// ============================================================================
+
+ml_session_writer *ml_session_writer_open(const char *path) {
+    ml_session_writer *writer = calloc(1, sizeof(*writer));
+    if (writer == NULL) {
+        return NULL;
+    }
+    writer->file = fopen(path, "w");
+    if (writer->file == NULL) {
+        free(writer);
+        return NULL;
+    }
+    writer->failed = fputs(SESSION_HEADER, writer->file) < 0;
+    writer->origin_ns = ml_session_clock();
+    return writer;
+}
+
+int ml_session_writer_add(ml_session_writer *writer, uint64_t start, const char *impl,
+                          const char *name, size_t len) {
+    uint64_t end = ml_session_clock();
+    len = ml_utf8_truncate(name, len, ML_SESSION_MAX_NAME);
+    if (fprintf(writer->file, "%s\t%llu\t%llu\t", impl, (unsigned long long)(start - writer->origin_ns),
+                (unsigned long long)(end - start)) < 0
+        || fwrite(name, 1, len, writer->file) != len || fputc('\n', writer->file) == EOF) {
+        writer->failed = 1;
+        return -1;
+    }
+    return 0;
+}
+
+int ml_session_writer_close(ml_session_writer *writer) {
+    if (writer == NULL) {
+        return 0;
+    }
+    int failed = writer->failed;
+    int saved_errno = errno;
+    if (fclose(writer->file) != 0) {
+        failed = 1;
+        saved_errno = errno;
+    }
+    free(writer);
+    errno = saved_errno;
+    return failed ? -1 : 0;
+}
+
+// ============================================================================
+// LOADING
+// ============================================================================
+
+/**
+ * Parses "<impl>\t<start>\t<duration>\t<name>" in place; `line` must stay
+ * alive as long as `call`
+ *
+ * @return 0 on success, -1 if the line is malformed
+ */
+static int parse_call(char *line, size_t len, ml_session_call *call) {
+    if (len > 0 && line[len - 1] == '\n') {
+        line[--len] = '\0';
+    }
+    char *tab = memchr(line, '\t', len);
+    if (tab == NULL || tab == line) {
+        return -1;
+    }
+    *tab = '\0';
+    call->impl = line;
+
+    char *end;
+    errno = 0;
+    call->start_ns = strtoull(tab + 1, &end, 10);
+    if (errno != 0 || end == tab + 1 || *end != '\t') {
+        return -1;
+    }
+    char *field = end + 1;
+    call->duration_ns = strtoull(field, &end, 10);
+    if (errno != 0 || end == field || *end != '\t') {
+        return -1;
+    }
+    call->name = end + 1;
+    call->len = ml_utf8_truncate(call->name, (size_t)(line + len - (end + 1)), ML_SESSION_MAX_NAME);
+    ((char *)call->name)[call->len] = '\0';
+    return 0;
+}
+
+ml_session *ml_session_load(const char *path) {
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        return NULL;
+    }
+    ml_session *session = calloc(1, sizeof(*session));
+    if (session == NULL) {
+        fclose(file);
+        return NULL;
+    }
+
+    size_t cap = 0;
+    int malformed = 0;
+    int first = 1;
+    char *line = NULL;
+    size_t line_cap = 0;
+    ssize_t got;
+    while ((got = getline(&line, &line_cap, file)) >= 0) {
+        if (first) {
+            first = 0;
+            if (strcmp(line, SESSION_HEADER) != 0) {
+                malformed = 1;
+                break;
+            }
+            continue;
+        }
+        if (line[0] == '#' || line[0] == '\n') {
+            continue;
+        }
+        if (session->count == cap) {
+            size_t new_cap = cap != 0 ? cap * 2 : 64;
+            ml_session_call *calls = realloc(session->calls, new_cap * sizeof(calls[0]));
+            if (calls == NULL) {
+                break;
+            }
+            session->calls = calls;
+            cap = new_cap;
+        }
+        // The call keeps pointers into the line: take it over, getline allocates the next one
+        if (parse_call(line, (size_t)got, &session->calls[session->count]) != 0) {
+            malformed = 1;
+            break;
+        }
+        session->count++;
+        line = NULL;
+        line_cap = 0;
+    }
+
+    int failed = malformed || first || ferror(file) || !feof(file);
+    int saved_errno = malformed || first ? EINVAL : errno;
+    free(line);
+    fclose(file);
+    if (failed) {
+        ml_session_free(session);
+        errno = saved_errno;
+        return NULL;
+    }
+    return session;
+}
+
+size_t ml_session_count(const ml_session *session) {
+    return session->count;
+}
+
+const ml_session_call *ml_session_call_at(const ml_session *session, size_t index) {
+    return index < session->count ? &session->calls[index] : NULL;
+}
+
+void ml_session_free(ml_session *session) {
+    if (session == NULL) {
+        return;
+    }
+    for (size_t i = 0; i < session->count; i++) {
+        free((char *)session->calls[i].impl);  // start of the line that holds both strings
+    }
+    free(session->calls);
+    free(session);
+}
+
+// ============================================================================
+// REPLAY
+// ============================================================================
+
+typedef struct {
+    ml_latency replayed;
+    ml_latency recorded;
+} impl_latency;
+
+static void sleep_until(uint64_t deadline_ns) {
+    struct timespec ts = {
+        .tv_sec = (time_t)(deadline_ns / 1000000000u),
+        .tv_nsec = (long)(deadline_ns % 1000000000u),
+    };
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+    }
+}
+
+/**
+ * Writes all of line[0, len) to the pipe, retrying on EINTR
+ */
+static int feed_line(int fd, const char *line, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, line, len);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        line += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+static void print_percentiles(FILE *report, const char *label, ml_latency *h) {
+    fprintf(report, "  %-9s p50 %10llu  p99 %10llu  p999 %10llu  max %10llu ns\n", label,
+            (unsigned long long)ml_latency_percentile(h, 50.0),
+            (unsigned long long)ml_latency_percentile(h, 99.0),
+            (unsigned long long)ml_latency_percentile(h, 99.9),
+            (unsigned long long)ml_latency_percentile(h, 100.0));
+}
+
+size_t ml_session_replay(const ml_session *session, ml_replay_speed speed, const ml_impl *only, FILE *report) {
+    size_t impls = ml_impl_count();
+    for (size_t i = 0; i < session->count && only == NULL; i++) {
+        if (ml_impl_find(session->calls[i].impl) == NULL) {
+            fprintf(report, "Unknown implementation in recording: %s\n", session->calls[i].impl);
+            errno = EINVAL;
+            return (size_t)-1;
+        }
+    }
+
+    impl_latency *latency = calloc(impls, sizeof(*latency));
+    char *line = malloc(ML_SESSION_MAX_NAME + 1);
+    int fds[2];
+    if (latency == NULL || line == NULL || pipe(fds) != 0) {
+        free(latency);
+        free(line);
+        return (size_t)-1;
+    }
+    // One line per call is in the pipe at a time, so however the
+    // implementation buffers stdin it reads exactly the recorded name
+    if (dup2(fds[0], STDIN_FILENO) < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        free(latency);
+        free(line);
+        return (size_t)-1;
+    }
+    close(fds[0]);
+    clearerr(stdin);
+
+    size_t replayed = 0;
+    uint64_t origin = ml_session_clock();
+    for (size_t i = 0; i < session->count; i++) {
+        const ml_session_call *call = &session->calls[i];
+        const ml_impl *impl = only != NULL ? only : ml_impl_find(call->impl);
+        size_t index = 0;
+        while (ml_impl_at(index) != impl) {
+            index++;
+        }
+
+        if (speed == ML_REPLAY_RECORDED) {
+            sleep_until(origin + call->start_ns);
+        }
+        memcpy(line, call->name, call->len);
+        line[call->len] = '\n';
+        if (feed_line(fds[1], line, call->len + 1) != 0) {
+            break;
+        }
+
+        char name[REPLAY_NAME_SIZE];
+        uint64_t start = ml_session_clock();
+        int got = ml_impl_ask(impl, name, sizeof(name));
+        uint64_t elapsed = ml_session_clock() - start;
+        if (!got) {
+            break;
+        }
+        ml_latency_add(&latency[index].replayed, elapsed);
+        ml_latency_add(&latency[index].recorded, call->duration_ns);
+        replayed++;
+    }
+    close(fds[1]);
+    fflush(stdout);
+
+    fprintf(report, "Replayed %zu of %zu calls (%s)\n", replayed, session->count,
+            speed == ML_REPLAY_RECORDED ? "recorded speed" : "max speed");
+    for (size_t k = 0; k < impls; k++) {
+        if (latency[k].replayed.count == 0) {
+            continue;
+        }
+        fprintf(report, "\n%s: %zu calls\n", ml_impl_at(k)->name, latency[k].replayed.count);
+        print_percentiles(report, "replayed", &latency[k].replayed);
+        if (only == NULL) {
+            print_percentiles(report, "recorded", &latency[k].recorded);
+        }
+        ml_latency_print(&latency[k].replayed, report);
+        ml_latency_free(&latency[k].replayed);
+        ml_latency_free(&latency[k].recorded);
+    }
+    free(latency);
+    free(line);
+    return replayed;
+}
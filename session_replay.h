@@ -0,0 +1,113 @@
+#ifndef MULTILANG_SESSION_REPLAY_H
+#define MULTILANG_SESSION_REPLAY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "impl_registry.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ============================================================================
+// SESSION RECORD / REPLAY (--record, --replay)
+// ============================================================================
+// --record writes one line per interactive ask_name_* call made by main.c:
+//
+//   # multilang-session 1
+//   <impl>\t<start ns>\t<duration ns>\t<name>
+//
+// `start` is the offset of the call from the start of the recording and
+// `duration` how long it took (including the wait for input, when a person
+// was typing). The name is the rest of the line, as the implementation
+// returned it, so it may contain tabs. Lines starting with '#' are comments.
+//
+// --replay feeds the recorded names back, one line per call, through a pipe
+// standing in for stdin, and times each call: the input is always already
+// there, so the replayed latency is the implementation's own cost. Calls
+// start either back to back or at their recorded offsets.
+
+#define ML_SESSION_MAX_NAME 4095  // longer names are cut (one pipe write per call)
+
+typedef enum {
+    ML_REPLAY_MAX_SPEED = 0,  // every call right after the previous one
+    ML_REPLAY_RECORDED,       // every call at its recorded offset
+} ml_replay_speed;
+
+typedef struct ml_session_writer ml_session_writer;
+
+typedef struct {
+    const char *impl;      // ml_impl name
+    uint64_t start_ns;     // offset from the start of the session
+    uint64_t duration_ns;
+    const char *name;      // NUL-terminated, owned by the session
+    size_t len;
+} ml_session_call;
+
+typedef struct ml_session ml_session;
+
+/**
+ * @return Monotonic timestamp to pass to ml_session_writer_add()
+ */
+uint64_t ml_session_clock(void);
+
+/**
+ * Creates (or truncates) `path` and writes the header; the session's time
+ * origin is now
+ *
+ * @return Writer, or NULL if the file cannot be created (errno is set)
+ */
+ml_session_writer *ml_session_writer_open(const char *path);
+
+/**
+ * Records a call of `impl` that started at `start` (ml_session_clock())
+ * and ends now
+ *
+ * @return 0 on success, -1 on a write error
+ */
+int ml_session_writer_add(ml_session_writer *writer, uint64_t start, const char *impl,
+                          const char *name, size_t len);
+
+/**
+ * Flushes and closes the file
+ *
+ * @return 0 on success, -1 if any write failed (errno is set)
+ */
+int ml_session_writer_close(ml_session_writer *writer);
+
+/**
+ * Reads a recording made with ml_session_writer_open()
+ *
+ * @return Session, or NULL if the file cannot be read or is malformed
+ *         (errno is set; EINVAL for a malformed file)
+ */
+ml_session *ml_session_load(const char *path);
+
+/**
+ * @return Number of recorded calls
+ */
+size_t ml_session_count(const ml_session *session);
+
+/**
+ * @return Call `index` (< ml_session_count()), in recorded order
+ */
+const ml_session_call *ml_session_call_at(const ml_session *session, size_t index);
+
+void ml_session_free(ml_session *session);
+
+/**
+ * Replays every call of `session` with its recorded implementation, or
+ * with `only` if it is not NULL, and prints a latency histogram per
+ * implementation to `report`. Replaces stdin with the replay pipe.
+ *
+ * @return Number of calls replayed, or (size_t)-1 if a recorded
+ *         implementation is unknown or the pipe cannot be set up
+ */
+size_t ml_session_replay(const ml_session *session, ml_replay_speed speed, const ml_impl *only, FILE *report);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //MULTILANG_SESSION_REPLAY_H
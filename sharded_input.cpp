@@ -0,0 +1,259 @@
+// Sharded processing of one mapped file: one independent thread per byte range
+#include "sharded_input.h"
+#include "mapped_input.h"
+#include "compressed_io.h"
+#include "name_batch.h"
+#include "line_scan.h"
+#include "utf8_scan.h"
+#include "get_input.h"
+#include "get_input_cpp.h"
+#include "greet_rust.h"
+#include "mem_budget.h"
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Sharded {
+    namespace {
+
+        constexpr size_t kBlockSize = 1024 * 1024;
+        constexpr size_t kMinBlockSize = 16 * 1024;  // smallest block a --max-mem budget shrinks to
+        constexpr size_t kViews = 1024;
+        constexpr size_t kGreetingOverhead = 32;  // prefix + suffix, with room to spare
+        constexpr size_t kPipelineMaxNameLen = 99;  // the C++/Rust lines match --pipeline (same ml_utf8_truncate cut)
+
+        using GreetFn = size_t (*)(const char *name, size_t len, char *out, size_t cap);
+
+        // A thread's private output buffer; handed to the merge when full.
+        // Charged to the memory budget for as long as it is allocated.
+        struct Block {
+            std::unique_ptr<char[]> data;
+            size_t used = 0;
+            size_t cap = 0;
+
+            explicit Block(size_t size = 0) : data(size != 0 ? new char[size] : nullptr), cap(size) {
+                ml_mem_charge(cap);
+            }
+            Block(Block &&other) noexcept : data(std::move(other.data)), used(other.used), cap(other.cap) {
+                other.used = other.cap = 0;
+            }
+            Block &operator=(Block &&other) noexcept {
+                if (this != &other) {
+                    ml_mem_release(cap);
+                    data = std::move(other.data);
+                    used = other.used;
+                    cap = other.cap;
+                    other.used = other.cap = 0;
+                }
+                return *this;
+            }
+            ~Block() {
+                ml_mem_release(cap);
+            }
+        };
+
+        // Full blocks on their way to the merge; the only point threads meet.
+        // Holds at most `capacity` bytes of blocks: a producer that would go
+        // over waits until the merge has written enough (backpressure). An
+        // empty queue takes any block, so an oversized one cannot stall it.
+        class BlockQueue {
+        public:
+            BlockQueue(unsigned producers, size_t capacity) : producers_(producers), capacity_(capacity) {}
+
+            void push(Block &&block) {
+                {
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    space_.wait(lock, [&] {
+                        return bytes_ == 0 || (bytes_ <= capacity_ && block.cap <= capacity_ - bytes_);
+                    });
+                    bytes_ += block.cap;
+                    blocks_.push_back(std::move(block));
+                }
+                ready_.notify_one();
+            }
+
+            void producer_done() {
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    producers_--;
+                }
+                ready_.notify_one();
+            }
+
+            // Waits for the next block; false once every producer is done and nothing is left
+            bool pop(Block &block) {
+                std::unique_lock<std::mutex> lock(mutex_);
+                ready_.wait(lock, [this] { return !blocks_.empty() || producers_ == 0; });
+                if (blocks_.empty()) {
+                    return false;
+                }
+                block = std::move(blocks_.front());
+                blocks_.pop_front();
+                bytes_ -= block.cap;
+                lock.unlock();
+                space_.notify_all();
+                return true;
+            }
+
+        private:
+            std::mutex mutex_;
+            std::condition_variable ready_;
+            std::condition_variable space_;
+            std::deque<Block> blocks_;
+            unsigned producers_;
+            size_t capacity_;
+            size_t bytes_ = 0;   // sum of the queued blocks' capacities
+        };
+
+        struct Config {
+            GreetFn greet;
+            size_t max_name;
+            unsigned reader_flags;
+            size_t block_size;
+        };
+
+        size_t shard_loop(const char *data, size_t len, const Config &config, BlockQueue &queue) {
+            size_t names = 0;
+            ml_batch_reader *reader = len != 0 ? ml_batch_reader_create_mem(data, len, config.reader_flags) : nullptr;
+            std::vector<ml_name_view> views(kViews);
+            Block block(config.block_size);
+
+            size_t count;
+            while (reader != nullptr && (count = ml_batch_reader_next(reader, views.data(), views.size())) > 0) {
+                for (size_t i = 0; i < count; i++) {
+                    size_t name_len = ml_utf8_truncate(views[i].data, views[i].len, config.max_name);
+                    size_t need = name_len + kGreetingOverhead;
+                    if (need > block.cap - block.used) {
+                        if (block.used != 0) {
+                            queue.push(std::move(block));
+                        }
+                        block = Block(std::max(config.block_size, need));  // a long name gets its own block
+                    }
+                    block.used += config.greet(views[i].data, name_len, block.data.get() + block.used,
+                                               block.cap - block.used);
+                }
+                names += count;
+            }
+            if (block.used != 0) {
+                queue.push(std::move(block));
+            }
+            queue.producer_done();
+            ml_batch_reader_destroy(reader);
+            return names;
+        }
+    }
+}
+
+extern "C" void ml_shard_bounds(const char *data, size_t len, unsigned shards, size_t *bounds) {
+    bounds[0] = 0;
+    for (unsigned i = 1; i < shards; i++) {
+        size_t pos = std::max(len / shards * i + len % shards * i / shards, bounds[i - 1]);
+        if (pos > 0 && pos < len && data[pos - 1] != '\n') {
+            pos += ml_find_newline(data + pos, len - pos) + 1;  // finish the line we landed in
+        }
+        bounds[i] = std::min(pos, len);
+    }
+    bounds[shards] = len;
+}
+
+extern "C" void ml_shard_default_options(ml_shard_options *opts) {
+    opts->backend = ML_SHARD_C;
+    opts->merge = ML_SHARD_ORDERED;
+    opts->threads = 0;
+    opts->reader_flags = 0;
+}
+
+extern "C" size_t ml_run_sharded(const char *data, size_t len, ml_sink *out, const ml_shard_options *opts) {
+    using namespace Sharded;
+
+    ml_shard_options options;
+    ml_shard_default_options(&options);
+    if (opts != nullptr) {
+        options = *opts;
+    }
+
+    unsigned threads = options.threads != 0 ? options.threads : std::thread::hardware_concurrency();
+    threads = std::max(threads, 1u);
+    Config config{greet_name_c, SIZE_MAX, options.reader_flags, kBlockSize};
+    if (options.backend == ML_SHARD_CPP) {
+        config = Config{greet_name_cpp, kPipelineMaxNameLen, options.reader_flags, kBlockSize};
+    } else if (options.backend == ML_SHARD_RUST) {
+        config = Config{greet_name_rust, kPipelineMaxNameLen, options.reader_flags, kBlockSize};
+    }
+
+    std::vector<size_t> bounds(threads + 1);
+    ml_shard_bounds(data, len, threads, bounds.data());
+    bool ordered = options.merge == ML_SHARD_ORDERED;
+
+    // Under a --max-mem budget every shard fills one block and the merge
+    // writes one; what is left is split between the queues. An empty queue
+    // still takes one block, so a tiny budget ends up at about three blocks
+    // per shard (the floor the README documents). In ordered mode
+    // the shard being merged always drains, so the others waiting on a full
+    // queue cannot deadlock it.
+    size_t capacity = SIZE_MAX;
+    if (ml_mem_budget() != 0) {
+        size_t available = ml_mem_available();
+        config.block_size = std::clamp(available / (4 * static_cast<size_t>(threads)), kMinBlockSize, kBlockSize);
+        config.max_name = std::min(config.max_name, config.block_size - kGreetingOverhead);  // cut, like the readers
+        size_t working = (threads + 1u) * config.block_size + threads * kViews * sizeof(size_t);
+        capacity = available > working ? available - working : 0;
+        if (ordered) {
+            capacity /= threads;
+        }
+    }
+
+    // Ordered: one queue per shard, drained in shard order. Unordered: one
+    // queue all shards push to, drained as blocks arrive.
+    std::vector<std::unique_ptr<BlockQueue>> queues;
+    for (unsigned i = 0; i < (ordered ? threads : 1u); i++) {
+        queues.push_back(std::make_unique<BlockQueue>(ordered ? 1u : threads, capacity));
+    }
+
+    std::vector<size_t> names(threads, 0);
+    std::vector<std::thread> shard_threads;
+    for (unsigned i = 0; i < threads; i++) {
+        BlockQueue *queue = queues[ordered ? i : 0].get();
+        shard_threads.emplace_back([&, i, queue] {
+            names[i] = shard_loop(data + bounds[i], bounds[i + 1] - bounds[i], config, *queue);
+        });
+    }
+
+    // The calling thread is the merge
+    Block block;
+    for (auto &queue : queues) {
+        while (queue->pop(block)) {
+            ml_sink_write(out, block.data.get(), block.used);
+        }
+    }
+    ml_sink_flush(out);
+
+    size_t total = 0;
+    for (unsigned i = 0; i < threads; i++) {
+        shard_threads[i].join();
+        total += names[i];
+    }
+    return total;
+}
+
+extern "C" size_t ml_run_sharded_file(const char *path, ml_sink *out, const ml_shard_options *opts) {
+    ml_mapped_file *file = ml_map_file(path);
+    if (file == nullptr) {
+        return static_cast<size_t>(-1);
+    }
+    if (ml_codec_detect(ml_mapped_data(file), ml_mapped_size(file)) != ML_CODEC_NONE) {
+        ml_unmap_file(file);  // a compressed stream has no line boundaries to split at
+        errno = ENOTSUP;
+        return static_cast<size_t>(-1);
+    }
+    size_t names = ml_run_sharded(ml_mapped_data(file), ml_mapped_size(file), out, opts);
+    ml_unmap_file(file);
+    return names;
+}
@@ -0,0 +1,90 @@
+#ifndef MULTILANG_SHARDED_INPUT_H
+#define MULTILANG_SHARDED_INPUT_H
+
+#include <stddef.h>
+#include "output_sink.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ============================================================================
+// SHARDED PROCESSING OF ONE MAPPED FILE
+// ============================================================================
+//
+//   [ shard 0 | shard 1 | ... | shard N-1 ]   one mapped file, cut on '\n'
+//        │         │               │
+//     thread 0  thread 1  ...  thread N-1     batch reader + greeting logic,
+//        │         │               │          private output blocks
+//        └─────────┴───── merge ───┘          calling thread → output sink
+//
+// Unlike the pipeline (pipeline.h) there is no reader thread: every thread
+// scans, splits and greets its own byte range of the mapping, straight out
+// of the page cache, and shares nothing with the others until its finished
+// output blocks are handed to the merge.
+//
+// ML_SHARD_ORDERED writes the shards' output in file order: shard 0 streams
+// as it goes, later shards keep their output in memory until their turn.
+// ML_SHARD_UNORDERED writes every block as soon as it is full, so memory
+// stays at a few blocks per thread but lines of different shards interleave
+// (each line stays whole).
+//
+// With a --max-mem budget (mem_budget.h) the queued output is capped: a
+// shard whose turn has not come waits instead of buffering more. The
+// mapping itself is page cache and is not charged.
+
+typedef enum {
+    ML_SHARD_C = 0,     // "Hello, ..." (greet_name_c, like --batch)
+    ML_SHARD_CPP = 1,   // "Hello from C++, ..." (greet_name_cpp, like --pipeline)
+    ML_SHARD_RUST = 2,  // "Hello from Rust, ..." (greet_name_rust, like --pipeline=rust)
+} ml_shard_backend;
+
+typedef enum {
+    ML_SHARD_ORDERED = 0,
+    ML_SHARD_UNORDERED = 1,
+} ml_shard_merge;
+
+typedef struct {
+    ml_shard_backend backend;
+    ml_shard_merge merge;
+    unsigned threads;       // shards, one thread each; 0 = one per hardware thread
+    unsigned reader_flags;  // ML_BATCH_* flags (name_batch.h) for every shard's reader
+} ml_shard_options;
+
+/**
+ * Cuts data[0, len) into `shards` ranges that each start at 0 or right
+ * after a '\n', so no line is split; range i is [bounds[i], bounds[i + 1]).
+ * Ranges may be empty when there are fewer lines than shards.
+ *
+ * @param bounds Receives shards + 1 offsets
+ */
+void ml_shard_bounds(const char *data, size_t len, unsigned shards, size_t *bounds);
+
+/**
+ * Puts the defaults (C greeting, ordered, one thread per core) into `opts`
+ */
+void ml_shard_default_options(ml_shard_options *opts);
+
+/**
+ * Greets every line of data[0, len) on `threads` threads into `out`
+ * (`out` is only touched by the calling thread and flushed before returning)
+ *
+ * @param opts NULL selects the defaults
+ * @return Number of names processed
+ */
+size_t ml_run_sharded(const char *data, size_t len, ml_sink *out, const ml_shard_options *opts);
+
+/**
+ * Maps `path` (mapped_input.h) and runs ml_run_sharded() over it
+ *
+ * @return Number of names processed, or (size_t)-1 if the file cannot be
+ *         mapped (errno is set) or is compressed (ENOTSUP, see
+ *         compressed_io.h)
+ */
+size_t ml_run_sharded_file(const char *path, ml_sink *out, const ml_shard_options *opts);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //MULTILANG_SHARDED_INPUT_H
@@ -0,0 +1,265 @@
+#define _DEFAULT_SOURCE  // MAP_ANONYMOUS
+#include "spsc_ring.h"
+#include "mem_budget.h"
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <string.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#define cpu_relax() _mm_pause()
+#elif defined(__aarch64__)
+#define cpu_relax() __asm__ __volatile__("yield")
+#else
+#define cpu_relax() ((void)0)
+#endif
+
+// Positions are free-running 64-bit byte counters (they never wrap in
+// practice); the offset in the data area is position & mask. Each record is
+// an 8-byte header followed by its payload, padded to 8 bytes.
+
+#define CACHE_LINE 64
+#define RING_MAGIC 0x4d4c52494e473031ull  // "MLRING01"
+#define MIN_CAPACITY 4096u
+#define HEADER_SIZE 8u
+#define PAD_FLAG 1u
+
+_Static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "ring indices must be lock-free to work across processes");
+
+typedef struct {
+    uint32_t len;
+    uint32_t flags;  // PAD_FLAG: skip to the start of the data area
+} record_header;
+
+struct ml_ring {
+    // Written once by ml_ring_init()
+    alignas(CACHE_LINE) uint64_t magic;
+    uint64_t capacity;
+    uint64_t mask;
+    uint64_t mapped_size;  // non-zero when ml_ring_create() mapped the region
+
+    // Producer line
+    alignas(CACHE_LINE) _Atomic uint64_t head;  // end of the published records
+    uint64_t tail_cache;    // last tail the producer saw
+    uint64_t reserved;      // position of the reserved header
+    atomic_uint closed;
+
+    // Consumer line
+    alignas(CACHE_LINE) _Atomic uint64_t tail;  // start of the unreleased records
+    uint64_t head_cache;    // last head the consumer saw
+    uint64_t peeked_size;   // header + padded payload of the peeked record
+
+    alignas(CACHE_LINE) unsigned char data[];
+};
+
+static size_t round_capacity(size_t capacity) {
+    size_t rounded = MIN_CAPACITY;
+    while (rounded < capacity) {
+        rounded *= 2;
+    }
+    return rounded;
+}
+
+static uint64_t padded(size_t len) {
+    return HEADER_SIZE + (((uint64_t)len + 7u) & ~(uint64_t)7u);
+}
+
+/**
+ * Waits a little longer on each call: spin, then yield, then sleep
+ */
+static void backoff(unsigned *round) {
+    if (*round < 64) {
+        cpu_relax();
+    } else if (*round < 256) {
+        sched_yield();
+    } else {
+        struct timespec ts = {0, 20000};  // 20 us
+        nanosleep(&ts, NULL);
+    }
+    (*round)++;
+}
+
+size_t ml_ring_region_size(size_t capacity) {
+    return sizeof(ml_ring) + round_capacity(capacity);
+}
+
+ml_ring *ml_ring_init(void *region, size_t region_size) {
+    if (region == NULL || ((uintptr_t)region % CACHE_LINE) != 0 || region_size < ml_ring_region_size(0)) {
+        return NULL;
+    }
+    // Largest power of two that fits after the header (record lengths are 32-bit)
+    size_t capacity = MIN_CAPACITY;
+    while (sizeof(ml_ring) + capacity * 2 <= region_size && capacity * 2 <= UINT32_MAX) {
+        capacity *= 2;
+    }
+
+    ml_ring *ring = region;
+    memset(ring, 0, sizeof(*ring));
+    ring->capacity = capacity;
+    ring->mask = capacity - 1;
+    atomic_store_explicit(&ring->head, 0, memory_order_relaxed);
+    atomic_store_explicit(&ring->tail, 0, memory_order_relaxed);
+    atomic_store_explicit(&ring->closed, 0, memory_order_relaxed);
+    // Publish the header last so an attaching process never sees half of it
+    __atomic_store_n(&ring->magic, RING_MAGIC, __ATOMIC_RELEASE);
+    return ring;
+}
+
+ml_ring *ml_ring_attach(void *region) {
+    ml_ring *ring = region;
+    if (ring == NULL || __atomic_load_n(&ring->magic, __ATOMIC_ACQUIRE) != RING_MAGIC) {
+        return NULL;
+    }
+    return ring;
+}
+
+ml_ring *ml_ring_create(size_t capacity) {
+    if (capacity == 0) {
+        capacity = ML_RING_DEFAULT_CAPACITY;
+        while (capacity > MIN_CAPACITY && capacity > ml_mem_available() / 4) {
+            capacity /= 2;  // a quarter of what a --max-mem budget has left
+        }
+    }
+    size_t size = ml_ring_region_size(capacity);
+    void *region = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (region == MAP_FAILED) {
+        return NULL;
+    }
+    ml_ring *ring = ml_ring_init(region, size);
+    ring->mapped_size = size;
+    ml_mem_charge(size);
+    return ring;
+}
+
+void ml_ring_destroy(ml_ring *ring) {
+    if (ring != NULL && ring->mapped_size != 0) {
+        ml_mem_release(ring->mapped_size);
+        munmap(ring, ring->mapped_size);
+    }
+}
+
+size_t ml_ring_max_record(const ml_ring *ring) {
+    return (size_t)ring->capacity - HEADER_SIZE;
+}
+
+// ============================================================================
+// PRODUCER
+// ============================================================================
+
+/**
+ * @return Non-zero if `size` more bytes fit after `head` (refreshing the
+ *         cached tail only when the cached one says no)
+ */
+static int has_room(ml_ring *ring, uint64_t head, uint64_t size) {
+    if (head + size - ring->tail_cache <= ring->capacity) {
+        return 1;
+    }
+    ring->tail_cache = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    return head + size - ring->tail_cache <= ring->capacity;
+}
+
+void *ml_ring_reserve(ml_ring *ring, size_t len) {
+    if (len > ml_ring_max_record(ring)) {
+        return NULL;
+    }
+    uint64_t size = padded(len);
+    uint64_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint64_t contiguous = ring->capacity - (head & ring->mask);
+
+    if (size > contiguous) {
+        // Publish a padding record up to the end now, so the consumer frees
+        // it and the whole area becomes usable from offset 0
+        if (!has_room(ring, head, contiguous)) {
+            return NULL;
+        }
+        record_header pad = {(uint32_t)(contiguous - HEADER_SIZE), PAD_FLAG};
+        memcpy(ring->data + (head & ring->mask), &pad, sizeof(pad));
+        head += contiguous;
+        atomic_store_explicit(&ring->head, head, memory_order_release);
+    }
+    if (!has_room(ring, head, size)) {
+        return NULL;
+    }
+    ring->reserved = head;
+    return ring->data + (head & ring->mask) + HEADER_SIZE;
+}
+
+void *ml_ring_reserve_wait(ml_ring *ring, size_t len) {
+    if (len > ml_ring_max_record(ring)) {
+        return NULL;
+    }
+    unsigned round = 0;
+    void *p;
+    while ((p = ml_ring_reserve(ring, len)) == NULL) {
+        backoff(&round);
+    }
+    return p;
+}
+
+void ml_ring_commit(ml_ring *ring, size_t len) {
+    if (len == 0) {
+        return;
+    }
+    record_header header = {(uint32_t)len, 0};
+    memcpy(ring->data + (ring->reserved & ring->mask), &header, sizeof(header));
+    atomic_store_explicit(&ring->head, ring->reserved + padded(len), memory_order_release);
+}
+
+void ml_ring_close(ml_ring *ring) {
+    atomic_store_explicit(&ring->closed, 1, memory_order_release);
+}
+
+// ============================================================================
+// CONSUMER
+// ============================================================================
+
+const void *ml_ring_peek(ml_ring *ring, size_t *len) {
+    uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    for (;;) {
+        if (tail == ring->head_cache) {
+            ring->head_cache = atomic_load_explicit(&ring->head, memory_order_acquire);
+            if (tail == ring->head_cache) {
+                return NULL;
+            }
+        }
+        record_header header;
+        memcpy(&header, ring->data + (tail & ring->mask), sizeof(header));
+        if (header.flags & PAD_FLAG) {
+            tail += HEADER_SIZE + header.len;
+            atomic_store_explicit(&ring->tail, tail, memory_order_release);
+            continue;
+        }
+        ring->peeked_size = padded(header.len);
+        *len = header.len;
+        return ring->data + (tail & ring->mask) + HEADER_SIZE;
+    }
+}
+
+const void *ml_ring_peek_wait(ml_ring *ring, size_t *len) {
+    unsigned round = 0;
+    for (;;) {
+        const void *p = ml_ring_peek(ring, len);
+        if (p != NULL) {
+            return p;
+        }
+        if (atomic_load_explicit(&ring->closed, memory_order_acquire)) {
+            // Records committed before the close are visible now
+            return ml_ring_peek(ring, len);
+        }
+        backoff(&round);
+    }
+}
+
+void ml_ring_release(ml_ring *ring) {
+    uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    atomic_store_explicit(&ring->tail, tail + ring->peeked_size, memory_order_release);
+    ring->peeked_size = 0;
+}
+
+int ml_ring_is_closed(const ml_ring *ring) {
+    return (int)atomic_load_explicit(&((ml_ring *)ring)->closed, memory_order_acquire);
+}
@@ -0,0 +1,205 @@
+#ifndef MULTILANG_SPSC_RING_H
+#define MULTILANG_SPSC_RING_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ============================================================================
+// SINGLE-PRODUCER/SINGLE-CONSUMER SHARED-MEMORY RING (C ABI, used by C, C++ and Rust)
+// ============================================================================
+// Moves variable-length records (a batch of names, a block of greetings)
+// from exactly one producer to exactly one consumer, which may be different
+// threads or different processes mapping the same memory. The producer
+// writes a record in place and publishes it with one release store; the
+// consumer reads it in place and frees it with one release store. There are
+// no locks and no per-name calls.
+//
+//   producer:  void *p = ml_ring_reserve(ring, n);   // NULL: full, try later
+//              ...fill p[0, used)...
+//              ml_ring_commit(ring, used);           // used <= n
+//
+//   consumer:  const void *p = ml_ring_peek(ring, &len);  // NULL: empty
+//              ...read p[0, len)...
+//              ml_ring_release(ring);
+//
+// reserve/commit/peek/release are wait-free. The *_wait variants spin, then
+// yield, then sleep briefly when the other side is behind.
+//
+// Layout: the header holds the producer's and the consumer's state on
+// separate cache lines (each side also caches the other's index there, so
+// the fast path touches no line the other side writes), followed by the
+// power-of-two data area. Records are 8-byte aligned; one that does not fit
+// before the end of the area is preceded by a padding record and starts
+// again at offset 0.
+//
+// Batch records exchanged with the language backends (greet_ring_cpp(),
+// greet_ring_rust()) are plain text: names each terminated by '\n' going
+// in, formatted greetings coming back.
+
+#define ML_RING_DEFAULT_CAPACITY (4u << 20)  // 4 MiB data area
+
+typedef struct ml_ring ml_ring;
+
+/**
+ * @return Bytes of memory a ring with `capacity` data bytes occupies
+ *         (capacity is rounded up to a power of two, at least 4 KiB)
+ */
+size_t ml_ring_region_size(size_t capacity);
+
+/**
+ * Formats a ring in caller-provided memory, e.g. a shm_open()/mmap() region
+ * another process maps too. `region` must be 64-byte aligned.
+ *
+ * @return The ring (== region), or NULL if `region_size` is too small
+ */
+ml_ring *ml_ring_init(void *region, size_t region_size);
+
+/**
+ * Uses a ring another process already formatted with ml_ring_init()
+ *
+ * @return The ring, or NULL if `region` does not hold one
+ */
+ml_ring *ml_ring_attach(void *region);
+
+/**
+ * Creates a ring in an anonymous shared mapping: usable across threads and
+ * inherited by fork()ed children
+ *
+ * @param capacity Data bytes (0 selects ML_RING_DEFAULT_CAPACITY, or less
+ *                 under a --max-mem budget, see mem_budget.h)
+ * @return Ring handle, or NULL if mapping failed
+ */
+ml_ring *ml_ring_create(size_t capacity);
+
+/**
+ * Unmaps a ring made with ml_ring_create()
+ */
+void ml_ring_destroy(ml_ring *ring);
+
+/**
+ * @return Largest record the ring accepts
+ */
+size_t ml_ring_max_record(const ml_ring *ring);
+
+// ---------------------------------------------------------------- producer
+
+/**
+ * Reserves room for a record of up to `len` bytes
+ *
+ * @return Where to write it, or NULL if the ring is too full right now
+ *         (or len > ml_ring_max_record())
+ */
+void *ml_ring_reserve(ml_ring *ring, size_t len);
+
+/**
+ * Like ml_ring_reserve(), but waits for the consumer to make room
+ *
+ * @return NULL only if len > ml_ring_max_record()
+ */
+void *ml_ring_reserve_wait(ml_ring *ring, size_t len);
+
+/**
+ * Publishes the reserved record with its final length (<= the reserved one).
+ * A length of 0 cancels the reservation: records are never empty.
+ */
+void ml_ring_commit(ml_ring *ring, size_t len);
+
+/**
+ * Marks the end of the stream; the consumer sees it after the last record
+ */
+void ml_ring_close(ml_ring *ring);
+
+// ---------------------------------------------------------------- consumer
+
+/**
+ * @param len Set to the length of the record
+ * @return The oldest unreleased record, or NULL if none is available yet
+ */
+const void *ml_ring_peek(ml_ring *ring, size_t *len);
+
+/**
+ * Like ml_ring_peek(), but waits for the producer
+ *
+ * @return NULL once the ring is closed and every record was released
+ */
+const void *ml_ring_peek_wait(ml_ring *ring, size_t *len);
+
+/**
+ * Frees the record returned by the last peek
+ */
+void ml_ring_release(ml_ring *ring);
+
+/**
+ * @return Non-zero once the producer closed the ring (records may remain)
+ */
+int ml_ring_is_closed(const ml_ring *ring);
+
+#ifdef __cplusplus
+}
+
+// C++-only interface: typed views over ring records
+#include <span>
+namespace MlRing {
+
+    /**
+     * @brief Producer end of a ring (does not own it)
+     *
+     * Example usage (C++ only):
+     *   MlRing::Writer out(ring);
+     *   std::span<char> room = out.reserve(64 * 1024);
+     *   out.commit(fill(room));
+     */
+    class Writer {
+    public:
+        explicit Writer(ml_ring *ring) : ring_(ring) {}
+
+        // Waits for room; an empty span only if `len` is too large
+        std::span<char> reserve(size_t len) {
+            void *p = ml_ring_reserve_wait(ring_, len);
+            return p != nullptr ? std::span<char>(static_cast<char*>(p), len) : std::span<char>();
+        }
+
+        void commit(size_t len) { ml_ring_commit(ring_, len); }
+        void close() { ml_ring_close(ring_); }
+        size_t max_record() const { return ml_ring_max_record(ring_); }
+
+    private:
+        ml_ring *ring_;
+    };
+
+    /**
+     * @brief Consumer end of a ring (does not own it)
+     *
+     * Example usage (C++ only):
+     *   MlRing::Reader in(ring);
+     *   for (auto rec = in.next(); !rec.empty(); rec = in.next()) {
+     *       use(rec);   // valid until the next call to next()
+     *   }
+     */
+    class Reader {
+    public:
+        explicit Reader(ml_ring *ring) : ring_(ring) {}
+
+        // Releases the previous record; an empty span once the ring is closed and drained
+        std::span<const char> next() {
+            if (holding_) {
+                ml_ring_release(ring_);
+            }
+            size_t len = 0;
+            const void *p = ml_ring_peek_wait(ring_, &len);
+            holding_ = p != nullptr;
+            return holding_ ? std::span<const char>(static_cast<const char*>(p), len)
+                            : std::span<const char>();
+        }
+
+    private:
+        ml_ring *ring_;
+        bool holding_ = false;
+    };
+}
+#endif
+
+#endif //MULTILANG_SPSC_RING_H
@@ -1,35 +1,458 @@
 
-use std::io::{self, Write};
+use std::cell::RefCell;
+use std::io::{self, BufRead};
 use std::ffi::CStr;
 use std::os::raw::c_char;
 
+// Shared scanning kernels from line_scan.h, so Rust splits and trims exactly
+// like C and C++
+extern "C" {
+    fn ml_find_newline(data: *const u8, len: usize) -> usize;
+    fn ml_trim(data: *mut *const u8, len: *mut usize);
+    fn ml_normalize(data: *mut u8, len: usize) -> usize;
+}
+
+// Reader flag from name_batch.h, keep in sync
+const ML_BATCH_NORMALIZE: u32 = 0x8;
+
+// Normalizes `name` in place (see ml_normalize in line_scan.h) and returns
+// the normalized part of it
+fn normalize_bytes(name: &mut [u8]) -> &mut [u8] {
+    let len = unsafe { ml_normalize(name.as_mut_ptr(), name.len()) };
+    &mut name[..len]
+}
+
+// UTF-8 rules from utf8_scan.h: truncation never splits a character
+extern "C" {
+    fn ml_utf8_truncate(data: *const u8, len: usize, max: usize) -> usize;
+}
+
+fn utf8_truncate(bytes: &[u8], max: usize) -> usize {
+    unsafe { ml_utf8_truncate(bytes.as_ptr(), bytes.len(), max) }
+}
+
+// Shared output sink from output_sink.h: Rust output goes into the same
+// buffer as the C and C++ greetings instead of Rust's own stdout
+#[repr(C)]
+struct MlSink {
+    _private: [u8; 0],
+}
+
+extern "C" {
+    fn ml_stdout_sink() -> *mut MlSink;
+    fn ml_sink_write(sink: *mut MlSink, data: *const u8, len: usize) -> i32;
+    fn ml_sink_flush(sink: *mut MlSink) -> i32;
+}
+
+// Shared greeting formatter from greeting_format.h: the prefix and suffix
+// live in one compile-time table with the C and C++ ones
+const ML_GREETING_RUST: i32 = 2; // ml_greeting_style value, keep in sync
+
+extern "C" {
+    fn ml_greeting_format(style: i32, name: *const u8, len: usize, out: *mut u8, cap: usize) -> usize;
+    fn ml_greeting_write(sink: *mut MlSink, style: i32, name: *const u8, len: usize) -> i32;
+}
+
+// Per-implementation counters from ml_stats.h
+const ML_STATS_ASK_NAME_RUST: i32 = 9; // ml_stats_entry value, keep in sync
+
+extern "C" {
+    fn ml_stats_begin() -> u64;
+    fn ml_stats_end(entry: i32, start: u64, bytes_read: usize, bytes_copied: usize);
+    fn ml_stats_alloc(entry: i32, bytes: usize);
+}
+
+// Process-wide memory budget from mem_budget.h (--max-mem)
+extern "C" {
+    fn ml_mem_try_grow(old_cap: usize, new_cap: usize) -> i32;
+}
+
+fn trim_bytes(line: &[u8]) -> &[u8] {
+    let mut data = line.as_ptr();
+    let mut len = line.len();
+    unsafe {
+        ml_trim(&mut data, &mut len);
+        std::slice::from_raw_parts(data, len)
+    }
+}
+
+// Per-thread input state shared by ask_name_rust and ask_names_rust_batch.
+//
+// The stdin lock is taken once and held for the life of the thread, so no
+// call pays for locking, and `line` is reused so a call only allocates when
+// a name is longer than any seen before. Rust input must therefore stay on
+// one thread; another thread calling io::stdin() would block.
+struct RustInput {
+    lock: io::StdinLock<'static>,
+    line: Vec<u8>,     // names that span a refill of the stdin buffer
+    pending: bool,     // `line` holds a name the last batch had no room for
+    eof: bool,         // a read found the end of stdin
+}
+
+thread_local! {
+    static INPUT: RefCell<Option<RustInput>> = RefCell::new(None);
+}
+
+fn with_input<R, F: FnOnce(&mut RustInput) -> R>(f: F) -> R {
+    INPUT.with(|cell| {
+        let mut slot = cell.borrow_mut();
+        let input = slot.get_or_insert_with(|| RustInput {
+            lock: io::stdin().lock(),
+            line: Vec::new(),
+            pending: false,
+            eof: false,
+        });
+        f(input)
+    })
+}
+
+// Appends `bytes` to `line`, growing it only within the memory budget.
+// Returns false if it had to cut them at the last whole character that fits.
+fn append_line(line: &mut Vec<u8>, bytes: &[u8]) -> bool {
+    let needed = line.len() + bytes.len();
+    let capacity = line.capacity();
+    if needed > capacity {
+        let grow = std::cmp::max(needed, capacity * 2) - capacity;
+        if unsafe { ml_mem_try_grow(capacity, capacity + grow) } != 0 {
+            let keep = utf8_truncate(bytes, capacity - line.len());
+            line.extend_from_slice(&bytes[..keep]);
+            return false;
+        }
+        let len = line.len();
+        line.reserve_exact(capacity + grow - len);
+    }
+    line.extend_from_slice(bytes);
+    true
+}
+
+// Reads the next line, without its newline, into `input.line`; a line that
+// does not fit the memory budget is cut and the rest of it skipped.
+// Returns the bytes consumed from stdin (0 at end of input).
+fn read_line(input: &mut RustInput) -> io::Result<usize> {
+    input.line.clear();
+    let mut consumed = 0;
+    let mut cut = false;
+    loop {
+        let (used, done) = {
+            let available = input.lock.fill_buf()?;
+            if available.is_empty() {
+                return Ok(consumed);
+            }
+            let pos = unsafe { ml_find_newline(available.as_ptr(), available.len()) };
+            let end = if pos < available.len() { pos } else { available.len() };
+            if !cut {
+                cut = !append_line(&mut input.line, &available[..end]);
+            }
+            if pos < available.len() {
+                (pos + 1, true)
+            } else {
+                (available.len(), false)
+            }
+        };
+        input.lock.consume(used);
+        consumed += used;
+        if done {
+            return Ok(consumed);
+        }
+    }
+}
+
 #[no_mangle]
 pub extern "C" fn ask_name_rust(name: *mut c_char, size: usize) {
-    print!("Enter your name (Rust version): ");
-    io::stdout().flush().unwrap();
+    let stats_start = unsafe { ml_stats_begin() };
+    let mut bytes_read = 0;
+    let mut bytes_copied = 0;
+
+    let prompt = "Enter your name (Rust version): ";
+    unsafe {
+        // Flush so the prompt is visible before we block on stdin
+        let sink = ml_stdout_sink();
+        ml_sink_write(sink, prompt.as_ptr(), prompt.len());
+        ml_sink_flush(sink);
+    }
 
-    let mut input = String::new();
-    match io::stdin().read_line(&mut input) {
-        Ok(_) => {
-            let trimmed = input.trim();
-            let bytes_to_copy = std::cmp::min(trimmed.len(), size - 1);
+    with_input(|input| {
+        let capacity = input.line.capacity();
+        let result = if input.pending {
+            input.pending = false;
+            Ok(input.line.len() + 1)
+        } else {
+            read_line(input)
+        };
+        if input.line.capacity() > capacity {
+            unsafe { ml_stats_alloc(ML_STATS_ASK_NAME_RUST, input.line.capacity() - capacity); }
+        }
 
-            unsafe {
-                std::ptr::copy_nonoverlapping(
-                    trimmed.as_ptr(),
-                    name as *mut u8,
-                    bytes_to_copy
-                );
-                *name.add(bytes_to_copy) = 0; // Null terminator
+        match result {
+            Ok(0) => {
+                // End of input: like the C versions, no greeting
+                input.eof = true;
+                unsafe {
+                    *name = 0;
+                }
             }
+            Ok(n) => {
+                let trimmed = trim_bytes(&input.line);
+                let bytes_to_copy = utf8_truncate(trimmed, size - 1);
+                bytes_read = n;
+                bytes_copied = bytes_to_copy + 1;
+
+                unsafe {
+                    std::ptr::copy_nonoverlapping(
+                        trimmed.as_ptr(),
+                        name as *mut u8,
+                        bytes_to_copy
+                    );
+                    *name.add(bytes_to_copy) = 0; // Null terminator
+                }
 
-            println!("Hello from Rust, {}!", trimmed);
+                unsafe {
+                    ml_greeting_write(ml_stdout_sink(), ML_GREETING_RUST, trimmed.as_ptr(), trimmed.len());
+                }
+            }
+            Err(e) => {
+                eprintln!("Error reading input: {}", e);
+                unsafe {
+                    *name = 0; // Empty string on error
+                }
+            }
         }
-        Err(e) => {
-            eprintln!("Error reading input: {}", e);
-            unsafe {
-                *name = 0; // Empty string on error
+    });
+
+    unsafe {
+        ml_stats_end(ML_STATS_ASK_NAME_RUST, stats_start, bytes_read, bytes_copied);
+    }
+}
+
+// Non-zero once ask_name_rust found the end of stdin (the Rust runtime owns
+// that buffer, so C cannot ask feof(stdin))
+#[no_mangle]
+pub extern "C" fn ask_name_rust_eof() -> i32 {
+    with_input(|input| input.eof as i32)
+}
+
+// Destination of one ask_names_rust_batch call
+struct BatchOut {
+    buf: *mut u8,
+    cap: usize,
+    used: usize,
+    offsets: *mut usize,
+    max: usize,
+    count: usize,
+    normalize: bool,
+}
+
+impl BatchOut {
+    // Appends `name` plus a NUL terminator. Returns false if it does not fit;
+    // the first name of a batch is truncated instead so every call progresses.
+    fn push(&mut self, name: &[u8]) -> bool {
+        let room = self.cap - self.used;
+        let len = if name.len() < room {
+            name.len()
+        } else if self.count == 0 && room > 0 {
+            utf8_truncate(name, room - 1)
+        } else {
+            return false;
+        };
+        let len = unsafe {
+            let dest = std::slice::from_raw_parts_mut(self.buf.add(self.used), len);
+            dest.copy_from_slice(&name[..len]);
+            if self.normalize {
+                normalize_bytes(dest).len() // while the copy is still in cache
+            } else {
+                len
+            }
+        };
+        unsafe {
+            *self.buf.add(self.used + len) = 0;
+            *self.offsets.add(self.count) = self.used;
+        }
+        self.used += len + 1;
+        self.count += 1;
+        true
+    }
+
+    fn full(&self) -> bool {
+        self.count == self.max
+    }
+}
+
+// Reads as many names as fit into `buf` (NUL-terminated, back to back) in one
+// FFI call, without prompts or greetings. `offsets` must have room for
+// max + 1 entries: offsets[i] is where name i starts and offsets[count] is
+// the end of the used part of `buf`, so name i is
+// offsets[i + 1] - offsets[i] - 1 bytes long. Names are trimmed like
+// ask_name_rust's; a name that does not fit is kept for the next call.
+// Returns the number of names, 0 at end of input.
+#[no_mangle]
+pub extern "C" fn ask_names_rust_batch(buf: *mut c_char, cap: usize, offsets: *mut usize, max: usize) -> usize {
+    ask_names_rust_batch_flags(buf, cap, offsets, max, 0)
+}
+
+// ask_names_rust_batch with ML_BATCH_* reader flags: ML_BATCH_NORMALIZE
+// normalizes every name in `buf` right after it is copied; the other flags
+// are ignored (names are always trimmed)
+#[no_mangle]
+pub extern "C" fn ask_names_rust_batch_flags(buf: *mut c_char, cap: usize, offsets: *mut usize, max: usize,
+                                             flags: u32) -> usize {
+    if buf.is_null() || offsets.is_null() || cap == 0 || max == 0 {
+        return 0;
+    }
+    let mut out = BatchOut {
+        buf: buf as *mut u8,
+        cap: cap,
+        used: 0,
+        offsets: offsets,
+        max: max,
+        count: 0,
+        normalize: flags & ML_BATCH_NORMALIZE != 0,
+    };
+
+    with_input(|input| {
+        loop {
+            if out.full() {
+                break;
+            }
+            if input.pending {
+                if !out.push(trim_bytes(&input.line)) {
+                    break;
+                }
+                input.pending = false;
+                continue;
+            }
+
+            // Split every complete line already sitting in the stdin buffer
+            // straight into `buf`; only a line cut by the buffer end goes
+            // through `input.line`
+            let (used, stopped, at_end) = {
+                let available = match input.lock.fill_buf() {
+                    Ok(available) => available,
+                    Err(e) => {
+                        eprintln!("Error reading input: {}", e);
+                        break;
+                    }
+                };
+                let mut off = 0;
+                let mut stopped = false;
+                while !out.full() {
+                    let rest = &available[off..];
+                    let pos = unsafe { ml_find_newline(rest.as_ptr(), rest.len()) };
+                    if pos == rest.len() {
+                        break;
+                    }
+                    if !out.push(trim_bytes(&rest[..pos])) {
+                        stopped = true;
+                        break;
+                    }
+                    off += pos + 1;
+                }
+                (off, stopped, available.is_empty())
+            };
+            input.lock.consume(used);
+            if stopped || at_end {
+                break;
+            }
+
+            if used == 0 && !out.full() {
+                match read_line(input) {
+                    Ok(0) => break,
+                    Ok(_) => input.pending = true,
+                    Err(e) => {
+                        eprintln!("Error reading input: {}", e);
+                        break;
+                    }
+                }
+            }
+        }
+    });
+
+    unsafe {
+        *offsets.add(out.count) = out.used;
+    }
+    out.count
+}
+
+// Greeting logic of ask_name_rust without any I/O: trims `name` and writes
+// "Hello from Rust, <name>!\n" into `out`. Returns the byte count, or 0 if
+// `out` is too small.
+fn format_greeting(name: &[u8], out: &mut [u8]) -> usize {
+    let name = trim_bytes(name);
+    unsafe { ml_greeting_format(ML_GREETING_RUST, name.as_ptr(), name.len(), out.as_mut_ptr(), out.len()) }
+}
+
+// Greeting logic of ask_name_rust without any I/O, for the pipeline workers.
+// Writes "Hello from Rust, <name>!\n" into `out` and returns the byte count,
+// or 0 if `cap` is too small.
+#[no_mangle]
+pub extern "C" fn greet_name_rust(name: *const c_char, len: usize, out: *mut c_char, cap: usize) -> usize {
+    if out.is_null() {
+        return 0;
+    }
+    unsafe {
+        let name = std::slice::from_raw_parts(name as *const u8, len);
+        let out = std::slice::from_raw_parts_mut(out as *mut u8, cap);
+        format_greeting(name, out)
+    }
+}
+
+// Shared-memory rings from spsc_ring.h
+#[repr(C)]
+pub struct MlRing {
+    _private: [u8; 0],
+}
+
+extern "C" {
+    fn ml_ring_reserve_wait(ring: *mut MlRing, len: usize) -> *mut u8;
+    fn ml_ring_commit(ring: *mut MlRing, len: usize);
+    fn ml_ring_close(ring: *mut MlRing);
+    fn ml_ring_peek_wait(ring: *mut MlRing, len: *mut usize) -> *const u8;
+    fn ml_ring_release(ring: *mut MlRing);
+    fn ml_ring_max_record(ring: *const MlRing) -> usize;
+}
+
+// Backend half of the ring hand-off, like greet_ring_cpp: reads batches of
+// '\n'-terminated names from `names` in place and formats their greetings in
+// place into records of `greetings`, then closes `greetings`. Returns the
+// number of names greeted.
+#[no_mangle]
+pub extern "C" fn greet_ring_rust(names: *mut MlRing, greetings: *mut MlRing) -> usize {
+    const RECORD_BYTES: usize = 64 * 1024;
+    const GREETING_OVERHEAD: usize = 32; // prefix + suffix, with room to spare
+
+    let mut total = 0;
+    unsafe {
+        let max_record = ml_ring_max_record(greetings);
+        let record_bytes = RECORD_BYTES.min(max_record / 2); // small rings (--max-mem) take smaller records
+        loop {
+            let mut len = 0;
+            let data = ml_ring_peek_wait(names, &mut len);
+            if data.is_null() {
+                break;
+            }
+            let batch = std::slice::from_raw_parts(data, len);
+
+            let mut cap = record_bytes;
+            let mut room = std::slice::from_raw_parts_mut(ml_ring_reserve_wait(greetings, cap), cap);
+            let mut used = 0;
+            let mut pos = 0;
+            while pos < batch.len() {
+                let rest = &batch[pos..];
+                let name_len = ml_find_newline(rest.as_ptr(), rest.len());
+                let need = (name_len + GREETING_OVERHEAD).min(max_record);
+                if need > cap - used {
+                    ml_ring_commit(greetings, used);
+                    cap = record_bytes.max(need); // a long name gets its own record
+                    room = std::slice::from_raw_parts_mut(ml_ring_reserve_wait(greetings, cap), cap);
+                    used = 0;
+                }
+                used += format_greeting(&rest[..name_len], &mut room[used..]);
+                total += 1;
+                pos += name_len + 1;
             }
+            ml_ring_commit(greetings, used);
+            ml_ring_release(names);
         }
+        ml_ring_close(greetings);
     }
+    total
 }
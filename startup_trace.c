@@ -0,0 +1,61 @@
+#include "startup_trace.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+typedef struct {
+    uint64_t cpu_ns;
+    uint64_t wall_ns;
+    int seen;
+} milestone;
+
+static const char *const EVENT_NAMES[ML_STARTUP_EVENT_COUNT] = {
+    "main",
+    "banner",
+    "first prompt",
+};
+
+static uint64_t origin_ns;  // wall clock at the first static initializer
+static milestone milestones[ML_STARTUP_EVENT_COUNT];
+static int report_registered = 0;
+
+static uint64_t read_clock(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+// Priority 101 runs before every default-priority initializer of the binary
+__attribute__((constructor(101)))
+static void record_origin(void) {
+    origin_ns = read_clock(CLOCK_MONOTONIC);
+}
+
+void ml_startup_mark(ml_startup_event event) {
+    if ((unsigned)event >= ML_STARTUP_EVENT_COUNT || milestones[event].seen) {
+        return;
+    }
+    milestones[event].cpu_ns = read_clock(CLOCK_PROCESS_CPUTIME_ID);
+    milestones[event].wall_ns = read_clock(CLOCK_MONOTONIC) - origin_ns;
+    milestones[event].seen = 1;
+}
+
+static void print_report(void) {
+    fprintf(stderr, "Startup trace:         cpu ms   wall ms\n");
+    for (int i = 0; i < ML_STARTUP_EVENT_COUNT; i++) {
+        if (milestones[i].seen) {
+            fprintf(stderr, "  %-16s %10.3f %9.3f\n", EVENT_NAMES[i],
+                    (double)milestones[i].cpu_ns / 1e6, (double)milestones[i].wall_ns / 1e6);
+        } else {
+            fprintf(stderr, "  %-16s %10s %9s\n", EVENT_NAMES[i], "-", "-");
+        }
+    }
+}
+
+void ml_startup_trace_enable(void) {
+    if (!report_registered) {
+        report_registered = 1;
+        atexit(print_report);
+    }
+}
@@ -0,0 +1,43 @@
+#ifndef MULTILANG_STARTUP_TRACE_H
+#define MULTILANG_STARTUP_TRACE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ============================================================================
+// STARTUP TRACE (--startup-trace)
+// ============================================================================
+// Records when start-up milestones are reached, for short-lived runs where
+// start-up is most of the wall-clock time. Each milestone keeps two clocks:
+//
+//   cpu   process CPU time since exec: covers the dynamic loader and every
+//         static initializer, which run before any code of ours can read a
+//         wall clock
+//   wall  wall-clock time since this binary's first static initializer
+//
+// Marking is two clock reads, so milestones are always recorded; the
+// report is only printed (to stderr, at exit) once tracing is enabled.
+
+typedef enum {
+    ML_STARTUP_MAIN = 0,      // main() entered
+    ML_STARTUP_BANNER,        // banner written
+    ML_STARTUP_FIRST_PROMPT,  // first ask_name_* about to prompt
+    ML_STARTUP_EVENT_COUNT
+} ml_startup_event;
+
+/**
+ * Records `event` (only its first occurrence counts)
+ */
+void ml_startup_mark(ml_startup_event event);
+
+/**
+ * Prints the recorded milestones to stderr when the process exits
+ */
+void ml_startup_trace_enable(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //MULTILANG_STARTUP_TRACE_H
@@ -0,0 +1,407 @@
+#include "utf8_scan.h"
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define ML_UTF8_X86 1
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#define ML_UTF8_NEON 1
+#include <arm_neon.h>
+#endif
+
+// Runtime-dispatched UTF-8 validators
+//
+// Every kernel answers the same question -- the length of the longest
+// well-formed prefix -- and hands the exact error position to the scalar
+// decoder, so all of them return identical results.
+
+typedef struct {
+    const char *name;
+    size_t (*valid_prefix)(const unsigned char *data, size_t len);
+} utf8_kernels;
+
+// ============================================================================
+// SCALAR
+// ============================================================================
+
+/**
+ * Describes the sequence a lead byte starts (Unicode Table 3-7)
+ *
+ * @param lo, hi Allowed range of the second byte
+ * @return Sequence length, or 0 if `c` cannot start a sequence
+ */
+static size_t lead_info(unsigned char c, unsigned char *lo, unsigned char *hi) {
+    *lo = 0x80;
+    *hi = 0xBF;
+    if (c >= 0xC2 && c <= 0xDF) {
+        return 2;
+    }
+    if (c >= 0xE0 && c <= 0xEF) {
+        *lo = c == 0xE0 ? 0xA0 : 0x80;  // overlong
+        *hi = c == 0xED ? 0x9F : 0xBF;  // surrogates
+        return 3;
+    }
+    if (c >= 0xF0 && c <= 0xF4) {
+        *lo = c == 0xF0 ? 0x90 : 0x80;  // overlong
+        *hi = c == 0xF4 ? 0x8F : 0xBF;  // above U+10FFFF
+        return 4;
+    }
+    return 0;
+}
+
+/**
+ * @return Length of the well-formed sequence starting at s[0], or 0 if it
+ *         is ill-formed or cut off by `len`
+ */
+static size_t sequence_length(const unsigned char *s, size_t len) {
+    if (s[0] < 0x80) {
+        return 1;
+    }
+    unsigned char lo;
+    unsigned char hi;
+    size_t n = lead_info(s[0], &lo, &hi);
+    if (n == 0 || len < n || s[1] < lo || s[1] > hi) {
+        return 0;
+    }
+    for (size_t k = 2; k < n; k++) {
+        if ((s[k] & 0xC0) != 0x80) {
+            return 0;
+        }
+    }
+    return n;
+}
+
+/**
+ * Validates s[start, len), where `start` is a character boundary
+ */
+static size_t validate_from(const unsigned char *s, size_t start, size_t len) {
+    size_t i = start;
+    while (i < len) {
+        // Eight ASCII bytes at a time: the common case for names
+        if (i + 8 <= len) {
+            uint64_t word;
+            memcpy(&word, s + i, sizeof(word));
+            if ((word & 0x8080808080808080ull) == 0) {
+                i += 8;
+                continue;
+            }
+        }
+        size_t n = sequence_length(s + i, len - i);
+        if (n == 0) {
+            return i;
+        }
+        i += n;
+    }
+    return len;
+}
+
+static size_t valid_prefix_scalar(const unsigned char *data, size_t len) {
+    return validate_from(data, 0, len);
+}
+
+static const utf8_kernels SCALAR_KERNELS = {"scalar", valid_prefix_scalar};
+
+/**
+ * @return The start of the character that contains, or directly follows,
+ *         s[i - 1] (everything before `i` is known to be well-formed)
+ */
+static size_t boundary_before(const unsigned char *s, size_t i) {
+    size_t j = i;
+    while (j > 0 && i - j < 3 && (s[j - 1] & 0xC0) == 0x80) {
+        j--;
+    }
+    if (j > 0 && s[j - 1] >= 0xC0) {
+        j--;
+    }
+    return j;
+}
+
+#if ML_UTF8_X86
+
+// ============================================================================
+// SSE2 (ASCII fast path)
+// ============================================================================
+
+static size_t valid_prefix_sse2(const unsigned char *data, size_t len) {
+    size_t i = 0;
+    while (i + 16 <= len) {
+        unsigned high = (unsigned)_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)(data + i)));
+        if (high == 0) {
+            i += 16;
+            continue;
+        }
+        // Decode the non-ASCII run, then go back to vector steps
+        i += (size_t)__builtin_ctz(high);
+        while (i < len && data[i] >= 0x80) {
+            size_t n = sequence_length(data + i, len - i);
+            if (n == 0) {
+                return i;
+            }
+            i += n;
+        }
+    }
+    return validate_from(data, i, len);
+}
+
+static const utf8_kernels SSE2_KERNELS = {"sse2", valid_prefix_sse2};
+
+// ============================================================================
+// AVX2 (lookup-table validation, selected at runtime)
+// ============================================================================
+
+#define ML_AVX2 __attribute__((target("avx2")))
+
+// Error classes; a byte pair is invalid when all three of its lookups
+// (first byte high nibble, first byte low nibble, second byte high nibble)
+// share a class.
+#define TOO_SHORT      0x01  // lead byte followed by a non-continuation
+#define TOO_LONG       0x02  // ASCII followed by a continuation
+#define OVERLONG_3     0x04
+#define TOO_LARGE      0x08
+#define SURROGATE      0x10
+#define OVERLONG_2     0x20
+#define TOO_LARGE_1000 0x40
+#define OVERLONG_4     0x40
+#define TWO_CONTS      0x80  // continuation after continuation (checked below)
+#define CARRY          (TOO_SHORT | TOO_LONG | TWO_CONTS)
+
+#define LOOKUP16(a, b, c, d, e, f, g, h, i, j, k, l, m, n, o, p)                 \
+    _mm256_setr_epi8((char)(a), (char)(b), (char)(c), (char)(d), (char)(e),     \
+                     (char)(f), (char)(g), (char)(h), (char)(i), (char)(j),     \
+                     (char)(k), (char)(l), (char)(m), (char)(n), (char)(o),     \
+                     (char)(p), (char)(a), (char)(b), (char)(c), (char)(d),     \
+                     (char)(e), (char)(f), (char)(g), (char)(h), (char)(i),     \
+                     (char)(j), (char)(k), (char)(l), (char)(m), (char)(n),     \
+                     (char)(o), (char)(p))
+
+ML_AVX2 static inline __m256i high_nibbles(__m256i v) {
+    return _mm256_and_si256(_mm256_srli_epi16(v, 4), _mm256_set1_epi8(0x0F));
+}
+
+// Bytes of `input` shifted right by N, filled from the end of `prev`
+#define PREV_BYTES(input, prev, n) \
+    _mm256_alignr_epi8((input), _mm256_permute2x128_si256((prev), (input), 0x21), 16 - (n))
+
+ML_AVX2 static size_t valid_prefix_avx2(const unsigned char *data, size_t len) {
+    const __m256i byte_1_high = LOOKUP16(
+        TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+        TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS,
+        TOO_SHORT | OVERLONG_2,
+        TOO_SHORT,
+        TOO_SHORT | OVERLONG_3 | SURROGATE,
+        TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4);
+    const __m256i byte_1_low = LOOKUP16(
+        CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4,
+        CARRY | OVERLONG_2,
+        CARRY,
+        CARRY,
+        CARRY | TOO_LARGE,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000);
+    const __m256i byte_2_high = LOOKUP16(
+        TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+        TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4,
+        TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE,
+        TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+        TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+        TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT);
+    // A block ending in these bytes leaves a sequence open (checked if the
+    // next block is pure ASCII and skips the lookups)
+    const __m256i incomplete_max = _mm256_setr_epi8(
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        (char)(0xF0 - 1), (char)(0xE0 - 1), (char)(0xC0 - 1));
+
+    __m256i prev_input = _mm256_setzero_si256();
+    __m256i prev_incomplete = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32) {
+        __m256i input = _mm256_loadu_si256((const __m256i *)(data + i));
+        __m256i error;
+        if (_mm256_movemask_epi8(input) == 0) {
+            error = prev_incomplete;
+            prev_incomplete = _mm256_setzero_si256();
+        } else {
+            __m256i prev1 = PREV_BYTES(input, prev_input, 1);
+            __m256i special = _mm256_and_si256(
+                _mm256_and_si256(_mm256_shuffle_epi8(byte_1_high, high_nibbles(prev1)),
+                                 _mm256_shuffle_epi8(byte_1_low,
+                                                     _mm256_and_si256(prev1, _mm256_set1_epi8(0x0F)))),
+                _mm256_shuffle_epi8(byte_2_high, high_nibbles(input)));
+
+            // Third and fourth bytes must be continuations, and only they may
+            // be: this is where TWO_CONTS pairs are allowed
+            __m256i third = _mm256_subs_epu8(PREV_BYTES(input, prev_input, 2), _mm256_set1_epi8((char)(0xE0 - 0x80)));
+            __m256i fourth = _mm256_subs_epu8(PREV_BYTES(input, prev_input, 3), _mm256_set1_epi8((char)(0xF0 - 0x80)));
+            __m256i must_23 = _mm256_and_si256(_mm256_or_si256(third, fourth), _mm256_set1_epi8((char)0x80));
+
+            error = _mm256_xor_si256(must_23, special);
+            prev_incomplete = _mm256_subs_epu8(input, incomplete_max);
+        }
+        if (!_mm256_testz_si256(error, error)) {
+            break;  // the scalar decoder pins down the exact position
+        }
+        prev_input = input;
+    }
+    // Finish (or locate the error) from the last boundary before block i
+    return validate_from(data, boundary_before(data, i), len);
+}
+
+static const utf8_kernels AVX2_KERNELS = {"avx2", valid_prefix_avx2};
+
+#endif // ML_UTF8_X86
+
+#if ML_UTF8_NEON
+
+// ============================================================================
+// NEON (ASCII fast path)
+// ============================================================================
+
+static size_t valid_prefix_neon(const unsigned char *data, size_t len) {
+    size_t i = 0;
+    while (i + 16 <= len) {
+        if (vmaxvq_u8(vld1q_u8(data + i)) < 0x80) {
+            i += 16;
+            continue;
+        }
+        while (data[i] < 0x80) {
+            i++;
+        }
+        while (i < len && data[i] >= 0x80) {
+            size_t n = sequence_length(data + i, len - i);
+            if (n == 0) {
+                return i;
+            }
+            i += n;
+        }
+    }
+    return validate_from(data, i, len);
+}
+
+static const utf8_kernels NEON_KERNELS = {"neon", valid_prefix_neon};
+
+#endif // ML_UTF8_NEON
+
+// ============================================================================
+// DISPATCH
+// ============================================================================
+
+static const utf8_kernels *select_kernels(void) {
+    const char *forced = getenv("MULTILANG_SIMD");
+    if (forced != NULL && strcmp(forced, "scalar") == 0) {
+        return &SCALAR_KERNELS;
+    }
+#if ML_UTF8_X86
+    __builtin_cpu_init();
+    int want_sse2 = forced != NULL && strcmp(forced, "sse2") == 0;
+    if (!want_sse2 && __builtin_cpu_supports("avx2")) {
+        return &AVX2_KERNELS;
+    }
+    return &SSE2_KERNELS;
+#elif ML_UTF8_NEON
+    return &NEON_KERNELS;
+#else
+    return &SCALAR_KERNELS;
+#endif
+}
+
+static _Atomic(const utf8_kernels *) active_kernels = NULL;
+
+static const utf8_kernels *kernels(void) {
+    const utf8_kernels *k = atomic_load_explicit(&active_kernels, memory_order_acquire);
+    if (k == NULL) {
+        // Racing threads all compute the same answer, so last store wins harmlessly
+        k = select_kernels();
+        atomic_store_explicit(&active_kernels, k, memory_order_release);
+    }
+    return k;
+}
+
+size_t ml_utf8_valid_prefix(const char *data, size_t len) {
+    return kernels()->valid_prefix((const unsigned char *)data, len);
+}
+
+int ml_utf8_validate(const char *data, size_t len) {
+    return ml_utf8_valid_prefix(data, len) == len;
+}
+
+size_t ml_utf8_truncate(const char *data, size_t len, size_t max) {
+    if (len <= max) {
+        return len;
+    }
+    const unsigned char *s = (const unsigned char *)data;
+    if ((s[max] & 0xC0) != 0x80) {
+        return max;  // s[max] starts a character: cutting there is safe
+    }
+    // s[max] continues a character: drop that whole character
+    size_t j = max;
+    while (j > 0 && max - j < 3 && (s[j - 1] & 0xC0) == 0x80) {
+        j--;
+    }
+    if (j > 0 && s[j - 1] >= 0xC0) {
+        return j - 1;
+    }
+    return max;  // stray continuation bytes: nothing to keep together
+}
+
+/**
+ * @return Bytes covered by one U+FFFD: the maximal prefix of a well-formed
+ *         sequence at s[0] (at least 1)
+ */
+static size_t maximal_subpart(const unsigned char *s, size_t len) {
+    unsigned char lo;
+    unsigned char hi;
+    size_t n = lead_info(s[0], &lo, &hi);
+    if (n == 0 || len < 2 || s[1] < lo || s[1] > hi) {
+        return 1;
+    }
+    size_t k = 2;
+    while (k < n && k < len && (s[k] & 0xC0) == 0x80) {
+        k++;
+    }
+    return k;
+}
+
+size_t ml_utf8_repair(const char *data, size_t len, char *out, size_t cap) {
+    const unsigned char *s = (const unsigned char *)data;
+    size_t in = 0;
+    size_t written = 0;
+    while (in < len) {
+        size_t valid = ml_utf8_valid_prefix(data + in, len - in);
+        if (valid > cap - written) {
+            valid = ml_utf8_truncate(data + in, valid, cap - written);
+            memcpy(out + written, data + in, valid);
+            return written + valid;
+        }
+        memcpy(out + written, data + in, valid);
+        written += valid;
+        in += valid;
+        if (in == len) {
+            break;
+        }
+
+        if (cap - written < sizeof(ML_UTF8_REPLACEMENT) - 1) {
+            break;
+        }
+        memcpy(out + written, ML_UTF8_REPLACEMENT, sizeof(ML_UTF8_REPLACEMENT) - 1);
+        written += sizeof(ML_UTF8_REPLACEMENT) - 1;
+        in += maximal_subpart(s + in, len - in);
+    }
+    return written;
+}
+
+const char *ml_utf8_kernel_name(void) {
+    return kernels()->name;
+}
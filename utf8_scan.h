@@ -0,0 +1,63 @@
+#ifndef MULTILANG_UTF8_SCAN_H
+#define MULTILANG_UTF8_SCAN_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ============================================================================
+// VECTORIZED UTF-8 VALIDATION AND TRUNCATION (C ABI, shared by C, C++ and Rust)
+// ============================================================================
+// Names are bytes on the way in; these routines decide once, at memory
+// bandwidth, whether they are well-formed UTF-8 (RFC 3629: no overlongs, no
+// surrogates, nothing above U+10FFFF), so consumers of the streaming paths
+// do not have to validate again.
+//
+// The validator is picked at runtime like the line_scan.h kernels and obeys
+// the same MULTILANG_SIMD override: a lookup-table kernel (Keiser & Lemire,
+// "Validating UTF-8 In Less Than One Instruction Per Byte") on AVX2 CPUs,
+// and an ASCII fast path with a scalar decoder for the rest on SSE2, NEON
+// and plain C.
+
+#define ML_UTF8_REPLACEMENT "\xEF\xBF\xBD"  // U+FFFD, written by ml_utf8_repair()
+
+/**
+ * @return Length of the longest well-formed prefix of data[0, len); equals
+ *         `len` when the whole input is valid
+ */
+size_t ml_utf8_valid_prefix(const char *data, size_t len);
+
+/**
+ * @return Non-zero if data[0, len) is well-formed UTF-8
+ */
+int ml_utf8_validate(const char *data, size_t len);
+
+/**
+ * Finds where to cut data[0, len) so it fits in `max` bytes without
+ * splitting a multi-byte sequence
+ *
+ * @return `len` if it already fits, otherwise the largest boundary <= `max`
+ */
+size_t ml_utf8_truncate(const char *data, size_t len, size_t max);
+
+/**
+ * Copies data[0, len) to `out`, replacing every ill-formed subsequence with
+ * U+FFFD (the W3C/WHATWG "maximal subpart" rule). Stops before a character
+ * that does not fit in `cap` bytes, so the output is always valid.
+ *
+ * @return Bytes written to `out` (not null-terminated)
+ */
+size_t ml_utf8_repair(const char *data, size_t len, char *out, size_t cap);
+
+/**
+ * @return Name of the active validator ("avx2", "sse2", "neon" or "scalar")
+ */
+const char *ml_utf8_kernel_name(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //MULTILANG_UTF8_SCAN_H